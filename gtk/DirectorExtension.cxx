@@ -29,6 +29,15 @@
  ** get sent back to the specified, existing pipename <my pipe>. For example,
  ** ':/tmp/mypipe:askproperty:SciteDefaultHome' will make SciTE write the value of
  ** the standard property 'SciteDefaultHome' to the pipe /tmp/mypipe.
+ **
+ ** For clients that send many commands, a Unix domain socket /tmp/SciTE.<pid>.sock
+ ** (or ipc.scite.socket if defined) accepts persistent connections. Each request is
+ ** a frame: a 4 byte little-endian payload length, a 4 byte little-endian request id
+ ** chosen by the client, then the payload which is one or more commands separated by
+ ** '\n'. Each request is answered by one frame with the same id holding any results,
+ ** such as from askproperty, separated by '\n'. Notifications caused by a request, such
+ ** as opened: after open:, are not results. They go to the notify pipes and to each
+ ** connection that sent register: as frames with id 0.
  **/
 // Copyright 1998-2001 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
@@ -38,6 +47,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <errno.h>
+#include <stdint.h>
 
 #include <string>
 #include <vector>
@@ -49,6 +59,8 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include <gtk/gtk.h>
 
@@ -104,6 +116,31 @@ struct PipeEntry {
 static PipeEntry s_send_pipes[MAX_PIPES];
 static int s_send_cnt = 0;
 
+// A connection to the director socket
+struct SocketClient {
+	int fd = -1;
+	GIOChannel *channel = nullptr;
+	guint inputWatcher = 0;
+	guint outputWatcher = 0;
+	std::string input;
+	std::string output;
+	bool notify = false;
+};
+
+// Frame header is payload length then request id, each 4 bytes little-endian
+const size_t frameHeaderSize = 8;
+// Connections sending larger frames are dropped
+const size_t frameMaximum = 0x4000000;
+
+static int fdListener = -1;
+static GIOChannel *listenerChannel = nullptr;
+static guint listenerWatcher = 0;
+static char socketName[TMP_FILENAME_LENGTH];
+static std::vector<std::unique_ptr<SocketClient>> socketClients;
+// While performing a request from a socket, results are gathered here
+static SocketClient *replyClient = nullptr;
+static std::string replyText;
+
 static bool SendPipeAvailable() {
 	return s_send_cnt < MAX_PIPES-1;
 }
@@ -139,20 +176,115 @@ static int OpenPipe(const char *pipeName) {
 	return fd;
 }
 
+static void CloseSocketClient(SocketClient *client) {
+	if (client == replyClient)
+		replyClient = nullptr;
+	if (client->inputWatcher)
+		g_source_remove(client->inputWatcher);
+	if (client->outputWatcher)
+		g_source_remove(client->outputWatcher);
+	g_io_channel_unref(client->channel);
+	close(client->fd);
+	for (auto it = socketClients.begin(); it != socketClients.end(); ++it) {
+		if (it->get() == client) {
+			socketClients.erase(it);
+			break;
+		}
+	}
+}
+
+static gboolean SocketOutputSignal(GIOChannel *source, GIOCondition condition, void *data);
+
+// Returns false if the connection failed and was closed
+static bool SocketWrite(SocketClient *client) {
+	while (!client->output.empty()) {
+		const ssize_t written = write(client->fd, client->output.data(), client->output.size());
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			CloseSocketClient(client);
+			return false;
+		}
+		client->output.erase(0, written);
+	}
+	if (client->output.empty()) {
+		if (client->outputWatcher) {
+			g_source_remove(client->outputWatcher);
+			client->outputWatcher = 0;
+		}
+	} else if (!client->outputWatcher) {
+		// Finish when the client has read enough to make room
+		client->outputWatcher = g_io_add_watch(client->channel, G_IO_OUT, SocketOutputSignal, client);
+	}
+	return true;
+}
+
+static gboolean SocketOutputSignal(GIOChannel *, GIOCondition, void *data) {
+	SocketClient *client = static_cast<SocketClient *>(data);
+	client->outputWatcher = 0;
+	SocketWrite(client);
+	// SocketWrite adds a new watch if needed
+	return FALSE;
+}
+
+static void AppendUInt32(std::string &s, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		s.push_back(static_cast<char>(value & 0xff));
+		value >>= 8;
+	}
+}
+
+static uint32_t UInt32At(const std::string &s, size_t offset) {
+	uint32_t value = 0;
+	for (int i = 3; i >= 0; i--) {
+		value = (value << 8) | static_cast<unsigned char>(s[offset + i]);
+	}
+	return value;
+}
+
+static bool SendFrame(SocketClient *client, uint32_t id, const std::string &payload) {
+	AppendUInt32(client->output, static_cast<uint32_t>(payload.length()));
+	AppendUInt32(client->output, id);
+	client->output.append(payload);
+	return SocketWrite(client);
+}
+
+static bool SocketNotifying() {
+	for (const std::unique_ptr<SocketClient> &client : socketClients) {
+		if (client->notify)
+			return true;
+	}
+	return false;
+}
+
+static void SendSocketNotification(const std::string &notification) {
+	std::vector<SocketClient *> notified;
+	for (const std::unique_ptr<SocketClient> &client : socketClients) {
+		if (client->notify)
+			notified.push_back(client.get());
+	}
+	// SendFrame may close failed connections
+	for (SocketClient *client : notified) {
+		SendFrame(client, 0, notification);
+	}
+}
+
 // we now send notifications to _all_ the notification pipes registered!
-static bool SendPipeCommand(const char *pipeCommand) {
+static bool SendPipeCommand(const std::string &pipeCommand) {
 	int size;
 	if (fdCorrespondent) {
-		size = write(fdCorrespondent,pipeCommand,strlen(pipeCommand));
+		size = write(fdCorrespondent, pipeCommand.data(), pipeCommand.length());
 		size += write(fdCorrespondent,"\n",1);
-		IF_DEBUG(fprintf(fdDebug, "Send correspondent: %s %d bytes to %d\n", pipeCommand, size,fdCorrespondent))
+		IF_DEBUG(fprintf(fdDebug, "Send correspondent: %s %d bytes to %d\n", pipeCommand.c_str(), size,fdCorrespondent))
 	} else {
 		for (int i = 0; i < s_send_cnt; ++i) {
 			int fd = s_send_pipes[i].fd;
 			// put a linefeed after the notification!
-			size = write(fd, pipeCommand, strlen(pipeCommand));
+			size = write(fd, pipeCommand.data(), pipeCommand.length());
 			size += write(fd,"\n",1);
-			IF_DEBUG(fprintf(fdDebug, "Send pipecommand: %s %d bytes to %d\n", pipeCommand, size,fd))
+			IF_DEBUG(fprintf(fdDebug, "Send pipecommand: %s %d bytes to %d\n", pipeCommand.c_str(), size,fd))
 		}
 	}
 	(void)size; // to keep compiler happy if we aren't debugging...
@@ -186,21 +318,178 @@ static gboolean ReceiverPipeSignal(GIOChannel *source, GIOCondition condition, v
 	return TRUE;
 }
 
-static void SendDirector(const char *verb, const char *arg = 0) {
+// A reply answers the request being handled, such as askproperty, and goes back to
+// the socket connection that sent it. Other messages are notifications for every director.
+static void SendDirector(const char *verb, const char *arg = 0, bool reply = false) {
 	IF_DEBUG(fprintf(fdDebug, "SendDirector:(%s, %s):  fdDirector = %d\n", verb, arg, fdDirector))
-	if (s_send_cnt) {
+	const bool replying = reply && replyClient;
+	if (s_send_cnt || replying || SocketNotifying()) {
 		std::string addressedMessage;
 		addressedMessage += verb;
 		addressedMessage += ":";
 		if (arg)
 			addressedMessage += arg;
+		if (replying) {
+			if (!replyText.empty())
+				replyText += "\n";
+			replyText += addressedMessage;
+			return;
+		}
 		//send the message through all the registered pipes
-		::SendPipeCommand(addressedMessage.c_str());
+		if (s_send_cnt)
+			::SendPipeCommand(addressedMessage);
+		SendSocketNotification(addressedMessage);
 	} else {
 		IF_DEBUG(fprintf(fdDebug, "SendDirector: no notify pipes\n"))
 	}
 }
 
+static gboolean SocketInputSignal(GIOChannel *, GIOCondition condition, void *data) {
+	SocketClient *client = static_cast<SocketClient *>(data);
+#ifndef GDK_VERSION_3_6
+	gdk_threads_enter();
+#endif
+	bool open = true;
+	if (condition & G_IO_IN) {
+		char buffer[8192];
+		for (;;) {
+			const ssize_t lenRead = read(client->fd, buffer, sizeof(buffer));
+			if (lenRead > 0) {
+				client->input.append(buffer, lenRead);
+			} else if (lenRead < 0 && errno == EINTR) {
+				continue;
+			} else {
+				open = (lenRead < 0) && (errno == EAGAIN || errno == EWOULDBLOCK);
+				break;
+			}
+		}
+	} else {
+		// Hang up or error
+		open = false;
+	}
+	size_t start = 0;
+	while (open && (client->input.length() - start >= frameHeaderSize)) {
+		const size_t lenPayload = UInt32At(client->input, start);
+		if (lenPayload > frameMaximum) {
+			fprintf(stderr, "SciTE Director: request too large\n");
+			open = false;
+			break;
+		}
+		if (client->input.length() - start < frameHeaderSize + lenPayload)
+			break;
+		const uint32_t id = UInt32At(client->input, start + 4);
+		const std::string payload = client->input.substr(start + frameHeaderSize, lenPayload);
+		start += frameHeaderSize + lenPayload;
+		replyClient = client;
+		replyText.clear();
+		DirectorExtension::Instance().HandleStringMessage(payload.c_str());
+		// The client is closed if its connection failed while handling
+		open = replyClient == client;
+		replyClient = nullptr;
+		if (open)
+			open = SendFrame(client, id, replyText);
+		replyText.clear();
+		if (!open)
+			client = nullptr;
+	}
+	if (client) {
+		if (open) {
+			client->input.erase(0, start);
+		} else {
+			// Returning FALSE removes this watch
+			client->inputWatcher = 0;
+			CloseSocketClient(client);
+		}
+	}
+#ifndef GDK_VERSION_3_6
+	gdk_threads_leave();
+#endif
+	return open ? TRUE : FALSE;
+}
+
+static gboolean SocketAcceptSignal(GIOChannel *, GIOCondition, void *) {
+	const int fd = accept(fdListener, nullptr, nullptr);
+	if (fd >= 0) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+		std::unique_ptr<SocketClient> client = std::make_unique<SocketClient>();
+		client->fd = fd;
+		client->channel = g_io_channel_unix_new(fd);
+		client->inputWatcher = g_io_add_watch(client->channel,
+			static_cast<GIOCondition>(G_IO_IN | G_IO_HUP | G_IO_ERR), SocketInputSignal, client.get());
+		socketClients.push_back(std::move(client));
+	}
+	return TRUE;
+}
+
+static void CreateSocket(ExtensionAPI *host) {
+	std::string name = host->Property("ipc.scite.socket");
+	if (name.empty()) {
+		snprintf(socketName, sizeof(socketName), "%s/SciTE.%d.sock", g_get_tmp_dir(), getpid());
+		name = socketName;
+	} else {
+		StringCopy(socketName, name.c_str());
+	}
+	struct sockaddr_un address {};
+	address.sun_family = AF_UNIX;
+	if (name.length() >= sizeof(address.sun_path)) {
+		fprintf(stderr, "SciTE Director: socket name too long '%s'\n", name.c_str());
+		socketName[0] = '\0';
+		return;
+	}
+	StringCopy(address.sun_path, name.c_str());
+	fdListener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fdListener < 0) {
+		socketName[0] = '\0';
+		return;
+	}
+	fcntl(fdListener, F_SETFD, FD_CLOEXEC);
+	// Only the user may connect
+	const mode_t umaskOld = umask(S_IRWXG | S_IRWXO);
+	int bound = bind(fdListener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+	if ((bound < 0) && (errno == EADDRINUSE)) {
+		// Replace the socket if it was left by an instance that crashed: it is a socket
+		// that refuses connections. Any other file is left alone.
+		struct stat statusFile;
+		const int fdProbe = socket(AF_UNIX, SOCK_STREAM, 0);
+		if ((fdProbe >= 0) && (lstat(socketName, &statusFile) == 0) && S_ISSOCK(statusFile.st_mode) &&
+			(connect(fdProbe, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0) &&
+			(errno == ECONNREFUSED)) {
+			unlink(socketName);
+			bound = bind(fdListener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+		}
+		if (fdProbe >= 0)
+			close(fdProbe);
+	}
+	umask(umaskOld);
+	if ((bound < 0) || (listen(fdListener, 8) < 0)) {
+		perror("CreateSocket: could not listen on ipc.scite.socket");
+		close(fdListener);
+		fdListener = -1;
+		socketName[0] = '\0';
+		return;
+	}
+	listenerChannel = g_io_channel_unix_new(fdListener);
+	listenerWatcher = g_io_add_watch(listenerChannel, G_IO_IN, SocketAcceptSignal, nullptr);
+	host->SetProperty("ipc.scite.socket", socketName);
+}
+
+static void CloseSockets() {
+	while (!socketClients.empty()) {
+		CloseSocketClient(socketClients.back().get());
+	}
+	if (fdListener >= 0) {
+		g_source_remove(listenerWatcher);
+		listenerWatcher = 0;
+		g_io_channel_unref(listenerChannel);
+		listenerChannel = nullptr;
+		close(fdListener);
+		fdListener = -1;
+		remove(socketName);
+		socketName[0] = '\0';
+	}
+}
+
 static bool not_empty(const char *s) {
 	return s && *s;
 }
@@ -230,6 +519,7 @@ bool DirectorExtension::Initialise(ExtensionAPI *host_) {
 	// always try to create the receive (request) pipe, even if not started by
 	// an external director
 	CreatePipe();
+	CreateSocket(host);
 	IF_DEBUG(fprintf(fdDebug, "Initialise: fdReceiver: %d\n", fdReceiver))
 	// but do crash out if we failed and were started by an external director.
 	if (!fdReceiver && startedByDirector) {
@@ -242,6 +532,7 @@ bool DirectorExtension::Finalise() {
 	::SendDirector("closing");
 	// close and remove all the notification pipes (except ipc.director.name)
 	RemoveSendPipes();
+	CloseSockets();
 	// close our request pipe
 	if (fdReceiver != 0) {
 		close(fdReceiver);
@@ -303,7 +594,11 @@ bool DirectorExtension::OnClose(const char *path) {
 
 bool DirectorExtension::NeedsOnClose() {
 	CheckEnvironment(host);
-	return s_send_cnt > 0;
+	return s_send_cnt > 0 || SocketNotifying();
+}
+
+const char *DirectorExtension::Name() const {
+	return "Director";
 }
 
 bool DirectorExtension::OnChar(char) {
@@ -343,14 +638,17 @@ bool DirectorExtension::OnMarginClick() {
 }
 
 bool DirectorExtension::OnMacro(const char *command, const char *params) {
-	SendDirector(command, params);
+	// Macro recording and running are notifications, other verbs answer an ask command
+	const bool notification = isprefix(command, "macro:record") || isprefix(command, "macro:stoprecord") ||
+		isprefix(command, "macro:getlist") || isprefix(command, "macro:run");
+	SendDirector(command, params, !notification);
 	return false;
 }
 
 bool DirectorExtension::SendProperty(const char *prop) {
 	CheckEnvironment(host);
 	if (not_empty(prop)) {
-		::SendDirector("property", prop);
+		::SendDirector("property", prop, true);
 	}
 	return false;
 }
@@ -381,6 +679,9 @@ void DirectorExtension::HandleStringMessage(const char *message) {
 				host->ShutDown();
 				shuttingDown = false;
 			}
+		} else if (isprefix(cmd, "register:") && replyClient) {
+			// a socket connection receives notifications itself
+			replyClient->notify = true;
 		} else if (isprefix(cmd, "register:")) {
 			// we handle this verb specially - an extension has asked us for a notify
 			// pipe which it can listen to.  We make up a unique name based on our
@@ -497,7 +497,7 @@ protected:
 	// Control of sub process
 	FilePath sciteExecutable;
 	int icmd;
-	int originalEnd;
+	sptr_t originalEnd;	///< Output offset at start of command
 	int fdFIFO;
 	GPid pidShell;
 	bool triedKill;
@@ -569,6 +569,7 @@ protected:
 	void TimerEnd(int mask) override;
 	static gboolean IdlerTick(gpointer pSciTE);
 	void SetIdler(bool on) override;
+	void OutputAppendStringSynchronised(const char *s, int len = -1) override;
 
 	void GetWindowPosition(int *left, int *top, int *width, int *height, int *maximize) override;
 
@@ -1238,6 +1239,12 @@ void SciTEGTK::SetIdler(bool on) {
 	}
 }
 
+void SciTEGTK::OutputAppendStringSynchronised(const char *s, int len) {
+	// Always called on the main thread so add gathered text first to keep output in order
+	OutputFlush();
+	SciTEBase::OutputAppendStringSynchronised(s, len);
+}
+
 void SciTEGTK::GetWindowPosition(int *left, int *top, int *width, int *height, int *maximize) {
 	gtk_window_get_position(GTK_WINDOW(PWidget(wSciTE)), left, top);
 	gtk_window_get_size(GTK_WINDOW(PWidget(wSciTE)), width, height);
@@ -1662,8 +1669,8 @@ void SciTEGTK::LoadSessionDialog() {
 		if (gtk_dialog_run(GTK_DIALOG(dlg)) == GTK_RESPONSE_ACCEPT) {
 			char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dlg));
 
-			LoadSessionFile(filename);
-			RestoreSession();
+			if (LoadSessionFile(filename))
+				RestoreSession();
 			g_free(filename);
 		}
 		gtk_widget_destroy(dlg);
@@ -2583,10 +2590,11 @@ void SciTEGTK::ContinueExecute(int fromPoll) {
 		}
 		sExitMessage.append("\n");
 		OutputAppendString(sExitMessage.c_str());
+		OutputFlush();
 		// Move selection back to beginning of this run so that F4 will go
 		// to first error of this run.
 		if ((scrollOutput == 1) && returnOutputToCommand)
-			wOutput.Send(SCI_GOTOPOS, originalEnd);
+			wOutput.Send(SCI_GOTOPOS, OutputPositionFromOffset(originalEnd));
 		returnOutputToCommand = true;
 		g_source_remove(inputHandle);
 		inputHandle = 0;
@@ -2677,9 +2685,10 @@ void SciTEGTK::Execute() {
 	SciTEBase::Execute();
 
 	commandTime.Duration(true);
+	OutputFlush();
 	if (scrollOutput)
 		wOutput.Send(SCI_GOTOPOS, wOutput.Send(SCI_GETTEXTLENGTH));
-	originalEnd = wOutput.Send(SCI_GETCURRENTPOS);
+	originalEnd = OutputOffsetFromPosition(wOutput.Send(SCI_GETCURRENTPOS));
 
 	lastOutput = "";
 	lastFlags = jobQueue.jobQueue[icmd].flags;
@@ -3974,6 +3983,7 @@ void SciTEGTK::CreateMenu() {
 	            {"/Options/_Wrap", "", menuSig, IDM_WRAP, "<CheckItem>"},
 	            {"/Options/Wrap Out_put", "", menuSig, IDM_WRAPOUTPUT, "<CheckItem>"},
 	            {"/Options/_Read-Only", "", menuSig, IDM_READONLY, "<CheckItem>"},
+	            {"/Options/Use All _Features", "", menuSig, IDM_ALLFEATURES, 0},
 	            {"/Options/sep1", NULL, NULL, 0, "<Separator>"},
 	            {"/Options/_Line End Characters", "", 0, 0, "<Branch>"},
 	            {"/Options/Line End Characters/CR _+ LF", "", menuSig, IDM_EOL_CRLF, "<RadioItem>"},
@@ -213,6 +213,18 @@ FilePath.o: \
 	../src/GUI.h \
 	../src/ScintillaWindow.h \
 	../src/FilePath.h
+FileWatcher.o: \
+	../src/FileWatcher.cxx \
+	../../scintilla/include/ILoader.h \
+	../../scintilla/include/Sci_Position.h \
+	../../scintilla/include/Scintilla.h \
+	../src/GUI.h \
+	../src/FilePath.h \
+	../src/Mutex.h \
+	../src/Cookie.h \
+	../src/Worker.h \
+	../src/FileWorker.h \
+	../src/FileWatcher.h
 FileWorker.o: \
 	../src/FileWorker.cxx \
 	../../scintilla/include/ILoader.h \
@@ -242,14 +254,19 @@ JobQueue.o: \
 	../src/JobQueue.h
 LuaExtension.o: \
 	../src/LuaExtension.cxx \
-	../../scintilla/include/Scintilla.h \
+	../../scintilla/include/ILoader.h \
 	../../scintilla/include/Sci_Position.h \
+	../../scintilla/include/Scintilla.h \
 	../src/GUI.h \
 	../src/ScintillaWindow.h \
 	../src/StringHelpers.h \
 	../src/FilePath.h \
 	../src/StyleWriter.h \
 	../src/Extender.h \
+	../src/Mutex.h \
+	../src/Cookie.h \
+	../src/Worker.h \
+	../src/FileWorker.h \
 	../src/IFaceTable.h \
 	../src/SciTEKeys.h \
 	../src/LuaExtension.h \
@@ -269,6 +286,8 @@ MultiplexExtension.o: \
 	../../scintilla/include/Scintilla.h \
 	../../scintilla/include/Sci_Position.h \
 	../src/GUI.h \
+	../src/StringHelpers.h \
+	../src/FilePath.h \
 	../src/MultiplexExtension.h \
 	../src/Extender.h
 PropSetFile.o: \
@@ -306,6 +325,7 @@ SciTEBase.o: \
 	../src/Cookie.h \
 	../src/Worker.h \
 	../src/FileWorker.h \
+	../src/FileWatcher.h \
 	../src/MatchMarker.h \
 	../src/EditorConfig.h \
 	../src/SciTEBase.h
@@ -352,7 +372,9 @@ SciTEIO.o: \
 	../src/Cookie.h \
 	../src/Worker.h \
 	../src/FileWorker.h \
+	../src/FileWatcher.h \
 	../src/MatchMarker.h \
+	../src/EditorConfig.h \
 	../src/SciTEBase.h \
 	../src/Utf8_16.h
 SciTEProps.o: \
@@ -176,6 +176,88 @@ properties - a sorted list of (name, property), where property is a
 	return (constants, funclist, proplist)
 
 
+# Perfect hashing with hash and displace: each key first picks a bucket with seed 0,
+# then the bucket's seed places its keys in distinct slots. Must match IFaceHash in IFaceTable.cxx.
+
+def HashName(name, seed):
+	h = (2166136261 ^ seed) & 0xFFFFFFFF
+	for ch in name:
+		h ^= ord(ch)
+		h = (h * 16777619) & 0xFFFFFFFF
+	return h
+
+def HashValue(value, seed):
+	h = (value ^ seed) & 0xFFFFFFFF
+	h ^= h >> 16
+	h = (h * 0x45d9f3b) & 0xFFFFFFFF
+	h ^= h >> 16
+	h = (h * 0x45d9f3b) & 0xFFFFFFFF
+	h ^= h >> 16
+	return h
+
+def PowerOfTwoAtLeast(n):
+	p = 1
+	while p < n:
+		p *= 2
+	return p
+
+def PerfectHash(keys, hashFunction):
+	"""keys is a list of (key, index) tuples with distinct keys.
+	Returns (seeds, slots) where slots holds the index for each key or -1."""
+	slotCount = PowerOfTwoAtLeast(len(keys) + len(keys) // 4)
+	bucketCount = max(1, slotCount // 4)
+	buckets = [[] for b in range(bucketCount)]
+	for key, index in keys:
+		buckets[hashFunction(key, 0) & (bucketCount - 1)].append((key, index))
+	seeds = [0] * bucketCount
+	slots = [-1] * slotCount
+	for b in sorted(range(bucketCount), key=lambda b: -len(buckets[b])):
+		if not buckets[b]:
+			break
+		for seed in range(1, 0x10000):
+			placed = [hashFunction(key, seed) & (slotCount - 1) for key, index in buckets[b]]
+			if len(set(placed)) == len(placed) and all(slots[s] == -1 for s in placed):
+				for s, (key, index) in zip(placed, buckets[b]):
+					slots[s] = index
+				seeds[b] = seed
+				break
+		else:
+			raise ValueError("No perfect hash seed found")
+	return seeds, slots
+
+def printHashTable(out, name, keys, hashFunction):
+	seeds, slots = PerfectHash(keys, hashFunction)
+	out.append("static const unsigned short iface%sSeeds[] = {" % name)
+	for i in range(0, len(seeds), 16):
+		out.append("\t" + ",".join(str(s) for s in seeds[i:i+16]) + ",")
+	out.append("};")
+	out.append("")
+	out.append("static const short iface%sSlots[] = {" % name)
+	for i in range(0, len(slots), 16):
+		out.append("\t" + ",".join(str(s) for s in slots[i:i+16]) + ",")
+	out.append("};")
+	out.append("")
+
+def printIFaceTableHashes(constants, functions, properties):
+	out = []
+	printHashTable(out, "ConstantName",
+		[(name, i) for i, (name, features) in enumerate(constants)], HashName)
+	printHashTable(out, "FunctionName",
+		[(name, i) for i, (name, features) in enumerate(functions)], HashName)
+	printHashTable(out, "PropertyName",
+		[(name, i) for i, (name, property) in enumerate(properties)], HashName)
+	values = {}
+	for i, (name, features) in enumerate(functions):
+		values.setdefault(int(features["Value"], 0), i)
+	printHashTable(out, "FunctionValue", list(values.items()), HashValue)
+	values = {}
+	for i, (name, property) in enumerate(properties):
+		for value in (property["GetterValue"], property["SetterValue"]):
+			if int(str(value), 0):
+				values.setdefault(int(str(value), 0), i)
+	printHashTable(out, "PropertyValue", list(values.items()), HashValue)
+	return out
+
 def printIFaceTableCXXFile(faceAndIDs):
 	out = []
 	f, ids = faceAndIDs
@@ -257,6 +339,7 @@ def printIFaceTableCXXFile(faceAndIDs):
 	out.append("\tifacePropertyCount = %d" % len(properties))
 	out.append("};")
 	out.append("")
+	out.extend(printIFaceTableHashes(constants, functions, properties))
 	return out
 
 def convertStringResult(s):
@@ -0,0 +1,371 @@
+// Utf8_16Bench.cxx - time the UTF-16 conversions of Utf8_16.cxx against the byte at a time
+// iterators they replaced, converting in blocks of the size used by FileWorker.
+// Both are checked to produce the same output.
+// Build and run from the scite/scripts directory:
+//   g++ -O2 -std=c++17 -I../src Utf8_16Bench.cxx ../src/Utf8_16.cxx -o Utf8_16Bench
+//   ./Utf8_16Bench [file]
+// Without a file, a mostly ASCII document with some accented, CJK and emoji text is generated.
+// With MSVC: cl /O2 /EHsc /std:c++17 /I..\src Utf8_16Bench.cxx ..\src\Utf8_16.cxx
+
+#include <cstring>
+#include <cstdio>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include "Utf8_16.h"
+
+namespace {
+
+const size_t blockSize = 131072;
+
+#if defined(_WIN32)
+const char *nullDevice = "NUL";
+#else
+const char *nullDevice = "/dev/null";
+#endif
+const char *tempPath = "Utf8_16Bench.tmp";
+
+enum { SURROGATE_LEAD_FIRST = 0xD800 };
+enum { SURROGATE_LEAD_LAST = 0xDBFF };
+enum { SURROGATE_TRAIL_FIRST = 0xDC00 };
+enum { SURROGATE_FIRST_VALUE = 0x10000 };
+
+// The iterators as they were before the block converters, reduced to what the conversions used.
+
+class Utf16_Iter : public Utf8_16 {
+public:
+	void set(const ubyte* pBuf, size_t nLen, encodingType eEncoding, ubyte *endSurrogate) {
+		m_pRead = pBuf;
+		m_pEnd = pBuf + nLen;
+		m_eEncoding = eEncoding;
+		if (nLen > 2) {
+			const utf16 lastElement = read(m_pEnd-2);
+			if (lastElement >= SURROGATE_LEAD_FIRST && lastElement <= SURROGATE_LEAD_LAST) {
+				endSurrogate[0] = m_pEnd[-2];
+				endSurrogate[1] = m_pEnd[-1];
+				m_pEnd -= 2;
+			}
+		}
+		operator++();
+	}
+	utf8 get() const {
+		return m_nCur;
+	}
+	operator bool() const { return m_pRead <= m_pEnd; }
+	void operator++() {
+		switch (m_eState) {
+		case eStart:
+			if (m_pRead >= m_pEnd) {
+				++m_pRead;
+				break;
+			}
+			if (m_eEncoding == eUtf16LittleEndian) {
+				m_nCur16 = *m_pRead++;
+				m_nCur16 |= static_cast<utf16>(*m_pRead << 8);
+			} else {
+				m_nCur16 = static_cast<utf16>(*m_pRead++ << 8);
+				m_nCur16 |= *m_pRead;
+			}
+			if (m_nCur16 >= SURROGATE_LEAD_FIRST && m_nCur16 <= SURROGATE_LEAD_LAST) {
+				++m_pRead;
+				if (m_pRead >= m_pEnd) {
+					--m_pRead;
+				} else {
+					int trail;
+					if (m_eEncoding == eUtf16LittleEndian) {
+						trail = *m_pRead++;
+						trail |= static_cast<utf16>(*m_pRead << 8);
+					} else {
+						trail = static_cast<utf16>(*m_pRead++ << 8);
+						trail |= *m_pRead;
+					}
+					m_nCur16 = (((m_nCur16 & 0x3ff) << 10) | (trail & 0x3ff)) + SURROGATE_FIRST_VALUE;
+				}
+			}
+			++m_pRead;
+			if (m_nCur16 < 0x80) {
+				m_nCur = static_cast<ubyte>(m_nCur16 & 0xFF);
+				m_eState = eStart;
+			} else if (m_nCur16 < 0x800) {
+				m_nCur = static_cast<ubyte>(0xC0 | m_nCur16 >> 6);
+				m_eState = eFinal;
+			} else if (m_nCur16 < SURROGATE_FIRST_VALUE) {
+				m_nCur = static_cast<ubyte>(0xE0 | m_nCur16 >> 12);
+				m_eState = ePenultimate;
+			} else {
+				m_nCur = static_cast<ubyte>(0xF0 | m_nCur16 >> 18);
+				m_eState = eSecondOf4Bytes;
+			}
+			break;
+		case eSecondOf4Bytes:
+			m_nCur = static_cast<ubyte>(0x80 | ((m_nCur16 >> 12) & 0x3F));
+			m_eState = ePenultimate;
+			break;
+		case ePenultimate:
+			m_nCur = static_cast<ubyte>(0x80 | ((m_nCur16 >> 6) & 0x3F));
+			m_eState = eFinal;
+			break;
+		case eFinal:
+			m_nCur = static_cast<ubyte>(0x80 | (m_nCur16 & 0x3F));
+			m_eState = eStart;
+			break;
+		}
+	}
+private:
+	utf16 read(const ubyte* pRead) const {
+		if (m_eEncoding == eUtf16LittleEndian)
+			return pRead[0] | static_cast<utf16>(pRead[1] << 8);
+		else
+			return pRead[1] | static_cast<utf16>(pRead[0] << 8);
+	}
+	enum eState { eStart, eSecondOf4Bytes, ePenultimate, eFinal };
+	encodingType m_eEncoding = eUnknown;
+	eState m_eState = eStart;
+	utf8 m_nCur = 0;
+	int m_nCur16 = 0;
+	const ubyte* m_pRead = nullptr;
+	const ubyte* m_pEnd = nullptr;
+};
+
+class Utf8_Iter : public Utf8_16 {
+public:
+	void set(const ubyte* pBuf, size_t nLen) {
+		m_pRead = pBuf;
+		m_pEnd = pBuf + nLen;
+		operator++();
+	}
+	int get() const {
+		return m_nCur;
+	}
+	bool canGet() const { return m_eState == eStart; }
+	operator bool() const { return m_pRead <= m_pEnd; }
+	void operator++() {
+		switch (m_eState) {
+		case eStart:
+			if ((0xF0 & *m_pRead) == 0xF0) {
+				m_nCur = (0x7 & *m_pRead) << 18;
+				m_eState = eSecondOf4Bytes;
+			} else if ((0xE0 & *m_pRead) == 0xE0) {
+				m_nCur = (~0xE0 & *m_pRead) << 12;
+				m_eState = ePenultimate;
+			} else if ((0xC0 & *m_pRead) == 0xC0) {
+				m_nCur = (~0xC0 & *m_pRead) << 6;
+				m_eState = eFinal;
+			} else {
+				m_nCur = *m_pRead;
+				m_eState = eStart;
+			}
+			break;
+		case eSecondOf4Bytes:
+			m_nCur |= (0x3F & *m_pRead) << 12;
+			m_eState = ePenultimate;
+			break;
+		case ePenultimate:
+			m_nCur |= (0x3F & *m_pRead) << 6;
+			m_eState = eFinal;
+			break;
+		case eFinal:
+			m_nCur |= static_cast<utf8>(0x3F & *m_pRead);
+			m_eState = eStart;
+			break;
+		}
+		++m_pRead;
+	}
+private:
+	enum eState { eStart, eSecondOf4Bytes, ePenultimate, eFinal };
+	eState m_eState = eStart;
+	int m_nCur = 0;
+	const ubyte* m_pRead = nullptr;
+	const ubyte* m_pEnd = nullptr;
+};
+
+int swapped(int v) {
+	return ((v & 0xFF) << 8) + (v >> 8);
+}
+
+// Read UTF-16 with a BOM in blocks as Utf8_16_Read did with Utf16_Iter
+void OldRead(const std::string &file, std::string &result) {
+	result.clear();
+	std::vector<Utf8_16::ubyte> out;
+	Utf8_16::ubyte leadSurrogate[2] = { 0, 0 };
+	Utf16_Iter iter;
+	const Utf8_16::encodingType encoding = (static_cast<unsigned char>(file[0]) == 0xFF) ?
+		Utf8_16::eUtf16LittleEndian : Utf8_16::eUtf16BigEndian;
+	for (size_t start = 0; start < file.length(); start += blockSize) {
+		const size_t skip = (start == 0) ? 2 : 0;
+		const size_t len = std::min(blockSize, file.length() - start);
+		const Utf8_16::ubyte *pBuf = reinterpret_cast<const Utf8_16::ubyte *>(file.data() + start);
+		out.resize(len + len / 2 + 4 + 1);
+		Utf8_16::ubyte *pCur = &out[0];
+		Utf8_16::ubyte endSurrogate[2] = { 0, 0 };
+		std::vector<Utf8_16::ubyte> prepended;
+		if (leadSurrogate[0]) {
+			prepended.resize(len - skip + 2);
+			memcpy(&prepended[0], leadSurrogate, 2);
+			memcpy(&prepended[2], pBuf + skip, len - skip);
+			iter.set(&prepended[0], len - skip + 2, encoding, endSurrogate);
+		} else {
+			iter.set(pBuf + skip, len - skip, encoding, endSurrogate);
+		}
+		for (; iter; ++iter) {
+			*pCur++ = iter.get();
+		}
+		memcpy(leadSurrogate, endSurrogate, 2);
+		result.append(reinterpret_cast<const char *>(&out[0]), pCur - &out[0]);
+	}
+}
+
+// Write UTF-8 as UTF-16 in blocks as Utf8_16_Write did with Utf8_Iter
+void OldWrite(const std::string &text, Utf8_16::encodingType encoding, const char *path) {
+	FILE *fp = fopen(path, "wb");
+	if (!fp)
+		return;
+	std::vector<Utf8_16::utf16> out(blockSize + 1);
+	fwrite(Utf8_16::k_Boms[encoding], 2, 1, fp);
+	for (size_t start = 0; start < text.length(); start += blockSize) {
+		const size_t len = std::min(blockSize, text.length() - start);
+		Utf8_Iter iter8;
+		iter8.set(reinterpret_cast<const Utf8_16::ubyte *>(text.data() + start), len);
+		Utf8_16::utf16 *pCur = &out[0];
+		for (; iter8; ++iter8) {
+			if (iter8.canGet()) {
+				int codePoint = iter8.get();
+				if (codePoint >= SURROGATE_FIRST_VALUE) {
+					codePoint -= SURROGATE_FIRST_VALUE;
+					const int lead = (codePoint >> 10) + SURROGATE_LEAD_FIRST;
+					*pCur++ = static_cast<Utf8_16::utf16>((encoding == Utf8_16::eUtf16BigEndian) ? swapped(lead) : lead);
+					const int trail = (codePoint & 0x3ff) + SURROGATE_TRAIL_FIRST;
+					*pCur++ = static_cast<Utf8_16::utf16>((encoding == Utf8_16::eUtf16BigEndian) ? swapped(trail) : trail);
+				} else {
+					*pCur++ = static_cast<Utf8_16::utf16>((encoding == Utf8_16::eUtf16BigEndian) ? swapped(codePoint) : codePoint);
+				}
+			}
+		}
+		fwrite(&out[0], reinterpret_cast<const char *>(pCur) - reinterpret_cast<const char *>(&out[0]), 1, fp);
+	}
+	fclose(fp);
+}
+
+// Read UTF-16 in blocks as FileLoader does
+void NewRead(const std::string &file, std::string &result) {
+	result.clear();
+	Utf8_16_Read convert;
+	std::vector<char> data(blockSize);
+	for (size_t start = 0; start < file.length(); start += blockSize) {
+		const size_t len = std::min(blockSize, file.length() - start);
+		memcpy(&data[0], file.data() + start, len);
+		const size_t lenConverted = convert.convert(&data[0], len);
+		result.append(convert.getNewBuf(), lenConverted);
+	}
+	const size_t lenTrail = convert.convert(nullptr, 0);
+	result.append(convert.getNewBuf(), lenTrail);
+}
+
+// Write UTF-8 as UTF-16 in blocks as FileStorer does, blocks here always ending on whole characters
+void NewWrite(const std::string &text, Utf8_16::encodingType encoding, const char *path) {
+	FILE *fp = fopen(path, "wb");
+	if (!fp)
+		return;
+	Utf8_16_Write convert;
+	convert.setEncoding(encoding);
+	convert.setfile(fp);
+	for (size_t start = 0; start < text.length(); start += blockSize) {
+		const size_t len = std::min(blockSize, text.length() - start);
+		convert.fwrite(text.data() + start, len);
+	}
+	convert.fclose();
+}
+
+// Text of about 25 MB, mostly ASCII like source code and CSV files.
+// Pieces are sized so characters are not split at block boundaries when written.
+std::string GeneratedText() {
+	const std::string line = "alpha,beta,gamma,12345,67890,\"quoted text\",delta\n";
+	const std::string other = "caf\xc3\xa9,na\xc3\xafve,\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e,\xf0\x9f\x98\x80\n";
+	std::string text;
+	while (text.length() < 25000000) {
+		for (int i = 0; i < 20; i++)
+			text += line;
+		text += other;
+	}
+	return text;
+}
+
+std::string Contents(const char *path) {
+	std::string contents;
+	FILE *fp = fopen(path, "rb");
+	if (fp) {
+		char buf[blockSize];
+		size_t len;
+		while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+			contents.append(buf, len);
+		fclose(fp);
+	}
+	return contents;
+}
+
+template <typename F>
+double Milliseconds(F f) {
+	// Best of several runs to reduce noise
+	double best = 1e30;
+	for (int run = 0; run < 5; run++) {
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+		best = std::min(best, duration.count());
+	}
+	return best;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+	std::string text;
+	Utf8_16::encodingType encoding = Utf8_16::eUtf16LittleEndian;
+	std::string file;
+	if (argc > 1) {
+		file = Contents(argv[1]);
+		if ((file.length() < 2) || !(((static_cast<unsigned char>(file[0]) == 0xFF) && (static_cast<unsigned char>(file[1]) == 0xFE)) ||
+			((static_cast<unsigned char>(file[0]) == 0xFE) && (static_cast<unsigned char>(file[1]) == 0xFF)))) {
+			fprintf(stderr, "%s is not UTF-16 with a BOM\n", argv[1]);
+			return 1;
+		}
+		if (static_cast<unsigned char>(file[0]) == 0xFE)
+			encoding = Utf8_16::eUtf16BigEndian;
+		OldRead(file, text);
+	} else {
+		text = GeneratedText();
+		OldWrite(text, encoding, tempPath);
+		file = Contents(tempPath);
+	}
+
+	// Output buffers are reused so that timing is not dominated by first touching their memory
+	std::string result;
+	NewRead(file, result);
+	if (result != text) {
+		fprintf(stderr, "Read conversions differ\n");
+		return 1;
+	}
+	OldWrite(text, encoding, tempPath);
+	const std::string writtenOld = Contents(tempPath);
+	NewWrite(text, encoding, tempPath);
+	const std::string writtenNew = Contents(tempPath);
+	remove(tempPath);
+	if (writtenNew.empty() || (writtenNew != writtenOld)) {
+		fprintf(stderr, "Write conversions differ\n");
+		return 1;
+	}
+
+	// Written text is discarded so only the conversion is timed
+	const double oldRead = Milliseconds([&]() { OldRead(file, result); });
+	const double newRead = Milliseconds([&]() { NewRead(file, result); });
+	const double oldWrite = Milliseconds([&]() { OldWrite(text, encoding, nullDevice); });
+	const double newWrite = Milliseconds([&]() { NewWrite(text, encoding, nullDevice); });
+
+	printf("%zu bytes of UTF-16, %zu bytes of UTF-8\n", file.length(), text.length());
+	printf("Read   iterators %8.1f ms   blocks %8.1f ms   %5.1fx\n", oldRead, newRead, oldRead / newRead);
+	printf("Write  iterators %8.1f ms   blocks %8.1f ms   %5.1fx\n", oldWrite, newWrite, oldWrite / newWrite);
+	return 0;
+}
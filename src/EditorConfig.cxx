@@ -24,163 +24,370 @@
 
 namespace {
 
+// A section pattern parsed once into tokens so that matching a path does not reparse it.
+struct GlobToken {
+	enum class Kind { literal, anyChar, star, starStar, set, alternatives, range };
+	Kind kind = Kind::literal;
+	char32_t ch = 0;	// literal
+	bool positive = true;	// set
+	std::u32string members;	// set
+	std::vector<std::u32string> alternatives;
+	long long low = 0;	// range
+	long long high = 0;
+};
+
+class GlobPattern {
+	std::vector<GlobToken> tokens;
+	bool valid = true;
+	bool extensionOnly = false;
+	bool MatchFrom(size_t position, std::u32string_view text) const;
+public:
+	explicit GlobPattern(std::u32string_view pattern);
+	bool Match(std::u32string_view text) const;
+	// True when whether a file matches depends only on its directory and extension
+	bool ExtensionOnly() const noexcept {
+		return extensionOnly;
+	}
+};
+
+struct ECSection {
+	GlobPattern pattern;
+	GlobPattern patternAnyDirectory;	// Pattern with "**/" prefix for simple patterns
+	bool simple;	// No '/' in pattern so matches in any directory
+	std::vector<std::pair<std::string, std::string>> settings;
+	explicit ECSection(const std::string &pattern_);
+};
+
 struct ECForDirectory {
 	bool isRoot;
 	std::string directory;
-	std::vector<std::string> lines;
+	FilePath configFile;
+	time_t modTime;
+	long long length;
+	std::vector<ECSection> sections;
 	ECForDirectory();
-	void ReadOneDirectory(const FilePath &dir);
+	void ReadOneDirectory(const FilePath &dir, time_t modTime_, long long length_);
+};
+
+// The .editorconfig files from a starting directory up to the root along with
+// the settings previously found for files in that directory.
+struct ECChain {
+	std::vector<std::shared_ptr<const ECForDirectory>> levels;
+	bool extensionOnly;
+	std::map<std::string, std::map<std::string, std::string>> results;
+	explicit ECChain(std::vector<std::shared_ptr<const ECForDirectory>> &&levels_);
 };
 
 class EditorConfig : public IEditorConfig {
-	std::vector<ECForDirectory> config;
+	std::shared_ptr<ECChain> chain;
 public:
 	~EditorConfig() override;
 	void ReadFromDirectory(const FilePath &dirStart) override;
 	std::map<std::string, std::string> MapFromAbsolutePath(const FilePath &absolutePath) const override;
 	void Clear() override;
+	FilePathSet ConfigFiles() const override;
 };
 
 const GUI::gui_char editorConfigName[] = GUI_TEXT(".editorconfig");
 
-bool PatternMatch(std::u32string_view pattern, std::u32string_view text) {
-	if (pattern == text) {
-		return true;
-	} else if (pattern.empty()) {
-		return false;
-	} else if (pattern.front() == '\\') {
-		pattern.remove_prefix(1);
-		if (pattern.empty()) {
-			// Escape with nothing being escaped
-			return false;
+// Values by key where only the most recently used few are kept so that visiting many
+// directories in a long session does not grow memory without limit.
+template <typename T>
+class RecentCache {
+	struct Entry {
+		std::shared_ptr<T> value;
+		size_t used = 0;
+	};
+	std::map<std::string, Entry> entries;
+	size_t limit;
+	size_t uses = 0;
+public:
+	explicit RecentCache(size_t limit_) noexcept : limit(limit_) {
+	}
+	// The reference is valid until the next call
+	std::shared_ptr<T> &operator[](const std::string &key) {
+		auto it = entries.find(key);
+		if (it == entries.end()) {
+			if (entries.size() >= limit) {
+				entries.erase(std::min_element(entries.begin(), entries.end(),
+					[](const std::pair<const std::string, Entry> &a, const std::pair<const std::string, Entry> &b) noexcept {
+						return a.second.used < b.second.used;
+					}));
+			}
+			it = entries.emplace(key, Entry()).first;
 		}
-		if (text.empty()) {
+		it->second.used = ++uses;
+		return it->second.value;
+	}
+};
+
+// Process-wide caches shared by all EditorConfig objects. Entries are checked against
+// the time and size of each .editorconfig file so edited files are read again.
+RecentCache<const ECForDirectory> directoryCache(512);
+RecentCache<ECChain> chainCache(128);
+
+bool IsDigit(char32_t ch) noexcept {
+	return ch >= '0' && ch <= '9';
+}
+
+// Parse an optionally negative integer that fills the whole view.
+bool ParseInteger(std::u32string_view sv, long long &value) noexcept {
+	bool negative = false;
+	if (!sv.empty() && sv.front() == '-') {
+		negative = true;
+		sv.remove_prefix(1);
+	}
+	if (sv.empty() || sv.length() > 18) {
+		return false;
+	}
+	value = 0;
+	for (const char32_t ch : sv) {
+		if (!IsDigit(ch)) {
 			return false;
 		}
-		if (pattern.front() == text.front()) {
-			pattern.remove_prefix(1);
-			text.remove_prefix(1);
-			return PatternMatch(pattern, text);
-		}
-		return false;
-	} else if (pattern.front() == '*') {
+		value = value * 10 + (ch - '0');
+	}
+	if (negative) {
+		value = -value;
+	}
+	return true;
+}
+
+GlobPattern::GlobPattern(std::u32string_view pattern) {
+	while (!pattern.empty()) {
+		GlobToken token;
+		const char32_t ch = pattern.front();
 		pattern.remove_prefix(1);
-		if (!pattern.empty() && pattern.front() == '*') {
+		if (ch == '\\') {
+			if (pattern.empty()) {
+				// Escape with nothing being escaped
+				valid = false;
+				return;
+			}
+			token.ch = pattern.front();
 			pattern.remove_prefix(1);
-			// "**" matches anything including "/"
-			while (!text.empty()) {
-				if (PatternMatch(pattern, text)) {
-					return true;
+		} else if (ch == '*') {
+			token.kind = GlobToken::Kind::star;
+			if (!pattern.empty() && pattern.front() == '*') {
+				// "**" matches anything including "/"
+				token.kind = GlobToken::Kind::starStar;
+				pattern.remove_prefix(1);
+			}
+		} else if (ch == '?') {
+			token.kind = GlobToken::Kind::anyChar;
+		} else if (ch == '[') {
+			token.kind = GlobToken::Kind::set;
+			if (!pattern.empty() && pattern.front() == '!') {
+				token.positive = false;
+				pattern.remove_prefix(1);
+			}
+			if (pattern.empty()) {
+				valid = false;
+				return;
+			}
+			while (!pattern.empty() && pattern.front() != ']') {
+				token.members.push_back(pattern.front());
+				pattern.remove_prefix(1);
+			}
+			if (!pattern.empty()) {
+				pattern.remove_prefix(1);
+			}
+		} else if (ch == '{') {
+			const size_t close = pattern.find('}');
+			if (pattern.empty()) {
+				valid = false;
+				return;
+			} else if (close == std::u32string_view::npos) {
+				// Unbalanced brace is literal
+				token.ch = ch;
+			} else {
+				const std::u32string_view body = pattern.substr(0, close);
+				pattern.remove_prefix(close + 1);
+				const size_t dots = body.find(U"..");
+				if ((dots != std::u32string_view::npos) &&
+					ParseInteger(body.substr(0, dots), token.low) &&
+					ParseInteger(body.substr(dots + 2), token.high)) {
+					// {num1..num2} matches any integer from num1 to num2
+					token.kind = GlobToken::Kind::range;
+					if (token.low > token.high) {
+						std::swap(token.low, token.high);
+					}
+				} else {
+					token.kind = GlobToken::Kind::alternatives;
+					std::u32string alternative;
+					for (const char32_t chAlt : body) {
+						if (chAlt == ',') {
+							token.alternatives.push_back(alternative);
+							alternative.clear();
+						} else {
+							alternative.push_back(chAlt);
+						}
+					}
+					token.alternatives.push_back(alternative);
 				}
-				text.remove_prefix(1);
 			}
 		} else {
-			while (!text.empty()) {
-				if (PatternMatch(pattern, text)) {
-					return true;
-				}
-				if (text.front() == '/') {
-					// "/" not matched by single "*"
-					return PatternMatch(pattern, text);
+			token.ch = ch;
+		}
+		tokens.push_back(token);
+	}
+
+	// When the final path segment is "*" or "*.<literal text>" the result depends only on
+	// the directory and the extension so it can be shared between files.
+	size_t lastSegment = 0;
+	for (size_t i = 0; i < tokens.size(); i++) {
+		if (tokens[i].kind == GlobToken::Kind::literal && tokens[i].ch == '/') {
+			lastSegment = i + 1;
+		} else if (tokens[i].kind == GlobToken::Kind::alternatives) {
+			for (const std::u32string &alternative : tokens[i].alternatives) {
+				if (alternative.find('/') != std::u32string::npos) {
+					return;
 				}
-				text.remove_prefix(1);
 			}
 		}
-		assert(text.empty());
-		// Consumed whole text with wildcard so match if pattern consumed
-		return pattern.empty();
-	} else if (text.empty()) {
-		return false;
-	} else if (pattern.front() == '?') {
-		pattern.remove_prefix(1);
-		text.remove_prefix(1);
-		return PatternMatch(pattern, text);
-	} else if (pattern.front() == text.front()) {
-		pattern.remove_prefix(1);
-		text.remove_prefix(1);
-		return PatternMatch(pattern, text);
-	} else if (pattern.front() == '[') {
-		pattern.remove_prefix(1);
-		if (pattern.empty()) {
-			return false;
-		}
-		const bool positive = pattern.front() != '!';
-		if (!positive) {
-			pattern.remove_prefix(1);
-			if (pattern.empty()) {
-				return false;
+	}
+	if (lastSegment >= tokens.size() || tokens[lastSegment].kind != GlobToken::Kind::star) {
+		return;
+	}
+	const size_t tail = lastSegment + 1;
+	if (tail < tokens.size() && !(tokens[tail].kind == GlobToken::Kind::literal && tokens[tail].ch == '.')) {
+		return;
+	}
+	for (size_t i = tail + 1; i < tokens.size(); i++) {
+		const GlobToken &token = tokens[i];
+		if (token.kind == GlobToken::Kind::literal) {
+			if (token.ch == '.') {
+				return;
 			}
-		}
-		bool inSet = false;
-		while (!pattern.empty() && pattern.front() != ']') {
-			if (pattern.front() == text.front()) {
-				inSet = true;
+		} else if (token.kind == GlobToken::Kind::alternatives) {
+			for (const std::u32string &alternative : token.alternatives) {
+				if (alternative.find('.') != std::u32string::npos) {
+					return;
+				}
 			}
-			pattern.remove_prefix(1);
-		}
-		if (!pattern.empty()) {
-			pattern.remove_prefix(1);
+		} else if (token.kind != GlobToken::Kind::range) {
+			return;
 		}
-		if (inSet != positive) {
-			return false;
-		}
-		text.remove_prefix(1);
-		return PatternMatch(pattern, text);
-	} else if (pattern.front() == '{') {
-		pattern.remove_prefix(1);
-		if (pattern.empty()) {
-			return false;
-		}
-		std::u32string_view textAlt = text;
-		bool inSet = false;
-		size_t altSuccessLen = 0;
-		while (!pattern.empty()) {
-			if (pattern.front() == '}' || pattern.front() == ',') {
-				inSet = true;
-				text.remove_prefix(altSuccessLen);
-				break;
+	}
+	extensionOnly = true;
+}
+
+bool GlobPattern::MatchFrom(size_t position, std::u32string_view text) const {
+	while (position < tokens.size()) {
+		const GlobToken &token = tokens[position];
+		switch (token.kind) {
+		case GlobToken::Kind::literal:
+			if (text.empty() || text.front() != token.ch) {
+				return false;
 			}
-			if (textAlt.empty()) {
+			text.remove_prefix(1);
+			break;
+		case GlobToken::Kind::anyChar:
+			if (text.empty()) {
 				return false;
 			}
-			if (pattern.front() == textAlt.front()) {
-				pattern.remove_prefix(1);
-				textAlt.remove_prefix(1);
-				altSuccessLen++;
-			} else {
-				while (!pattern.empty() && pattern.front() != '}' && pattern.front() != ',') {
-					pattern.remove_prefix(1);
+			text.remove_prefix(1);
+			break;
+		case GlobToken::Kind::set:
+			if (text.empty() || ((token.members.find(text.front()) != std::u32string::npos) != token.positive)) {
+				return false;
+			}
+			text.remove_prefix(1);
+			break;
+		case GlobToken::Kind::star:
+			if (position + 1 == tokens.size()) {
+				// Trailing "*" matches the rest unless there is a "/"
+				return text.find('/') == std::u32string_view::npos;
+			}
+			for (;;) {
+				if (MatchFrom(position + 1, text)) {
+					return true;
 				}
-				if (!pattern.empty() && pattern.front() == ',') {
-					pattern.remove_prefix(1);
+				if (text.empty() || text.front() == '/') {
+					// "/" not matched by single "*"
+					return false;
+				}
+				text.remove_prefix(1);
+			}
+		case GlobToken::Kind::starStar:
+			if (position + 1 == tokens.size()) {
+				return true;
+			}
+			for (;;) {
+				if (MatchFrom(position + 1, text)) {
+					return true;
+				}
+				if (text.empty()) {
+					return false;
+				}
+				text.remove_prefix(1);
+			}
+		case GlobToken::Kind::alternatives:
+			for (const std::u32string &alternative : token.alternatives) {
+				if ((text.substr(0, alternative.length()) == alternative) &&
+					MatchFrom(position + 1, text.substr(alternative.length()))) {
+					return true;
 				}
-				textAlt = text;
-				altSuccessLen = 0;
 			}
-		}
-		if (!inSet) {
 			return false;
+		case GlobToken::Kind::range: {
+				size_t digitsStart = (!text.empty() && text.front() == '-') ? 1 : 0;
+				size_t digitsEnd = digitsStart;
+				while (digitsEnd < text.length() && IsDigit(text[digitsEnd])) {
+					digitsEnd++;
+				}
+				// Try longest number first as a following token may also match digits
+				for (size_t end = digitsEnd; end > digitsStart; end--) {
+					long long value = 0;
+					if (ParseInteger(text.substr(0, end), value) &&
+						(value >= token.low) && (value <= token.high) &&
+						MatchFrom(position + 1, text.substr(end))) {
+						return true;
+					}
+				}
+				return false;
+			}
 		}
-		while (!pattern.empty() && pattern.front() != '}') {
-			pattern.remove_prefix(1);
-		}
-		if (!pattern.empty()) {
-			pattern.remove_prefix(1);
-		}
-		return PatternMatch(pattern, text);
+		position++;
 	}
-	return false;
+	return text.empty();
+}
+
+bool GlobPattern::Match(std::u32string_view text) const {
+	return valid && MatchFrom(0, text);
 }
 
+bool PatternMatch(std::u32string_view pattern, std::u32string_view text) {
+	return GlobPattern(pattern).Match(text);
 }
 
-ECForDirectory::ECForDirectory() : isRoot(false) {
+std::u32string PatternFromSection(std::string pattern) {
+	if (!FilePath::CaseSensitive()) {
+		pattern = GUI::LowerCaseUTF8(pattern);
+	}
+	// Convert to u32string to treat as characters, not bytes
+	return UTF32FromUTF8(pattern);
 }
 
-void ECForDirectory::ReadOneDirectory(const FilePath &dir) {
+}
+
+ECSection::ECSection(const std::string &pattern_) :
+	pattern(PatternFromSection(pattern_)),
+	patternAnyDirectory(PatternFromSection("**/" + pattern_)),
+	simple(pattern_.find('/') == std::string::npos) {
+}
+
+ECForDirectory::ECForDirectory() : isRoot(false), modTime(0), length(0) {
+}
+
+// The time and length are those just used to check the cache so the file is not examined again.
+void ECForDirectory::ReadOneDirectory(const FilePath &dir, time_t modTime_, long long length_) {
 	directory = dir.AsUTF8();
 	directory.append("/");
 	FilePath fpec(dir, editorConfigName);
+	configFile = fpec;
+	modTime = modTime_;
+	length = length_;
 	std::string configData = fpec.Read();
 	if (configData.size() > 0) {
 		std::string configString(configData.data(), configData.size());
@@ -196,15 +403,19 @@ void ECForDirectory::ReadOneDirectory(const FilePath &dir) {
 				// Drop comments
 			} else if (StartsWith(line, "[")) {
 				// Pattern
-				lines.push_back(line);
+				sections.emplace_back(line.substr(1, line.size() - 2));
 			} else if (Contains(line, '=')) {
 				LowerCaseAZ(line);
 				Remove(line, std::string(" "));
-				lines.push_back(line);
 				std::vector<std::string> nameVal = StringSplit(line, '=');
 				if (nameVal.size() == 2) {
-					if ((nameVal[0] == "root") && nameVal[1] == "true") {
-						isRoot = true;
+					if (sections.empty()) {
+						// Preamble before any section
+						if ((nameVal[0] == "root") && nameVal[1] == "true") {
+							isRoot = true;
+						}
+					} else {
+						sections.back().settings.emplace_back(nameVal[0], nameVal[1]);
 					}
 				}
 			}
@@ -212,62 +423,95 @@ void ECForDirectory::ReadOneDirectory(const FilePath &dir) {
 	}
 }
 
+ECChain::ECChain(std::vector<std::shared_ptr<const ECForDirectory>> &&levels_) :
+	levels(std::move(levels_)), extensionOnly(true) {
+	for (const std::shared_ptr<const ECForDirectory> &level : levels) {
+		for (const ECSection &section : level->sections) {
+			if (!section.pattern.ExtensionOnly()) {
+				extensionOnly = false;
+			}
+		}
+	}
+}
+
 EditorConfig::~EditorConfig() = default;
 
 void EditorConfig::ReadFromDirectory(const FilePath &dirStart) {
+	std::vector<std::shared_ptr<const ECForDirectory>> levels;
 	FilePath dir = dirStart;
 	while (true) {
-		ECForDirectory ecfd;
-		ecfd.ReadOneDirectory(dir);
-		config.insert(config.begin(), ecfd);
-		if (ecfd.isRoot || !dir.IsSet() || dir.IsRoot()) {
+		std::shared_ptr<const ECForDirectory> &cached = directoryCache[dir.AsUTF8()];
+		const FilePath fpec(dir, editorConfigName);
+		const time_t modTime = fpec.ModifiedTime();
+		const long long length = fpec.GetFileLength();
+		if (!cached || (cached->modTime != modTime) || (cached->length != length)) {
+			std::shared_ptr<ECForDirectory> ecfd = std::make_shared<ECForDirectory>();
+			ecfd->ReadOneDirectory(dir, modTime, length);
+			cached = ecfd;
+		}
+		levels.insert(levels.begin(), cached);
+		if (cached->isRoot || !dir.IsSet() || dir.IsRoot()) {
 			break;
 		}
 		// Up a level
 		dir = dir.Directory();
 	}
+	// Reuse the chain and its remembered results if no file has changed
+	std::shared_ptr<ECChain> &cachedChain = chainCache[dirStart.AsUTF8()];
+	if (!cachedChain || (cachedChain->levels != levels)) {
+		cachedChain = std::make_shared<ECChain>(std::move(levels));
+	}
+	chain = cachedChain;
 }
 
 std::map<std::string, std::string> EditorConfig::MapFromAbsolutePath(const FilePath &absolutePath) const {
-	std::map<std::string, std::string> ret;
+	if (!chain) {
+		return std::map<std::string, std::string>();
+	}
 	std::string fullPath = absolutePath.AsUTF8();
 #ifdef WIN32
 	// Convert Windows path separators to Unix
 	std::replace(fullPath.begin(), fullPath.end(), '\\', '/');
 #endif
-	for (const ECForDirectory &level : config) {
+
+	// Files in the same directory with the same extension share results when
+	// every section depends only on the extension.
+	std::string key = fullPath;
+	if (chain->extensionOnly) {
+		const size_t lastSlash = fullPath.rfind('/');
+		const size_t lastDot = fullPath.rfind('.');
+		key = fullPath.substr(0, (lastSlash == std::string::npos) ? 0 : lastSlash + 1);
+		key += '*';
+		if ((lastDot != std::string::npos) && ((lastSlash == std::string::npos) || (lastDot > lastSlash))) {
+			key += fullPath.substr(lastDot);
+		}
+	}
+	std::map<std::string, std::map<std::string, std::string>>::const_iterator itResult = chain->results.find(key);
+	if (itResult != chain->results.end()) {
+		return itResult->second;
+	}
+
+	std::map<std::string, std::string> ret;
+	for (const std::shared_ptr<const ECForDirectory> &level : chain->levels) {
 		std::string relPath;
-		if (level.directory.length() <= fullPath.length()) {
-			relPath = fullPath.substr(level.directory.length());
+		if (level->directory.length() <= fullPath.length()) {
+			relPath = fullPath.substr(level->directory.length());
 		}
-		bool inActiveSection = false;
-		for (auto line : level.lines) {
-			if (StartsWith(line, "[")) {
-				std::string pattern = line.substr(1, line.size() - 2);
-				if (!FilePath::CaseSensitive()) {
-					pattern = GUI::LowerCaseUTF8(pattern);
-					relPath = GUI::LowerCaseUTF8(relPath);
-				}
-				if ((pattern.find('/') == std::string::npos) && (relPath.find('/') != std::string::npos)) {
-					// Simple pattern without directories so make match in any directory
-					pattern.insert(0, "**/");
-				}
-				// Convert to u32string to treat as characters, not bytes
-				std::u32string patternU32 = UTF32FromUTF8(pattern);
-				std::u32string relPathU32 = UTF32FromUTF8(relPath);
-				inActiveSection = PatternMatch(patternU32, relPathU32);
-				// PatternMatch only works with literal filenames, '?', '*', '**', '[]', '[!]', '{,}', '\x'.
-				// Other formats not yet handled:
-				//   {num1..num2}
-			} else if (inActiveSection && Contains(line, '=')) {
-				const std::vector<std::string> nameVal = StringSplit(line, '=');
-				if (nameVal.size() == 2) {
-					if (nameVal[1] == "unset") {
-						std::map<std::string, std::string>::iterator it = ret.find(nameVal[0]);
-						if (it != ret.end())
-							ret.erase(it);
+		if (!FilePath::CaseSensitive()) {
+			relPath = GUI::LowerCaseUTF8(relPath);
+		}
+		const bool inSubdirectory = relPath.find('/') != std::string::npos;
+		const std::u32string relPathU32 = UTF32FromUTF8(relPath);
+		for (const ECSection &section : level->sections) {
+			// Simple pattern without directories so make match in any directory
+			const GlobPattern &pattern = (section.simple && inSubdirectory) ?
+				section.patternAnyDirectory : section.pattern;
+			if (pattern.Match(relPathU32)) {
+				for (const std::pair<std::string, std::string> &nameVal : section.settings) {
+					if (nameVal.second == "unset") {
+						ret.erase(nameVal.first);
 					} else {
-						ret[nameVal[0]] = nameVal[1];
+						ret[nameVal.first] = nameVal.second;
 					}
 				}
 			}
@@ -291,11 +535,23 @@ std::map<std::string, std::string> EditorConfig::MapFromAbsolutePath(const FileP
 		ret["indent_size"] = ret["tab_width"];
 	}
 
+	chain->results[key] = ret;
 	return ret;
 }
 
 void EditorConfig::Clear() {
-	config.clear();
+	chain.reset();
+}
+
+FilePathSet EditorConfig::ConfigFiles() const {
+	// Includes files that do not exist as creating them changes the settings
+	FilePathSet files;
+	if (chain) {
+		for (const std::shared_ptr<const ECForDirectory> &level : chain->levels) {
+			files.push_back(level->configFile);
+		}
+	}
+	return files;
 }
 
 #if defined(TESTING)
@@ -357,6 +613,15 @@ static void TestPatternMatch() {
 	assert(PatternMatch(U"<{ab,lm,xyz}>", U"<lm>"));
 	assert(PatternMatch(U"<{ab,lm,xyz}>", U"<xyz>"));
 	assert(PatternMatch(U"<{ab,lm,xyz}>", U"<rs>") == false);
+
+	// {num1..num2} matches any integer from num1 to num2
+	assert(PatternMatch(U"a{1..12}z", U"a1z"));
+	assert(PatternMatch(U"a{1..12}z", U"a12z"));
+	assert(PatternMatch(U"a{1..12}z", U"a13z") == false);
+	assert(PatternMatch(U"a{1..12}z", U"az") == false);
+	assert(PatternMatch(U"a{-3..3}", U"a-2"));
+	assert(PatternMatch(U"a{-3..3}", U"a-4") == false);
+	assert(PatternMatch(U"f{0..9}{0..9}", U"f42"));
 }
 
 #endif
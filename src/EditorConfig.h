@@ -13,5 +13,6 @@ public:
 	virtual void ReadFromDirectory(const FilePath &dirStart) = 0;
 	virtual std::map<std::string, std::string> MapFromAbsolutePath(const FilePath &absolutePath) const = 0;
 	virtual void Clear() = 0;
+	virtual FilePathSet ConfigFiles() const = 0;
 	static std::unique_ptr<IEditorConfig> Create();
 };
@@ -11,6 +11,7 @@
 #include "Scintilla.h"
 
 class StyleWriter;
+struct Worker;
 
 inline sptr_t SptrFromPointer(void *p) {
 	return reinterpret_cast<sptr_t>(p);
@@ -24,6 +25,14 @@ inline uptr_t UptrFromString(const char *cp) {
 	return reinterpret_cast<uptr_t>(cp);
 }
 
+// A change to the document: length characters inserted at position when positive
+// or removed from position when negative
+struct DocumentDelta {
+	int position;
+	int length;
+	int linesAdded;
+};
+
 class ExtensionAPI {
 public:
 	virtual ~ExtensionAPI() {
@@ -33,6 +42,8 @@ public:
 	virtual std::string Range(Pane p, int start, int end)=0;
 	virtual void Remove(Pane p, int start, int end)=0;
 	virtual void Insert(Pane p, int pos, const char *s)=0;
+	// Changes whenever text is inserted into or deleted from the pane's current document
+	virtual int Revision(Pane p)=0;
 	virtual void Trace(const char *s)=0;
 	virtual std::string Property(const char *key)=0;
 	virtual void SetProperty(const char *key, const char *val)=0;
@@ -46,6 +57,8 @@ public:
 	virtual void UserStripSet(int control, const char *value)=0;
 	virtual void UserStripSetList(int control, const char *value)=0;
 	virtual std::string UserStripValue(int control)=0;
+	virtual bool PerformOnNewThread(Worker *pWorker)=0;
+	virtual void PostOnMainThread(int cmd, Worker *pWorker)=0;
 };
 
 /**
@@ -78,6 +91,8 @@ public:
 	}
 	virtual bool OnDoubleClick() { return false; }
 	virtual bool OnUpdateUI() { return false; }
+	// Changes to the current document since the last call, delivered when idle
+	virtual bool OnModified(const DocumentDelta *, size_t) { return false; }
 	virtual bool OnMarginClick() { return false; }
 	virtual bool OnMacro(const char *, const char *) { return false; }
 	virtual bool OnUserListSelection(int, const char *) { return false; }
@@ -88,7 +103,11 @@ public:
 	virtual bool OnDwellStart(int, const char *) { return false; }
 	virtual bool OnClose(const char *) { return false; }
 	virtual bool OnUserStrip(int /* control */, int /* change */) { return false; }
+	// Called on the main thread for workers posted with WORK_EXTENSION; true if the worker belongs to this extension
+	virtual bool OnWorkerResult(Worker *) { return false; }
 	virtual bool NeedsOnClose() { return true; }
+	// Identifies the extension in latency warnings and reports, such as by the scripts it runs
+	virtual const char *Name() const { return ""; }
 };
 
 #endif
@@ -249,6 +249,10 @@ static int unlink(const wchar_t *filename) noexcept {
 	return _wunlink(filename);
 }
 
+static int mkdir(const wchar_t *dirname, int) noexcept {
+	return _wmkdir(dirname);
+}
+
 static int access(const wchar_t *path, int mode) noexcept {
 	return _waccess(path, mode);
 }
@@ -438,6 +442,21 @@ void FilePath::Remove() const noexcept {
 	unlink(AsInternal());
 }
 
+bool FilePath::MakeDirectory() const noexcept {
+	return mkdir(AsInternal(), 0700) == 0;
+}
+
+/**
+ * Move this file over @a destination, replacing it in one step where the platform allows.
+ */
+bool FilePath::Rename(const FilePath &destination) const noexcept {
+#ifdef WIN32
+	return ::MoveFileExW(AsInternal(), destination.AsInternal(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(AsInternal(), destination.AsInternal()) == 0;
+#endif
+}
+
 #ifndef R_OK
 // Microsoft does not define the constants used to call access
 #define R_OK 4
@@ -58,6 +58,8 @@ public:
 	FILE *Open(const GUI::gui_char *mode) const noexcept;
 	std::string Read() const;
 	void Remove() const noexcept;
+	bool Rename(const FilePath &destination) const noexcept;
+	bool MakeDirectory() const noexcept;
 	time_t ModifiedTime() const;
 	long long GetFileLength() const noexcept;
 	bool Exists() const noexcept;
@@ -0,0 +1,303 @@
+// SciTE - Scintilla based Text Editor
+/** @file FileWatcher.cxx
+ ** Watch files for changes made outside SciTE on a background thread.
+ ** On Linux, inotify watches the directories containing the files so that files
+ ** replaced by renaming, as many programs do when saving, are also noticed.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <system_error>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/inotify.h>
+#endif
+
+#include "ILoader.h"
+#include "Scintilla.h"
+
+#include "GUI.h"
+
+#include "FilePath.h"
+#include "Mutex.h"
+#include "Cookie.h"
+#include "Worker.h"
+#include "FileWorker.h"
+#include "FileWatcher.h"
+
+#if defined(__linux__)
+
+namespace {
+
+// Changes are gathered for this long after the first event so that a burst of
+// writes to one file produces a single notification. Files written continuously
+// are still reported once each period.
+constexpr int coalesceMilliseconds = 100;
+
+constexpr uint32_t watchMask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE |
+	IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+struct DirectoryWatch {
+	int wd = -1;
+	std::set<std::string> names;
+};
+
+class FileWatcherInotify : public FileWatcher {
+	WorkerListener *pListener;
+	int fdNotify;
+	int fdWake[2];
+	std::unique_ptr<Mutex> mutexWatch;
+	// Protected by mutexWatch
+	std::map<std::string, DirectoryWatch> directories;
+	std::map<int, std::string> directoryFromWatch;
+	std::set<std::string> changed;
+	bool posted;
+	bool stopping;
+	std::thread thread;
+
+	void ReadEvents();
+	bool Stopping() const;
+	void PostChanges();
+public:
+	explicit FileWatcherInotify(WorkerListener *pListener_);
+	~FileWatcherInotify() override;
+	bool Valid() const noexcept;
+	bool Start();
+	void Execute() override;
+	void Cancel() override;
+	void Watch(const FilePathSet &files) override;
+	bool Watching(const FilePath &file) const override;
+	FilePathSet Changes() override;
+};
+
+FileWatcherInotify::FileWatcherInotify(WorkerListener *pListener_) :
+	pListener(pListener_), fdNotify(-1), fdWake{-1, -1}, mutexWatch(Mutex::Create()), posted(false), stopping(false) {
+	fdNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fdNotify >= 0) {
+		if (pipe2(fdWake, O_NONBLOCK | O_CLOEXEC) != 0) {
+			close(fdNotify);
+			fdNotify = -1;
+		}
+	}
+}
+
+FileWatcherInotify::~FileWatcherInotify() {
+	if (thread.joinable()) {
+		Cancel();
+	}
+	if (fdNotify >= 0) {
+		// Closing the inotify descriptor releases all its watches
+		close(fdNotify);
+		close(fdWake[0]);
+		close(fdWake[1]);
+	}
+}
+
+bool FileWatcherInotify::Valid() const noexcept {
+	return fdNotify >= 0;
+}
+
+bool FileWatcherInotify::Start() {
+	try {
+		thread = std::thread([this]() {
+			Execute();
+		});
+	} catch (const std::system_error &) {
+		return false;
+	}
+	return true;
+}
+
+bool FileWatcherInotify::Stopping() const {
+	Lock lock(mutexWatch.get());
+	return stopping;
+}
+
+void FileWatcherInotify::ReadEvents() {
+	// Buffer aligned for inotify_event as recommended by inotify(7)
+	alignas(inotify_event) char buffer[4096];
+	for (;;) {
+		const ssize_t len = read(fdNotify, buffer, sizeof(buffer));
+		if (len <= 0) {
+			return;
+		}
+		Lock lock(mutexWatch.get());
+		for (const char *ptr = buffer; ptr < buffer + len;) {
+			const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+			ptr += sizeof(inotify_event) + event->len;
+			std::map<int, std::string>::const_iterator itDir = directoryFromWatch.find(event->wd);
+			if (itDir == directoryFromWatch.end()) {
+				continue;
+			}
+			const std::string directory = itDir->second;
+			DirectoryWatch &dw = directories[directory];
+			if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+				// Directory has gone so every file in it has changed
+				for (const std::string &name : dw.names) {
+					changed.insert(directory + "/" + name);
+				}
+				if (event->mask & IN_IGNORED) {
+					// Watch removed by the kernel: try again on next call to Watch
+					dw.wd = -1;
+					directoryFromWatch.erase(itDir);
+				}
+			} else if (event->len && dw.names.count(event->name)) {
+				changed.insert(directory + "/" + event->name);
+			}
+		}
+	}
+}
+
+void FileWatcherInotify::PostChanges() {
+	bool post = false;
+	{
+		Lock lock(mutexWatch.get());
+		if (!posted && !changed.empty()) {
+			posted = true;
+			post = true;
+		}
+	}
+	if (post) {
+		pListener->PostOnMainThread(WORK_FILECHANGED, this);
+	}
+}
+
+void FileWatcherInotify::Execute() {
+	bool pending = false;
+	std::chrono::steady_clock::time_point deadline;
+	while (!Stopping()) {
+		int timeout = -1;
+		if (pending) {
+			const std::chrono::steady_clock::duration remaining = deadline - std::chrono::steady_clock::now();
+			timeout = std::max(0, static_cast<int>(
+				std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count()) + 1);
+		}
+		pollfd fds[2] = { { fdNotify, POLLIN, 0 }, { fdWake[0], POLLIN, 0 } };
+		const int ready = poll(fds, 2, timeout);
+		if (ready < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		if (fds[1].revents & POLLIN) {
+			char drain[64];
+			while (read(fdWake[0], drain, sizeof(drain)) > 0) {
+			}
+		}
+		if (fds[0].revents & POLLIN) {
+			ReadEvents();
+			if (!pending) {
+				Lock lock(mutexWatch.get());
+				if (!changed.empty()) {
+					// The period starts with the first change and is not extended
+					// by later events so busy files are still reported.
+					pending = true;
+					deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(coalesceMilliseconds);
+				}
+			}
+		}
+		if (pending && (std::chrono::steady_clock::now() >= deadline)) {
+			pending = false;
+			PostChanges();
+		}
+	}
+	SetCompleted();
+}
+
+void FileWatcherInotify::Cancel() {
+	{
+		Lock lock(mutexWatch.get());
+		stopping = true;
+	}
+	// Wake the thread from poll then wait for it to finish
+	const char wake = 0;
+	if (write(fdWake[1], &wake, 1) < 0) {
+		// Pipe full so thread is already being woken
+	}
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void FileWatcherInotify::Watch(const FilePathSet &files) {
+	std::map<std::string, std::set<std::string>> wanted;
+	for (const FilePath &file : files) {
+		if (file.IsSet() && !file.IsUntitled()) {
+			wanted[file.Directory().AsInternal()].insert(file.Name().AsInternal());
+		}
+	}
+
+	Lock lock(mutexWatch.get());
+	for (std::map<std::string, DirectoryWatch>::iterator it = directories.begin(); it != directories.end();) {
+		if (wanted.count(it->first) == 0) {
+			if (it->second.wd >= 0) {
+				inotify_rm_watch(fdNotify, it->second.wd);
+				directoryFromWatch.erase(it->second.wd);
+			}
+			it = directories.erase(it);
+		} else {
+			++it;
+		}
+	}
+	for (std::pair<const std::string, std::set<std::string>> &dirNames : wanted) {
+		DirectoryWatch &dw = directories[dirNames.first];
+		if (dw.wd < 0) {
+			// Failure, perhaps from reaching max_user_watches, leaves the directory unwatched
+			// so that its files are checked by time stamp instead.
+			dw.wd = inotify_add_watch(fdNotify, dirNames.first.c_str(), watchMask);
+			if (dw.wd >= 0) {
+				directoryFromWatch[dw.wd] = dirNames.first;
+			}
+		}
+		dw.names = std::move(dirNames.second);
+	}
+}
+
+bool FileWatcherInotify::Watching(const FilePath &file) const {
+	const std::string directory = file.Directory().AsInternal();
+	Lock lock(mutexWatch.get());
+	std::map<std::string, DirectoryWatch>::const_iterator it = directories.find(directory);
+	return (it != directories.end()) && (it->second.wd >= 0) &&
+		it->second.names.count(file.Name().AsInternal());
+}
+
+FilePathSet FileWatcherInotify::Changes() {
+	FilePathSet files;
+	Lock lock(mutexWatch.get());
+	for (const std::string &name : changed) {
+		files.push_back(FilePath(name));
+	}
+	changed.clear();
+	posted = false;
+	return files;
+}
+
+}
+
+std::unique_ptr<FileWatcher> FileWatcher::Create(WorkerListener *pListener) {
+	std::unique_ptr<FileWatcherInotify> watcher = std::make_unique<FileWatcherInotify>(pListener);
+	if (!watcher->Valid() || !watcher->Start()) {
+		return nullptr;
+	}
+	return watcher;
+}
+
+#else
+
+std::unique_ptr<FileWatcher> FileWatcher::Create(WorkerListener *) {
+	return nullptr;
+}
+
+#endif
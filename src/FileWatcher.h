@@ -0,0 +1,18 @@
+// SciTE - Scintilla based Text Editor
+/** @file FileWatcher.h
+ ** Watch files for changes made outside SciTE on a background thread.
+ **/
+// The License.txt file describes the conditions under which this software may be distributed.
+
+class FileWatcher : public Worker {
+public:
+	// Replace the set of files being watched. May be called at any time from the main thread.
+	virtual void Watch(const FilePathSet &files) = 0;
+	// Is there an active watch that will report changes to this file?
+	virtual bool Watching(const FilePath &file) const = 0;
+	// Retrieve and forget the files that changed since the last call.
+	virtual FilePathSet Changes() = 0;
+	// Start watching on a thread owned by the watcher which is joined by Cancel.
+	// Returns nullptr when change notification is not available on this platform.
+	static std::unique_ptr<FileWatcher> Create(WorkerListener *pListener);
+};
@@ -40,7 +40,8 @@ double FileWorker::Duration() {
 }
 
 FileLoader::FileLoader(WorkerListener *pListener_, ILoader *pLoader_, const FilePath &path_, size_t size_, FILE *fp_) :
-	FileWorker(pListener_, path_, size_, fp_), pLoader(pLoader_), readSoFar(0), unicodeMode(uni8Bit) {
+	FileWorker(pListener_, path_, size_, fp_), pLoader(pLoader_), readSoFar(0), unicodeMode(uni8Bit),
+	detectEncoding(false) {
 	SetSizeJob(size);
 }
 
@@ -50,6 +51,7 @@ FileLoader::~FileLoader() {
 void FileLoader::Execute() {
 	if (fp) {
 		Utf8_16_Read convert;
+		convert.setDetect(detectEncoding);
 		std::vector<char> data(blockSize);
 		size_t lenFile = fread(&data[0], 1, blockSize, fp);
 		const UniMode umCodingCookie = CodingCookieValue(&data[0], lenFile);
@@ -81,6 +83,10 @@ void FileLoader::Execute() {
 		if (unicodeMode == uni8Bit) {
 			unicodeMode = umCodingCookie;
 		}
+		// Valid UTF-8 without a BOM is treated like UTF-8 with a cookie
+		if ((unicodeMode == uni8Bit) && (convert.getContent() == Utf8_16::cUtf8)) {
+			unicodeMode = uniCookie;
+		}
 	}
 	SetCompleted();
 	pListener->PostOnMainThread(WORK_FILEREAD, this);
@@ -94,7 +100,7 @@ void FileLoader::Cancel() {
 
 FileStorer::FileStorer(WorkerListener *pListener_, const char *documentBytes_, const FilePath &path_,
 	size_t size_, FILE *fp_, UniMode unicodeMode_, bool visibleProgress_) :
-	FileWorker(pListener_, path_, size_, fp_), documentBytes(documentBytes_), writtenSoFar(0),
+	FileWorker(pListener_, path_, size_, fp_), copied(false), documentBytes(documentBytes_), writtenSoFar(0),
 		unicodeMode(unicodeMode_), visibleProgress(visibleProgress_) {
 	SetSizeJob(size);
 }
@@ -102,6 +108,13 @@ FileStorer::FileStorer(WorkerListener *pListener_, const char *documentBytes_, c
 FileStorer::~FileStorer() {
 }
 
+// Write from a private copy of the text so the document may be modified during the save.
+void FileStorer::CopyDocument() {
+	snapshot.assign(documentBytes, size);
+	documentBytes = snapshot.c_str();
+	copied = true;
+}
+
 static bool IsUTF8TrailByte(int ch) {
 	return (ch >= 0x80) && (ch < (0x80 + 0x40));
 }
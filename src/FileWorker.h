@@ -32,6 +32,7 @@ public:
 	ILoader *pLoader;
 	size_t readSoFar;
 	UniMode unicodeMode;
+	bool detectEncoding;
 
 	FileLoader(WorkerListener *pListener_, ILoader *pLoader_, const FilePath &path_, size_t size_, FILE *fp_);
 	~FileLoader() override;
@@ -43,6 +44,8 @@ public:
 };
 
 class FileStorer : public FileWorker {
+	std::string snapshot;
+	bool copied;
 public:
 	const char *documentBytes;
 	size_t writtenSoFar;
@@ -52,6 +55,10 @@ public:
 	FileStorer(WorkerListener *pListener_, const char *documentBytes_, const FilePath &path_,
 		size_t size_, FILE *fp_, UniMode unicodeMode_, bool visibleProgress_);
 	~FileStorer() override;
+	void CopyDocument();
+	bool CopiedDocument() const noexcept {
+		return copied;
+	}
 	void Execute() override;
 	void Cancel() override;
 	bool IsLoading() const override {
@@ -63,5 +70,7 @@ enum {
 	WORK_FILEREAD = 1,
 	WORK_FILEWRITTEN = 2,
 	WORK_FILEPROGRESS = 3,
+	WORK_FILECHANGED = 4,
+	WORK_EXTENSION = 5,
 	WORK_PLATFORM = 100
 };
@@ -5,49 +5,13 @@
 // Copyright 1998-2004 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstddef>
 #include <cstring>
 
 #include <string>
 
 #include "IFaceTable.h"
 
-int IFaceTable::FindConstant(const char *name) {
-	int lo = 0;
-	int hi = IFaceTable::constantCount - 1;
-	do {
-		const int idx = (lo+hi)/2;
-		const int cmp = strcmp(name, constants[idx].name);
-
-		if (cmp > 0) {
-			lo = idx + 1;
-		} else if (cmp < 0) {
-			hi = idx - 1;
-		} else {
-			return idx;
-		}
-	} while (lo <= hi);
-
-	return -1;
-}
-
-int IFaceTable::FindFunction(const char *name) {
-	int lo = 0;
-	int hi = IFaceTable::functionCount - 1;
-	do {
-		const int idx = (lo+hi)/2;
-		const int cmp = strcmp(name, functions[idx].name);
-		if (cmp > 0) {
-			lo = idx + 1;
-		} else if (cmp < 0) {
-			hi = idx - 1;
-		} else {
-			return idx;
-		}
-	} while (lo <= hi);
-
-	return -1;
-}
-
 int IFaceTable::FindFunctionByConstantName(const char *name) {
 	if (strncmp(name, "SCI_", 4)==0) {
 		// This looks like a constant for an iface function.  This requires
@@ -69,25 +33,6 @@ int IFaceTable::FindFunctionByConstantName(const char *name) {
 	return -1;
 }
 
-int IFaceTable::FindProperty(const char *name) {
-	int lo = 0;
-	int hi = IFaceTable::propertyCount - 1;
-	do {
-		const int idx = (lo+hi)/2;
-		const int cmp = strcmp(name, properties[idx].name);
-
-		if (cmp > 0) {
-			lo = idx + 1;
-		} else if (cmp < 0) {
-			hi = idx - 1;
-		} else {
-			return idx;
-		}
-	} while (lo <= hi);
-
-	return -1;
-}
-
 std::string IFaceTable::GetConstantName(int value, const char *prefix) {
 	// Look in both the constants table and the functions table.  Start with functions.
 	for (int funcIdx = 0; funcIdx < functionCount; ++funcIdx) {
@@ -144,6 +89,7 @@ static IFaceConstant ifaceConstants[] = {
 	{"IDM_ABBREV",242},
 	{"IDM_ABOUT",902},
 	{"IDM_ACTIVATE",320},
+	{"IDM_ALLFEATURES",417},
 	{"IDM_ALLOWACCESS",119},
 	{"IDM_BLOCK_COMMENT",243},
 	{"IDM_BOOKMARK_CLEARALL",224},
@@ -3463,10 +3409,520 @@ static IFaceProperty ifaceProperties[] = {
 
 enum {
 	ifaceFunctionCount = 309,
-	ifaceConstantCount = 2789,
+	ifaceConstantCount = 2790,
 	ifacePropertyCount = 232
 };
 
+static const unsigned short ifaceConstantNameSeeds[] = {
+	1,3,1,1,1,1,1,10,3,5,11,5,1,18,0,0,
+	1,4,2,5,0,1,1,1,1,2,0,5,7,0,2,2,
+	3,1,2,1,0,1,3,1,7,3,6,8,2,0,4,2,
+	1,1,1,1,0,2,5,8,2,6,0,2,6,5,3,1,
+	1,7,2,9,3,3,1,2,1,1,2,3,2,4,1,2,
+	6,6,2,4,5,3,1,2,7,7,1,1,1,1,3,1,
+	0,2,4,2,7,2,3,3,2,6,7,1,2,3,1,1,
+	1,3,1,2,6,1,2,1,1,1,2,4,1,2,1,1,
+	1,9,3,1,2,3,7,1,2,2,2,2,5,2,2,1,
+	3,4,1,0,1,0,2,5,7,2,2,1,0,5,6,2,
+	0,1,3,1,1,7,2,2,2,10,2,1,1,1,1,1,
+	11,4,1,2,7,1,1,1,10,4,17,1,4,1,2,7,
+	2,1,2,0,3,1,8,5,5,1,7,12,1,1,9,4,
+	1,2,1,2,5,9,1,1,0,3,1,2,6,1,5,2,
+	4,1,2,4,0,2,3,1,1,2,1,2,1,8,1,6,
+	1,2,6,3,1,2,1,2,11,1,0,4,3,8,8,3,
+	1,3,6,2,2,6,3,1,2,7,5,1,1,6,3,3,
+	2,2,15,3,4,25,1,4,1,1,12,2,2,2,1,2,
+	11,5,1,1,4,0,2,1,2,1,3,2,3,5,4,1,
+	2,1,4,1,1,2,2,5,1,7,0,6,2,9,6,3,
+	0,1,7,3,4,2,1,1,1,3,2,2,15,2,2,1,
+	1,1,1,2,1,3,7,7,1,1,2,3,13,1,1,1,
+	3,1,3,2,5,5,3,6,0,1,10,4,1,4,0,4,
+	1,4,16,1,3,5,2,3,0,3,2,3,4,1,0,6,
+	9,2,5,2,3,5,8,3,4,2,1,1,1,4,1,2,
+	3,4,1,7,0,1,4,1,8,0,1,2,3,0,2,3,
+	5,1,2,1,1,2,1,1,3,2,5,1,16,1,3,10,
+	5,2,3,6,1,4,4,22,7,2,2,2,6,1,2,4,
+	11,10,6,6,4,4,2,4,1,7,3,22,16,3,2,2,
+	2,9,1,1,1,5,1,2,2,4,2,1,1,1,6,0,
+	14,1,1,1,7,1,4,5,1,1,1,2,1,12,1,1,
+	2,3,3,0,3,4,5,4,7,1,3,1,12,1,1,10,
+	15,2,1,4,2,3,11,6,3,2,0,5,8,2,3,3,
+	1,3,0,1,4,2,2,1,3,7,12,5,4,2,8,2,
+	2,1,8,3,15,12,2,1,3,14,1,0,1,5,1,3,
+	1,0,2,16,5,5,1,9,2,5,3,1,14,1,4,1,
+	5,2,4,2,0,1,2,5,2,1,0,4,16,1,2,2,
+	2,1,1,2,3,1,3,13,1,1,4,1,5,1,1,6,
+	2,3,1,9,9,4,6,14,9,1,14,1,5,2,0,2,
+	5,1,4,12,7,1,6,1,0,5,1,5,0,6,9,2,
+	6,2,3,0,0,5,3,1,3,4,9,1,1,4,4,1,
+	1,3,3,1,1,7,4,25,4,1,5,4,2,5,4,1,
+	1,6,6,5,4,1,4,6,1,15,3,1,4,8,0,1,
+	13,3,4,2,3,0,9,4,2,6,3,2,2,5,4,1,
+	1,1,4,1,3,1,1,1,1,4,4,3,4,0,4,5,
+	0,2,2,2,1,1,1,4,1,3,2,6,2,3,2,5,
+	1,2,2,5,9,1,0,3,4,27,1,0,5,2,4,2,
+	4,1,7,7,5,7,1,2,2,4,1,23,1,2,2,5,
+	1,5,15,10,4,2,1,5,3,6,26,2,5,3,0,2,
+	3,10,2,2,1,1,1,2,4,5,7,2,1,1,1,5,
+	5,7,23,1,2,10,6,7,4,4,2,1,2,1,1,1,
+	2,4,1,1,3,2,0,4,9,5,3,3,0,0,1,5,
+	3,2,2,4,1,4,3,4,6,4,7,2,0,10,3,11,
+	1,2,1,3,4,2,0,3,4,1,4,1,9,3,4,3,
+	1,8,1,1,5,7,8,1,2,2,13,0,1,9,0,1,
+	9,1,7,1,4,4,8,3,0,6,7,1,9,2,4,1,
+	3,3,2,10,5,2,3,1,8,3,1,2,1,1,0,11,
+	6,4,7,5,23,4,25,11,1,9,4,2,4,9,2,1,
+	1,3,5,15,7,11,1,1,1,14,1,1,6,3,0,1,
+	1,1,1,6,2,10,2,2,2,3,2,5,15,10,1,1,
+	12,1,0,4,15,5,12,5,4,2,1,2,5,1,4,1,
+	2,9,3,18,2,5,2,3,5,6,0,3,2,8,2,12,
+	1,3,3,8,5,1,9,1,9,3,1,1,1,3,8,5,
+	1,9,2,9,1,7,3,22,2,5,1,8,6,50,3,1,
+};
+
+static const short ifaceConstantNameSlots[] = {
+	-1,-1,2449,99,-1,369,-1,794,-1,801,358,-1,1677,1284,1213,138,
+	1010,783,501,-1,-1,-1,246,2437,2080,1458,-1,-1,1462,823,298,1552,
+	-1,796,-1,-1,-1,65,-1,-1,1076,309,2067,688,2599,-1,1339,2245,
+	-1,2592,-1,-1,1772,641,2202,-1,-1,2605,-1,-1,2658,-1,1282,-1,
+	-1,-1,1198,2181,2268,441,805,-1,596,1092,-1,2654,1045,1931,878,713,
+	347,2494,278,2083,1337,-1,-1,-1,631,-1,669,-1,-1,1122,1108,-1,
+	-1,-1,1145,709,-1,2455,-1,1774,-1,355,-1,2685,-1,-1,841,1930,
+	-1,-1,2762,1997,-1,1898,2773,2422,-1,2258,1816,2764,972,1078,1896,2539,
+	-1,-1,1841,2700,238,182,1610,2184,1330,-1,-1,922,1838,2403,1619,-1,
+	2432,2215,-1,-1,1429,903,359,1005,1219,1630,-1,877,638,-1,1673,-1,
+	1136,992,-1,-1,1320,2405,555,-1,-1,1952,-1,-1,817,1116,-1,1957,
+	467,2346,2626,2186,1954,1949,1724,1863,1564,633,-1,-1,1177,2731,211,-1,
+	2679,1792,1696,-1,-1,-1,591,1402,-1,2682,2152,1133,2065,-1,833,2037,
+	-1,-1,-1,77,-1,697,1427,2750,1147,2113,2205,96,2714,1102,-1,-1,
+	395,1350,597,-1,2087,-1,-1,-1,2088,1149,-1,498,-1,-1,1814,-1,
+	2293,-1,-1,1222,-1,1559,-1,462,1806,2586,2028,357,2447,-1,1431,-1,
+	1451,2470,1443,1628,2075,2137,543,-1,-1,576,-1,1029,959,1269,777,2341,
+	-1,1839,2185,-1,481,1304,706,-1,2716,1170,2771,2220,202,-1,-1,1944,
+	-1,2260,2416,2471,-1,788,-1,2194,-1,487,-1,-1,-1,-1,4,-1,
+	477,2298,-1,-1,1876,719,1227,1682,-1,-1,397,1875,-1,-1,-1,-1,
+	171,-1,560,122,884,-1,-1,2279,-1,2159,-1,1692,-1,1168,1164,599,
+	2504,920,762,-1,1107,2146,494,545,1627,28,643,780,-1,860,2176,1212,
+	1433,1668,-1,5,-1,2616,2089,1566,1894,-1,-1,1470,381,-1,-1,-1,
+	2160,2756,730,-1,1440,-1,2619,-1,333,2568,1140,581,-1,2699,-1,2009,
+	380,-1,1647,-1,154,-1,216,1157,-1,-1,-1,320,2663,2098,-1,-1,
+	-1,1176,1022,1703,527,151,402,-1,-1,-1,2011,321,-1,-1,-1,729,
+	-1,414,-1,396,926,2068,-1,-1,-1,626,1766,-1,2513,1804,834,791,
+	1327,-1,1742,679,-1,2332,1438,2311,64,547,1019,35,-1,1002,-1,2032,
+	-1,-1,980,2548,2200,1150,-1,1946,495,-1,-1,-1,1236,562,1565,1781,
+	444,1872,-1,932,2287,1787,1220,-1,2784,2409,2753,197,1526,-1,-1,2632,
+	-1,807,2523,1271,2736,-1,-1,-1,1691,1755,1947,58,711,136,-1,-1,
+	235,-1,2765,-1,2020,2234,318,-1,453,1033,2005,2457,-1,-1,293,1567,
+	-1,-1,2359,-1,-1,1555,2121,707,2356,480,-1,1825,1648,2740,-1,-1,
+	1942,570,-1,-1,1783,-1,1183,2016,2694,1760,-1,1392,830,872,2742,1843,
+	1595,-1,408,2128,-1,1899,1420,725,2725,960,1991,1728,2053,2492,2163,-1,
+	352,-1,1609,-1,1936,1447,-1,45,-1,723,941,968,2744,2508,189,2698,
+	239,1920,442,-1,-1,1634,2166,752,-1,405,47,1784,1892,-1,276,1919,
+	1226,1693,-1,578,616,2547,-1,270,2488,2118,139,1398,-1,-1,883,2051,
+	-1,2677,-1,1587,97,668,1439,-1,-1,2223,-1,-1,2644,-1,-1,2221,
+	2174,244,-1,1767,-1,2412,1196,1422,-1,33,173,209,2752,-1,1864,2606,
+	2450,-1,-1,2556,1797,-1,2576,482,2240,165,-1,575,1579,296,2250,-1,
+	-1,455,686,-1,1903,907,-1,-1,-1,-1,2266,542,43,2544,971,-1,
+	-1,-1,2058,-1,-1,880,372,871,-1,2343,1069,1354,2092,-1,-1,1517,
+	1534,-1,-1,179,1593,640,1408,-1,1038,23,-1,2057,-1,2366,-1,715,
+	94,-1,1046,2748,1273,892,2027,62,-1,-1,1683,-1,1870,800,-1,219,
+	909,680,1406,-1,954,1963,2280,2507,1259,1858,2330,-1,443,690,-1,-1,
+	409,257,102,786,2588,-1,1478,749,-1,2173,763,1030,2706,644,1329,-1,
+	1182,-1,-1,1277,1152,429,661,277,-1,-1,1333,-1,2563,-1,600,1326,
+	-1,2006,2096,659,1880,-1,2312,-1,-1,782,434,2182,377,754,-1,2564,
+	1091,1137,2541,-1,2587,-1,-1,323,567,627,572,-1,1712,49,2193,489,
+	2783,551,-1,1287,-1,231,625,771,-1,2466,2760,-1,2778,-1,2577,-1,
+	2676,-1,364,1317,-1,-1,996,-1,1550,1560,1799,875,-1,513,-1,2069,
+	-1,1570,1228,1528,2491,-1,1934,836,2617,1347,2305,1489,2320,1072,1461,546,
+	1981,2681,-1,-1,539,-1,1366,196,-1,-1,657,170,-1,-1,199,147,
+	844,456,2302,573,-1,2322,-1,312,2130,-1,1448,-1,-1,90,1617,-1,
+	1393,1411,-1,1464,118,2711,2211,1085,1061,876,-1,2713,-1,-1,1535,-1,
+	888,-1,2170,2012,2309,1283,1169,2380,-1,986,266,-1,2630,2684,1345,2407,
+	-1,-1,646,2055,-1,2562,1403,1312,-1,589,2787,760,403,-1,115,-1,
+	223,521,2141,2641,-1,1652,1060,-1,-1,1711,1093,-1,1789,-1,939,2615,
+	2482,-1,-1,2408,-1,-1,2157,-1,-1,1400,849,-1,1776,1704,970,2180,
+	607,-1,-1,-1,-1,1254,-1,-1,-1,624,2107,-1,873,1407,-1,-1,
+	-1,2446,-1,2542,2468,1360,1978,724,2575,282,2052,424,1623,1384,-1,-1,
+	2430,2376,1754,474,2411,1496,-1,-1,2361,1765,200,1637,2049,1900,1077,593,
+	-1,915,1793,1538,1970,1382,1123,-1,-1,2379,279,2329,620,-1,689,-1,
+	1071,994,124,-1,-1,2500,948,2495,345,-1,781,-1,911,947,-1,262,
+	2597,-1,2230,1879,-1,2389,1385,2620,673,-1,962,2572,2247,-1,123,27,
+	514,1757,1390,228,-1,931,-1,-1,419,2318,2479,-1,-1,-1,1959,-1,
+	1591,-1,-1,225,785,1088,-1,-1,-1,-1,652,-1,-1,-1,1209,2046,
+	1404,-1,-1,2313,-1,1490,-1,-1,2593,237,185,-1,463,1175,-1,133,
+	-1,2665,956,-1,-1,2745,732,2191,-1,378,1476,1423,-1,418,1434,2301,
+	11,-1,-1,336,1238,-1,-1,2242,1118,1389,1641,1672,243,1580,-1,1082,
+	2705,1904,831,1417,1655,-1,410,1007,853,275,2295,896,131,1132,2401,864,
+	210,1086,1141,-1,741,1895,-1,1011,882,1796,2618,-1,866,2372,1081,1907,
+	460,2138,854,2515,1710,-1,-1,83,367,8,1372,-1,-1,1653,1280,2398,
+	1945,-1,-1,700,2022,-1,722,2225,-1,1471,-1,2347,10,-1,285,1128,
+	852,1847,1916,-1,1000,1750,-1,2435,221,1828,242,2337,1208,1290,2254,714,
+	260,-1,-1,1171,1964,1165,-1,-1,-1,2464,825,2237,-1,1001,2239,-1,
+	126,772,-1,2671,-1,1012,388,106,2276,-1,-1,2443,1600,300,181,1554,
+	-1,1135,1358,784,1178,-1,629,1686,1646,-1,2785,1722,-1,1578,74,-1,
+	824,-1,2325,2512,2689,-1,750,1291,1656,-1,492,422,-1,826,1054,-1,
+	537,1768,1562,874,2370,2460,-1,2441,687,-1,1615,-1,965,1292,1525,288,
+	1,120,2534,-1,1901,-1,684,734,-1,2530,2123,1289,2444,-1,-1,1980,
+	1788,2085,-1,-1,1611,1753,1120,-1,-1,605,1252,2257,-1,-1,1003,-1,
+	-1,-1,818,1055,-1,1810,541,770,174,-1,-1,-1,720,1205,1823,1475,
+	1275,1121,2077,440,-1,2377,-1,1540,1999,-1,-1,-1,2583,1660,1455,-1,
+	-1,2282,1399,-1,389,1885,1889,-1,549,1363,-1,1316,1463,1279,2426,-1,
+	-1,-1,-1,695,2674,-1,-1,2261,821,-1,400,-1,-1,1966,248,-1,
+	-1,-1,-1,1786,2746,-1,-1,1747,1334,1669,-1,1917,-1,-1,816,-1,
+	2033,250,-1,1542,68,-1,2775,1633,1063,-1,1336,2552,-1,1518,1992,1690,
+	890,-1,116,-1,2759,2165,-1,893,-1,113,2373,2145,-1,1419,1094,2124,
+	328,-1,1524,2675,1233,-1,-1,639,718,-1,-1,2451,-1,1203,2100,92,
+	1761,1189,1109,942,-1,531,229,-1,194,-1,-1,1967,1044,670,-1,1084,
+	1915,2538,-1,887,158,2306,2726,1893,-1,952,538,128,1808,-1,1926,-1,
+	2400,2054,845,2406,-1,2150,2351,-1,-1,1335,808,1743,949,1771,2344,2531,
+	295,929,-1,662,1933,-1,-1,532,1179,-1,-1,-1,-1,1715,-1,-1,
+	704,340,-1,471,2612,577,-1,806,1255,13,2709,590,1573,-1,81,-1,
+	1155,-1,2081,2015,-1,2072,630,1557,1689,415,-1,1223,1794,885,-1,348,
+	1188,2560,2284,496,-1,-1,1854,1987,1494,-1,-1,1487,2704,2331,787,-1,
+	-1,891,2769,1850,2036,-1,2172,1676,-1,1929,-1,1158,2717,-1,2262,2712,
+	2625,-1,-1,1679,-1,-1,46,-1,2394,2000,-1,2579,2690,1456,1902,-1,
+	1800,2410,2003,694,-1,356,1249,435,1769,-1,71,1725,2317,157,1844,-1,
+	1935,2561,-1,2144,1409,283,2465,703,2133,1734,1950,623,2669,-1,2106,2757,
+	1380,1307,195,2608,2613,-1,917,1586,509,-1,-1,193,-1,963,964,1996,
+	2129,-1,2478,-1,1468,-1,2119,425,2485,2519,1469,2571,-1,-1,-1,1211,
+	1298,421,721,1501,-1,1421,-1,450,699,1762,-1,-1,1187,2388,655,-1,
+	857,353,-1,1547,-1,2007,950,1184,451,1466,-1,2059,1822,1596,208,466,
+	-1,-1,-1,-1,1311,-1,-1,294,1173,-1,1104,1148,2729,-1,2727,-1,
+	-1,1151,22,566,-1,-1,-1,-1,-1,29,717,1293,2631,272,945,146,
+	1457,510,-1,1161,991,457,1387,981,647,759,1004,2192,42,-1,458,934,
+	411,-1,1006,758,1605,1948,1130,-1,-1,-1,1083,1603,-1,2243,827,2472,
+	2367,1891,611,1758,338,1473,426,1425,-1,778,368,274,1266,918,2178,1699,
+	-1,2104,1608,2686,-1,-1,1074,2621,2253,1986,-1,-1,-1,1638,1432,850,
+	108,-1,2111,215,-1,1257,1702,2650,1851,798,1748,-1,2645,2724,-1,2635,
+	1374,404,-1,2566,-1,-1,-1,2358,-1,1126,-1,2235,144,584,413,674,
+	2421,1714,485,2360,52,761,-1,-1,1616,894,2463,1556,448,-1,1576,1256,
+	479,923,-1,2363,-1,1272,847,-1,2316,-1,-1,1383,2082,95,1888,177,
+	829,-1,103,1142,2352,1371,-1,-1,370,-1,1442,2013,1990,1635,-1,1718,
+	-1,2090,134,-1,-1,2198,583,127,-1,-1,1270,-1,559,2241,-1,632,
+	-1,839,1050,2271,613,2190,-1,385,-1,232,1726,2102,2093,-1,804,1388,
+	-1,870,12,813,-1,2655,2528,2233,-1,1303,-1,757,-1,-1,2749,-1,
+	-1,906,-1,1543,979,2391,-1,2135,2546,-1,1207,259,2010,-1,-1,2109,
+	2720,-1,-1,-1,579,1553,-1,602,548,-1,-1,-1,1640,-1,-1,-1,
+	1546,1773,-1,958,1927,810,-1,765,595,-1,-1,-1,617,2283,-1,360,
+	1260,1613,1709,524,-1,-1,1515,1492,1172,1344,-1,2481,1607,2064,1159,449,
+	303,-1,1065,-1,1811,637,2603,148,1732,-1,-1,119,812,2715,1224,253,
+	1887,-1,2585,-1,-1,2154,-1,1163,1134,0,2739,1818,1720,-1,-1,731,
+	2735,186,226,2458,-1,166,-1,1230,792,2476,1267,-1,727,-1,-1,904,
+	1670,-1,-1,799,1846,175,683,2473,2355,1624,2335,1048,-1,-1,2149,261,
+	80,2357,1058,1659,-1,1632,1067,974,1286,269,-1,-1,-1,2061,1095,2289,
+	2204,-1,-1,2545,2445,-1,1250,454,-1,-1,1113,391,2094,-1,565,335,
+	-1,1721,867,-1,-1,-1,331,1618,1661,619,-1,2524,-1,-1,475,-1,
+	1075,1258,2101,1982,-1,2703,1296,843,2390,1453,-1,-1,2070,375,1779,2554,
+	1248,2659,-1,2030,-1,2629,2499,-1,2382,1331,1186,1706,-1,-1,2132,40,
+	-1,2383,-1,308,2573,-1,710,733,1229,2042,-1,716,503,1770,1625,1047,
+	1671,685,1729,2569,-1,-1,1519,2424,937,500,51,736,1009,-1,-1,-1,
+	187,-1,-1,2273,-1,-1,-1,-1,1809,1318,1428,2732,1685,1938,-1,540,
+	753,2095,1365,2222,1533,-1,-1,-1,1435,-1,130,609,472,-1,-1,-1,
+	1018,1906,2086,1096,-1,-1,1181,2741,1117,-1,2139,-1,172,2246,153,-1,
+	234,1087,1359,2565,-1,-1,1878,1736,-1,-1,1622,608,-1,1477,334,416,
+	-1,-1,-1,1070,-1,1424,1521,1216,1908,-1,2224,905,2043,-1,811,554,
+	2297,2789,2142,254,1377,2018,550,-1,350,-1,1741,2188,297,-1,1017,1305,
+	2393,-1,2733,2673,2047,-1,1642,776,304,747,2300,192,663,2761,1953,2048,
+	1606,-1,2307,2518,1368,24,1234,-1,1503,1795,-1,2231,2105,1486,398,2600,
+	682,1826,1985,802,-1,289,1498,1973,1545,1995,1911,1849,2536,1727,-1,-1,
+	2229,-1,-1,2004,302,525,-1,105,1206,-1,-1,-1,1391,828,1491,436,
+	2116,2480,2209,-1,1713,2091,-1,1974,2754,-1,2594,764,2633,490,2151,-1,
+	1308,-1,-1,2259,585,2,53,-1,766,1746,2527,233,149,-1,2063,-1,
+	-1,2281,1842,738,1585,1099,1905,793,-1,1812,-1,-1,1021,-1,-1,504,
+	519,1247,2168,-1,-1,2487,2718,407,1834,2201,-1,-1,-1,1346,2448,664,
+	1738,-1,2722,1877,-1,263,-1,214,14,2050,-1,316,756,2549,2097,2290,
+	2483,-1,-1,2387,1239,-1,1053,2415,1131,-1,886,910,145,180,1817,-1,
+	1376,162,280,-1,438,2503,-1,2354,2701,2719,-1,1662,-1,-1,-1,-1,
+	2402,1008,25,1859,176,692,1752,1667,2303,1373,1820,-1,518,2126,392,675,
+	1037,2345,1912,91,1167,-1,936,564,-1,944,1332,-1,797,908,2131,156,
+	2590,-1,-1,1138,2474,-1,2496,-1,1154,-1,614,-1,1342,2275,993,552,
+	1749,1598,371,-1,-1,-1,571,943,-1,774,1621,969,-1,1940,-1,2038,
+	-1,-1,2044,2721,31,-1,1785,654,1056,-1,-1,-1,1124,859,326,1180,
+	476,-1,2314,2420,-1,222,2510,-1,-1,1446,-1,2788,-1,204,1090,1507,
+	2134,-1,264,-1,382,-1,164,856,292,63,2418,1539,-1,1536,439,1465,
+	2453,1314,1932,1493,-1,2103,-1,2643,-1,59,2768,1782,2692,-1,2497,1449,
+	2509,1861,1495,-1,1484,2417,-1,-1,1532,897,-1,178,-1,-1,2175,-1,
+	-1,417,-1,1881,-1,-1,-1,-1,-1,2427,251,-1,568,2342,610,2581,
+	-1,-1,1941,-1,2414,-1,-1,-1,1801,2212,-1,319,916,-1,-1,1353,
+	2203,2333,1482,2122,1306,227,1837,21,737,2213,1369,-1,-1,-1,1708,1548,
+	190,-1,2607,1089,-1,330,61,-1,2214,2442,2602,544,1835,-1,-1,1805,
+	342,-1,2288,1674,1873,273,-1,1563,2691,1614,2340,1114,989,1361,-1,634,
+	2454,-1,1924,-1,795,168,863,-1,-1,520,2462,1051,459,-1,-1,1602,
+	869,-1,1666,1274,1042,1043,390,2255,2543,2642,2501,324,-1,502,1695,317,
+	-1,523,2349,1052,615,953,743,-1,1998,2267,1245,927,557,387,-1,-1,
+	983,37,19,-1,-1,-1,311,152,1737,1504,-1,1510,676,-1,-1,1232,
+	2025,1348,339,-1,535,121,2208,-1,1763,484,-1,-1,588,445,2461,2529,
+	-1,-1,1694,70,-1,2079,-1,111,-1,-1,1730,1777,1857,855,183,2274,
+	2637,1976,2336,284,-1,-1,-1,2024,1886,-1,2708,1629,1218,1395,2350,-1,
+	291,1909,1798,287,-1,1897,822,1574,2774,2767,1923,2666,89,1522,1657,868,
+	-1,985,247,2493,374,-1,2413,1125,-1,2371,-1,493,2728,2167,955,621,
+	1717,1195,-1,2517,-1,1833,110,346,160,-1,2559,-1,6,677,85,1862,
+	-1,978,1523,-1,951,1506,2031,437,1103,-1,98,104,1701,267,653,-1,
+	-1,1215,198,431,-1,2045,-1,1549,322,2763,-1,2374,-1,-1,2707,2651,
+	2251,2066,-1,-1,1513,2429,2550,961,2640,-1,1589,-1,2505,60,1357,642,
+	-1,241,-1,2292,2114,141,2660,-1,-1,-1,2364,990,427,1790,-1,2236,
+	-1,580,-1,-1,1571,-1,1584,2023,1639,1244,1883,691,420,1620,-1,1199,
+	966,-1,-1,-1,-1,553,2158,-1,506,-1,-1,865,-1,-1,746,373,
+	79,2147,1592,2171,1241,-1,901,2286,957,-1,1972,-1,1445,-1,-1,2486,
+	1483,2019,1253,1665,2648,649,-1,895,1214,858,-1,-1,1032,2040,1413,-1,
+	-1,2683,-1,1588,645,-1,-1,-1,-1,-1,2217,-1,2639,-1,-1,2780,
+	-1,1499,1955,-1,1315,2228,401,1643,1827,-1,114,167,1988,1707,1479,203,
+	1437,-1,84,-1,-1,2520,1068,-1,1871,-1,814,1512,325,265,851,2156,
+	-1,2697,2285,-1,469,363,-1,-1,-1,-1,36,1364,2558,1192,-1,-1,
+	819,902,-1,-1,681,2469,1928,1601,-1,712,2099,299,1028,1631,-1,1740,
+	1989,2272,898,286,1460,341,1396,-1,744,505,412,2693,-1,2334,755,44,
+	-1,1201,2014,2627,1856,1599,-1,2378,1764,648,-1,-1,1288,-1,1261,-1,
+	1193,2392,2452,1520,2308,1459,512,-1,-1,-1,2467,142,2136,-1,1105,9,
+	696,751,-1,76,2680,1309,2782,-1,1025,-1,-1,1684,1853,-1,-1,2526,
+	1751,306,1913,1778,809,-1,-1,2179,1472,2747,-1,-1,236,594,1582,2484,
+	-1,2206,191,48,1059,2120,779,803,-1,432,1323,-1,-1,-1,789,2177,
+	-1,2326,-1,1968,1297,-1,1651,-1,999,-1,1426,-1,50,-1,107,433,
+	-1,628,705,2425,1352,838,2589,879,-1,-1,-1,1185,1700,748,188,2315,
+	2108,1268,651,2161,-1,-1,30,55,-1,57,1866,1143,2026,290,2278,-1,
+	1430,988,665,-1,529,1803,1412,1511,1190,18,-1,2385,-1,-1,1739,-1,
+	-1,2653,832,-1,-1,1415,1064,1678,1480,938,2143,930,601,2252,848,-1,
+	735,1080,230,1500,1162,881,1204,-1,112,2695,366,2115,137,2196,1716,2525,
+	2511,2365,1983,1246,15,1977,1243,2189,-1,-1,2310,846,-1,-1,1450,2779,
+	2770,-1,2614,-1,305,2628,1636,38,1604,1723,1979,2502,67,-1,2001,1649,
+	428,-1,2567,-1,933,383,163,497,-1,1340,87,1153,2076,862,1397,1240,
+	-1,2140,-1,1626,1325,-1,-1,-1,-1,671,569,1242,88,-1,1156,-1,
+	-1,739,1235,-1,-1,2533,129,2439,-1,135,2199,-1,1031,2021,-1,-1,
+	-1,1452,598,1160,1016,-1,2084,508,-1,1281,-1,2153,-1,2622,2244,268,
+	2056,2710,2438,2265,1319,2431,34,-1,-1,1813,-1,-1,-1,-1,2399,1444,
+	-1,39,2338,-1,1474,1024,-1,768,-1,249,1039,1210,-1,399,1583,-1,
+	1129,488,-1,54,1111,82,-1,1530,2777,-1,-1,301,1925,213,2071,2604,
+	660,1454,2656,1845,1062,-1,1276,-1,2781,2249,-1,207,2623,1943,-1,314,
+	2162,1023,-1,-1,2112,2238,365,1644,773,-1,840,1654,1035,740,2595,-1,
+	-1,-1,1197,815,66,-1,1687,1066,78,940,-1,-1,2060,586,-1,1759,
+	2207,728,-1,-1,636,2582,1295,1174,1698,2436,491,1225,2521,-1,-1,1568,
+	526,-1,1575,837,-1,-1,-1,-1,362,2381,1791,-1,1418,1285,-1,310,
+	1745,1343,1921,-1,218,384,464,-1,-1,1993,-1,1664,-1,2506,93,1756,
+	1590,349,1057,2419,516,790,1505,-1,155,217,1821,946,1581,2475,2652,1865,
+	517,-1,982,1961,447,-1,2758,1263,1101,2386,-1,997,100,1508,-1,1848,
+	1146,1401,-1,-1,-1,1971,-1,2668,2395,2647,-1,2369,2477,1265,-1,2574,
+	-1,2227,478,256,1100,1509,-1,2657,-1,1663,1910,702,-1,-1,-1,1597,
+	726,1681,2646,1200,1127,-1,2696,-1,1958,1719,995,1362,-1,2634,-1,-1,
+	2624,499,2702,2327,667,2248,327,534,-1,184,528,132,742,2551,820,2672,
+	1191,1860,2263,913,1984,-1,-1,2687,2291,-1,-1,1937,26,1780,925,-1,
+	201,1294,-1,-1,-1,-1,-1,1251,1013,-1,-1,1819,315,-1,-1,-1,
+	1027,-1,1735,-1,2323,666,-1,-1,-1,2002,2073,307,169,1217,1650,-1,
+	486,1467,861,2218,-1,-1,1341,-1,17,899,-1,622,1531,-1,1299,2555,
+	1485,1612,1119,656,1855,-1,-1,-1,-1,-1,406,-1,1544,-1,1324,-1,
+	1882,245,2397,-1,-1,-1,-1,-1,2601,-1,-1,-1,2662,1313,281,-1,
+	-1,2578,271,1529,2678,-1,2110,2772,2433,-1,1832,468,-1,2294,-1,-1,
+	1321,2078,-1,2269,1367,220,-1,393,-1,140,-1,-1,-1,-1,1349,-1,
+	2611,1918,2570,536,470,-1,767,618,1014,1441,2219,1351,-1,1922,1975,2127,
+	2434,1969,56,2117,2514,461,1807,-1,1079,258,446,1020,2074,1436,842,73,
+	2776,1994,1322,86,1514,914,2591,1237,976,-1,-1,2319,1310,1049,924,1594,
+	1278,1840,2423,582,-1,101,329,1115,1874,-1,2299,-1,612,2148,606,2041,
+	-1,2404,-1,2610,1110,-1,-1,125,2155,698,515,2195,693,1488,507,2164,
+	2737,2210,150,2766,2197,1951,984,2428,2440,2489,701,161,1221,-1,1405,206,
+	-1,313,117,2368,423,-1,-1,-1,-1,386,1744,143,-1,835,1869,2786,
+	1355,1034,-1,2664,2321,1802,-1,2636,1731,-1,-1,1867,522,-1,2532,-1,
+	1680,376,2516,1815,2062,2755,1097,1264,1139,1379,2459,1572,-1,-1,1569,603,
+	2667,635,1697,2187,-1,430,-1,533,1962,-1,-1,1914,-1,2183,900,32,
+	-1,1836,1041,-1,-1,-1,-1,511,2125,16,1852,-1,255,2362,1073,1965,
+	2216,-1,483,1166,1516,2277,2029,556,2751,2490,-1,361,2034,1775,1541,1410,
+	-1,240,2264,1381,2743,75,-1,-1,558,1939,-1,-1,2304,2296,-1,2353,
+	-1,2226,1026,587,592,-1,-1,912,-1,1202,973,-1,1658,109,2039,708,
+	1558,332,2017,1338,1370,-1,452,1824,-1,212,3,1481,-1,1577,1890,1502,
+	1394,1829,-1,-1,2456,769,2596,2738,-1,-1,-1,-1,252,473,1551,-1,
+	1106,1527,-1,2649,343,-1,745,-1,-1,1414,337,987,2169,-1,72,-1,
+	1561,2584,975,1645,-1,2580,2535,1375,2723,2638,-1,2035,7,1705,-1,-1,
+	351,1416,-1,224,-1,574,1194,1040,-1,1960,-1,-1,1112,-1,-1,-1,
+	1537,530,-1,-1,-1,-1,-1,2661,2328,1036,394,1884,604,1386,-1,-1,
+	2730,2008,1733,2670,-1,-1,-1,-1,-1,1302,2553,2522,2598,1868,2270,919,
+	-1,-1,-1,-1,2540,2339,-1,1378,1262,-1,2324,1328,-1,465,1098,344,
+	-1,-1,-1,-1,1356,928,658,2384,1231,2375,1144,-1,921,977,-1,354,
+	561,-1,20,2688,-1,-1,41,-1,379,-1,-1,159,672,1301,650,563,
+	935,2396,2232,2537,998,1956,-1,1688,2348,205,69,775,1831,678,889,1300,
+	2256,2498,-1,-1,-1,1830,2734,2609,1015,2557,-1,-1,967,-1,1675,1497,
+};
+
+static const unsigned short ifaceFunctionNameSeeds[] = {
+	1,5,1,0,2,1,4,3,2,1,2,2,1,2,0,3,
+	1,2,9,6,1,2,1,1,1,5,1,1,1,0,2,1,
+	5,2,2,2,1,1,1,3,1,3,1,3,1,0,3,3,
+	2,4,1,3,1,2,3,2,2,1,5,1,0,2,3,2,
+	1,5,1,2,8,0,8,1,1,1,4,1,6,0,2,3,
+	1,1,10,2,7,0,1,2,3,0,2,2,1,6,1,1,
+	2,1,8,1,2,3,0,1,2,4,1,13,15,1,1,1,
+	2,3,3,2,1,12,14,3,4,3,2,2,5,5,1,0,
+};
+
+static const short ifaceFunctionNameSlots[] = {
+	155,57,119,194,283,-1,-1,234,25,-1,68,-1,101,-1,-1,-1,
+	229,55,43,-1,72,-1,54,202,-1,4,-1,-1,48,130,-1,206,
+	-1,296,199,27,-1,65,102,243,17,-1,-1,-1,67,-1,-1,13,
+	-1,-1,12,-1,250,226,59,-1,26,166,148,-1,-1,200,60,294,
+	109,205,271,120,-1,-1,187,157,30,123,58,-1,145,266,223,83,
+	46,153,-1,-1,218,-1,244,8,-1,133,14,-1,-1,204,241,-1,
+	-1,195,16,-1,168,-1,107,-1,37,232,222,-1,40,-1,-1,-1,
+	-1,38,171,-1,106,251,277,-1,-1,212,227,-1,245,-1,64,-1,
+	175,215,143,-1,211,126,-1,-1,257,63,189,-1,-1,91,231,-1,
+	108,141,249,-1,176,-1,-1,-1,-1,47,28,-1,132,-1,287,214,
+	-1,45,-1,151,-1,-1,-1,113,44,-1,74,252,272,-1,267,292,
+	137,3,94,146,144,10,49,-1,93,-1,-1,-1,263,61,-1,177,
+	284,305,247,-1,-1,86,-1,154,90,-1,79,-1,-1,39,-1,-1,
+	224,-1,105,262,-1,87,260,-1,114,31,-1,-1,33,53,-1,140,
+	298,-1,-1,170,-1,-1,182,-1,196,-1,-1,129,275,95,-1,-1,
+	-1,-1,-1,209,303,110,258,299,150,-1,242,255,89,238,-1,186,
+	136,163,20,-1,-1,-1,-1,-1,-1,261,270,235,286,179,73,-1,
+	-1,-1,-1,-1,-1,-1,285,15,-1,0,295,217,172,193,92,-1,
+	-1,32,121,-1,-1,118,190,307,9,210,203,164,-1,169,291,-1,
+	239,138,188,6,-1,-1,117,-1,7,-1,265,11,18,216,185,124,
+	-1,62,116,259,-1,-1,35,135,-1,-1,104,103,50,-1,308,147,
+	253,-1,293,76,279,240,-1,69,-1,99,304,274,192,-1,230,-1,
+	-1,21,152,23,-1,160,127,225,161,173,174,2,-1,273,-1,-1,
+	111,281,264,213,70,156,178,-1,-1,278,56,-1,-1,42,-1,301,
+	131,-1,-1,181,236,254,-1,184,268,-1,34,125,-1,-1,-1,233,
+	96,228,85,219,300,-1,-1,-1,142,269,-1,-1,282,-1,288,-1,
+	-1,-1,29,297,-1,-1,-1,41,80,-1,-1,5,-1,220,36,-1,
+	22,139,-1,-1,-1,191,-1,-1,128,207,82,-1,66,-1,167,306,
+	246,88,-1,180,-1,134,-1,-1,290,-1,122,1,208,100,276,-1,
+	-1,-1,-1,-1,198,158,19,183,-1,75,112,302,24,115,77,221,
+	159,-1,-1,162,280,84,-1,201,248,98,256,52,-1,197,-1,289,
+	-1,-1,51,237,-1,-1,81,149,-1,-1,71,-1,165,78,-1,97,
+};
+
+static const unsigned short ifacePropertyNameSeeds[] = {
+	4,1,0,1,0,2,1,0,2,2,1,0,1,3,1,1,
+	1,1,5,2,1,1,1,2,3,1,0,0,0,1,1,1,
+	2,1,2,3,5,1,1,1,2,1,1,0,2,0,1,1,
+	1,1,1,4,3,1,0,2,3,1,1,2,0,2,2,0,
+	1,4,1,0,1,1,0,5,3,0,1,4,4,5,2,1,
+	1,1,1,1,1,4,1,2,2,0,1,1,1,0,2,2,
+	1,1,1,0,1,2,1,4,4,1,4,8,3,0,0,1,
+	3,1,3,2,1,1,2,3,4,0,1,0,1,3,0,1,
+};
+
+static const short ifacePropertyNameSlots[] = {
+	-1,41,-1,-1,-1,110,-1,-1,-1,132,-1,171,222,143,112,200,
+	-1,2,82,-1,205,10,-1,221,180,168,-1,83,115,-1,207,-1,
+	-1,-1,101,208,-1,60,-1,29,124,-1,-1,-1,121,40,-1,-1,
+	56,-1,-1,-1,37,58,-1,220,-1,-1,78,30,-1,178,204,-1,
+	173,182,61,-1,-1,-1,138,-1,-1,85,-1,219,-1,-1,81,-1,
+	-1,66,7,-1,0,-1,-1,69,203,169,-1,-1,152,-1,161,95,
+	-1,-1,216,-1,102,64,-1,-1,-1,158,-1,-1,-1,19,-1,-1,
+	-1,65,-1,-1,127,-1,-1,231,131,-1,-1,-1,144,-1,24,-1,
+	192,155,18,49,-1,108,117,-1,-1,-1,77,-1,-1,106,-1,126,
+	-1,-1,-1,-1,-1,-1,146,-1,28,3,-1,-1,23,111,62,-1,
+	-1,224,-1,84,48,20,-1,154,-1,-1,55,-1,8,6,-1,-1,
+	-1,31,-1,-1,128,57,-1,-1,-1,-1,227,-1,156,45,42,193,
+	21,-1,134,-1,211,9,86,4,-1,196,70,145,139,-1,-1,-1,
+	-1,89,-1,-1,-1,-1,-1,16,-1,191,35,185,153,-1,-1,-1,
+	136,-1,-1,-1,-1,-1,-1,-1,179,38,-1,-1,-1,-1,172,-1,
+	-1,-1,-1,-1,-1,-1,-1,-1,22,-1,-1,63,195,-1,17,-1,
+	114,-1,-1,-1,-1,98,-1,-1,-1,-1,-1,-1,-1,190,-1,-1,
+	-1,-1,-1,201,-1,-1,-1,-1,-1,165,-1,-1,-1,34,52,228,
+	-1,-1,1,226,142,194,-1,-1,104,199,-1,-1,-1,-1,-1,217,
+	174,-1,14,-1,209,-1,59,187,-1,229,76,5,141,50,-1,-1,
+	223,151,90,188,75,99,-1,-1,159,107,-1,-1,135,-1,-1,183,
+	-1,198,47,197,206,148,133,160,129,118,-1,79,-1,-1,149,116,
+	-1,-1,80,-1,-1,-1,-1,-1,-1,-1,26,-1,87,15,-1,-1,
+	-1,-1,184,-1,-1,137,-1,-1,-1,-1,-1,-1,-1,-1,73,181,
+	72,12,-1,13,122,119,-1,-1,162,-1,170,-1,-1,-1,166,125,
+	-1,177,-1,-1,-1,-1,213,176,44,-1,-1,109,-1,212,-1,-1,
+	-1,-1,-1,-1,-1,189,96,-1,113,-1,33,-1,-1,157,25,230,
+	-1,-1,120,92,36,-1,-1,210,-1,164,-1,167,46,105,-1,-1,
+	-1,94,147,-1,71,-1,-1,-1,140,68,-1,97,27,88,214,-1,
+	67,-1,-1,-1,218,51,-1,163,11,-1,202,-1,-1,-1,-1,74,
+	-1,100,-1,-1,-1,130,-1,-1,-1,-1,-1,32,-1,-1,186,-1,
+	53,43,54,-1,123,-1,39,175,93,225,150,215,-1,103,91,-1,
+};
+
+static const unsigned short ifaceFunctionValueSeeds[] = {
+	3,1,30,6,0,13,3,0,3,2,19,1,1,1,1,1,
+	72,15,10,1,2,1,7,1,5,2,3,4,1,2,3,29,
+	3,1,2,8,2,2,1,2,2,9,8,3,18,1,10,1,
+	2,82,3,6,32,5,81,5,70,4,0,3,1,1,5,5,
+	3,12,2,1,15,2,2,0,5,3,14,6,1,8,5,0,
+	1,1,3,1,9,1,0,5,27,1,2,6,19,61,3,76,
+	29,17,2,14,98,0,38,162,53,26,0,17,19,10,18,3,
+	1,20,12,36,64,1,17,131,20,73,22,14,9,15,3,1,
+};
+
+static const short ifaceFunctionValueSlots[] = {
+	177,266,-1,112,31,-1,-1,-1,-1,-1,-1,108,-1,-1,-1,119,
+	-1,176,-1,126,77,-1,74,194,-1,-1,12,101,281,171,219,-1,
+	56,-1,61,-1,98,121,-1,222,-1,44,-1,-1,-1,15,187,-1,
+	0,-1,57,139,262,-1,191,-1,197,-1,48,-1,184,-1,173,-1,
+	267,208,-1,-1,193,66,229,-1,-1,-1,195,-1,200,45,175,290,
+	273,202,-1,-1,-1,308,-1,38,-1,234,-1,225,156,-1,-1,-1,
+	223,244,138,178,-1,188,293,-1,69,86,240,213,14,-1,-1,-1,
+	16,245,2,3,212,-1,276,109,-1,76,91,-1,230,-1,6,-1,
+	249,227,254,-1,-1,269,300,-1,220,53,148,64,1,235,21,238,
+	-1,259,307,-1,-1,-1,47,128,221,65,106,246,160,-1,71,292,
+	30,169,-1,252,-1,226,207,243,-1,255,196,-1,-1,147,24,-1,
+	-1,-1,111,96,-1,-1,-1,72,233,32,-1,306,-1,150,-1,258,
+	217,37,210,215,136,303,242,-1,17,251,-1,305,54,129,271,-1,
+	-1,167,-1,163,153,185,-1,78,83,141,67,-1,123,140,-1,-1,
+	-1,-1,18,250,-1,228,288,41,89,-1,270,-1,-1,58,265,168,
+	35,264,-1,102,289,164,29,-1,117,296,-1,-1,131,186,204,-1,
+	-1,-1,110,304,-1,284,260,-1,-1,46,-1,99,20,27,-1,22,
+	85,302,-1,62,297,180,143,287,-1,55,125,-1,162,122,-1,-1,
+	104,-1,253,216,-1,-1,-1,232,295,-1,-1,-1,205,155,-1,-1,
+	124,80,-1,25,-1,-1,-1,-1,261,-1,179,280,-1,146,28,-1,
+	113,-1,181,-1,272,63,-1,-1,-1,144,-1,-1,-1,97,82,-1,
+	135,5,182,192,-1,-1,-1,103,133,19,-1,218,277,-1,-1,-1,
+	-1,161,-1,151,283,75,-1,132,174,241,7,-1,-1,248,275,79,
+	13,127,120,-1,-1,26,-1,282,224,247,60,203,42,9,-1,278,
+	274,236,84,158,237,-1,-1,279,95,33,134,165,-1,118,93,-1,
+	10,-1,257,-1,145,50,294,73,142,-1,299,94,-1,-1,-1,81,
+	-1,-1,8,49,157,-1,105,-1,-1,172,-1,285,170,198,199,201,
+	68,231,40,23,-1,116,-1,130,92,-1,43,-1,268,88,209,137,
+	-1,256,52,-1,87,-1,-1,-1,239,-1,-1,-1,-1,286,-1,152,
+	206,301,-1,90,-1,291,214,-1,34,36,-1,114,-1,-1,298,149,
+	-1,159,-1,166,-1,115,-1,39,59,-1,154,51,70,100,-1,211,
+	-1,-1,189,11,107,183,-1,-1,190,-1,-1,263,-1,-1,4,-1,
+};
+
+static const unsigned short ifacePropertyValueSeeds[] = {
+	37,1,46,2,18,105,82,3,1,3,45,3,1,40,36,29,
+	25,134,39,103,1,0,1,58,49,11,17,149,123,1,80,24,
+	24,9,100,22,23,63,1,4,1,2,0,138,1,70,26,73,
+	25,38,31,1,214,42,32,46,1,103,20,4,108,49,67,72,
+	257,3,25,170,13,138,131,179,321,8,147,51,128,91,5,7,
+	141,44,145,13,29,259,9,8,179,3,0,9,69,11,85,574,
+	14,5,71,204,5,1,32,140,3,139,131,0,89,3,209,6,
+	6,29,116,69,3,34,5,57,8,101,26,769,190,68,131,0,
+};
+
+static const short ifacePropertyValueSlots[] = {
+	203,189,-1,196,211,103,145,132,-1,5,-1,223,-1,37,207,65,
+	12,87,-1,136,56,-1,166,123,-1,-1,22,124,99,-1,126,-1,
+	143,-1,138,-1,148,208,73,32,58,143,-1,181,-1,184,165,104,
+	138,106,21,149,197,164,149,49,129,-1,209,23,31,140,214,-1,
+	198,130,-1,128,227,218,2,120,-1,148,201,-1,22,17,65,167,
+	153,74,-1,95,103,4,191,231,19,142,106,225,92,-1,34,-1,
+	211,187,118,141,24,25,39,1,57,107,154,58,69,-1,134,182,
+	223,85,2,193,89,212,19,222,225,204,199,60,68,-1,221,-1,
+	220,46,115,7,-1,85,230,-1,53,168,180,84,151,91,41,52,
+	27,-1,-1,178,-1,158,200,-1,-1,4,202,203,-1,110,47,208,
+	167,-1,-1,41,-1,121,190,192,77,214,67,-1,61,123,63,-1,
+	174,36,183,90,-1,160,80,31,176,114,46,26,3,173,125,183,
+	155,112,50,10,122,179,158,62,42,119,-1,226,181,48,94,28,
+	-1,87,-1,229,56,221,124,90,18,168,32,105,144,68,9,-1,
+	45,97,59,125,109,179,99,18,226,15,157,-1,-1,-1,13,127,
+	230,173,-1,-1,120,-1,98,-1,82,210,132,159,100,75,224,-1,
+	-1,185,170,155,93,200,131,96,44,43,118,78,166,213,6,164,
+	220,111,-1,128,227,34,217,117,102,146,78,17,146,16,205,170,
+	178,50,24,228,101,191,161,72,186,-1,175,26,66,79,-1,55,
+	219,-1,192,129,131,-1,-1,-1,172,188,64,169,80,163,177,156,
+	224,-1,48,-1,116,150,-1,-1,-1,126,75,-1,-1,133,-1,-1,
+	163,54,97,121,96,89,156,184,71,202,111,142,76,-1,0,-1,
+	-1,209,95,229,193,189,-1,201,93,45,-1,38,33,30,169,3,
+	194,84,74,-1,30,177,83,114,212,190,151,171,140,147,-1,216,
+	154,108,172,198,-1,-1,11,119,66,100,92,135,-1,70,219,-1,
+	14,-1,33,-1,14,141,83,150,81,52,186,28,15,-1,42,152,
+	9,16,207,113,162,-1,57,-1,-1,195,-1,86,195,228,-1,88,
+	69,194,67,43,25,215,-1,35,44,122,231,101,145,47,8,94,
+	-1,20,197,91,188,54,-1,180,76,115,127,206,-1,98,13,217,
+	11,82,27,171,218,40,105,182,139,-1,-1,162,-1,-1,59,72,
+	-1,130,-1,-1,165,63,-1,-1,73,137,175,51,216,-1,199,86,
+	-1,-1,7,153,29,71,12,49,1,-1,-1,0,29,222,-1,-1,
+};
+
 //--Autogenerated
 
 const IFaceFunction * const IFaceTable::functions = ifaceFunctions;
@@ -3477,3 +3933,75 @@ const int IFaceTable::constantCount = ifaceConstantCount;
 
 const IFaceProperty * const IFaceTable::properties = ifaceProperties;
 const int IFaceTable::propertyCount = ifacePropertyCount;
+
+namespace {
+
+// These must match HashName and HashValue in scripts/IFaceTableGen.py
+
+constexpr unsigned int IFaceHash(const char *name, unsigned int seed) noexcept {
+	unsigned int h = 2166136261u ^ seed;
+	for (; *name; name++) {
+		h ^= static_cast<unsigned char>(*name);
+		h *= 16777619u;
+	}
+	return h;
+}
+
+constexpr unsigned int IFaceHash(int value, unsigned int seed) noexcept {
+	unsigned int h = static_cast<unsigned int>(value) ^ seed;
+	h ^= h >> 16;
+	h *= 0x45d9f3bu;
+	h ^= h >> 16;
+	h *= 0x45d9f3bu;
+	h ^= h >> 16;
+	return h;
+}
+
+// Each key maps to a distinct slot but keys not in the table also map to some slot
+// so the caller must check that the entry found matches.
+template <typename Key, size_t seedCount, size_t slotCount>
+int HashIndex(Key key, const unsigned short (&seeds)[seedCount], const short (&slots)[slotCount]) noexcept {
+	static_assert((seedCount & (seedCount - 1)) == 0, "Seed count must be a power of 2");
+	static_assert((slotCount & (slotCount - 1)) == 0, "Slot count must be a power of 2");
+	const unsigned int seed = seeds[IFaceHash(key, 0) & (seedCount - 1)];
+	return slots[IFaceHash(key, seed) & (slotCount - 1)];
+}
+
+}
+
+int IFaceTable::FindConstant(const char *name) {
+	const int idx = HashIndex(name, ifaceConstantNameSeeds, ifaceConstantNameSlots);
+	if ((idx >= 0) && (strcmp(name, constants[idx].name) == 0))
+		return idx;
+	return -1;
+}
+
+int IFaceTable::FindFunction(const char *name) {
+	const int idx = HashIndex(name, ifaceFunctionNameSeeds, ifaceFunctionNameSlots);
+	if ((idx >= 0) && (strcmp(name, functions[idx].name) == 0))
+		return idx;
+	return -1;
+}
+
+int IFaceTable::FindFunctionByValue(int value) {
+	const int idx = HashIndex(value, ifaceFunctionValueSeeds, ifaceFunctionValueSlots);
+	if ((idx >= 0) && (functions[idx].value == value))
+		return idx;
+	return -1;
+}
+
+int IFaceTable::FindProperty(const char *name) {
+	const int idx = HashIndex(name, ifacePropertyNameSeeds, ifacePropertyNameSlots);
+	if ((idx >= 0) && (strcmp(name, properties[idx].name) == 0))
+		return idx;
+	return -1;
+}
+
+int IFaceTable::FindPropertyByValue(int value) {
+	if (value == 0)	// Missing getters and setters are 0
+		return -1;
+	const int idx = HashIndex(value, ifacePropertyValueSeeds, ifacePropertyValueSlots);
+	if ((idx >= 0) && ((properties[idx].getter == value) || (properties[idx].setter == value)))
+		return idx;
+	return -1;
+}
@@ -87,7 +87,9 @@ public:
 	static int FindConstant(const char *name);
 	static int FindFunction(const char *name);
 	static int FindFunctionByConstantName(const char *name);
+	static int FindFunctionByValue(int value);
 	static int FindProperty(const char *name);
+	static int FindPropertyByValue(int value);
 
 	static std::string GetConstantName(int value, const char *prefix);
 };
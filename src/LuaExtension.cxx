@@ -6,11 +6,23 @@
 #include <cstdlib>
 #include <cstring>
 #include <cstdio>
+#include <cctype>
 #include <ctime>
 
 #include <string>
+#include <string_view>
 #include <vector>
-
+#include <deque>
+#include <map>
+#include <algorithm>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <system_error>
+
+#include "ILoader.h"
 #include "Scintilla.h"
 
 #include "GUI.h"
@@ -19,6 +31,10 @@
 #include "FilePath.h"
 #include "StyleWriter.h"
 #include "Extender.h"
+#include "Mutex.h"
+#include "Cookie.h"
+#include "Worker.h"
+#include "FileWorker.h"
 
 #include "IFaceTable.h"
 #include "SciTEKeys.h"
@@ -226,21 +242,16 @@ static int cf_scite_send(lua_State *L) {
 	lua_replace(L, 1);
 
 	IFaceFunction func = { "", 0, iface_void, {iface_void, iface_void} };
-	for (int funcIdx = 0; funcIdx < IFaceTable::functionCount; ++funcIdx) {
-		if (IFaceTable::functions[funcIdx].value == message) {
-			func = IFaceTable::functions[funcIdx];
-			break;
-		}
-	}
-
-	if (func.value == 0) {
-		for (int propIdx = 0; propIdx < IFaceTable::propertyCount; ++propIdx) {
+	const int funcIdx = IFaceTable::FindFunctionByValue(message);
+	if (funcIdx >= 0) {
+		func = IFaceTable::functions[funcIdx];
+	} else {
+		const int propIdx = IFaceTable::FindPropertyByValue(message);
+		if (propIdx >= 0) {
 			if (IFaceTable::properties[propIdx].getter == message) {
 				func = IFaceTable::properties[propIdx].GetterFunction();
-				break;
-			} else if (IFaceTable::properties[propIdx].setter == message) {
+			} else {
 				func = IFaceTable::properties[propIdx].SetterFunction();
-				break;
 			}
 		}
 	}
@@ -282,6 +293,13 @@ static int cf_scite_open(lua_State *L) {
 	return 0;
 }
 
+static int cf_scite_enable_feature(lua_State *L) {
+	std::string cmd = "enablefeature:";
+	cmd += luaL_optstring(L, 1, "all");
+	host->Perform(cmd.c_str());
+	return 0;
+}
+
 static int cf_scite_menu_command(lua_State *L) {
 	const int cmdID = luaL_checkint(L, 1);
 	if (cmdID) {
@@ -647,6 +665,587 @@ static int cf_pane_match_generator(lua_State *L) {
 	return 1;
 }
 
+// Document view.  A read-only view of a pane's text that works directly on
+// Scintilla's buffer so large documents can be examined without first copying
+// them into Lua strings.  Positions are document positions as for the other
+// pane methods: the first byte is at 0 and ranges exclude their end.
+// Any change to the document or switch to another buffer invalidates the view.
+
+struct DocumentView {
+	ExtensionAPI::Pane pane;
+	sptr_t doc;
+	int revision;
+	const char *text;	// NUL terminated by Scintilla
+	sptr_t length;
+};
+
+// The text pointer is only valid while the same document remains unmodified
+static bool view_valid(const DocumentView *pdv) {
+	return (host->Send(pdv->pane, SCI_GETDOCPOINTER) == pdv->doc) &&
+		(host->Revision(pdv->pane) == pdv->revision) &&
+		(reinterpret_cast<const char *>(host->Send(pdv->pane, SCI_GETCHARACTERPOINTER)) == pdv->text);
+}
+
+static const DocumentView *check_view_object(lua_State *L, int index) {
+	const DocumentView *pdv = static_cast<DocumentView *>(checkudata(L, index, "SciTE_MT_DocumentView"));
+	if (!pdv) {
+		raise_error(L, "Document view object expected.");
+		return nullptr;
+	}
+	if ((pdv->pane == ExtensionAPI::paneEditor) && (curBufferIndex < 0))
+		raise_error(L, "Editor pane is not accessible at this time.");
+	if (!view_valid(pdv)) {
+		raise_error(L, "Blocked attempt to use invalidated document view.");
+	}
+	return pdv;
+}
+
+static sptr_t view_position(lua_State *L, int index, sptr_t defaultPosition, sptr_t length) {
+	const lua_Integer position = luaL_optinteger(L, index, defaultPosition);
+	if (position < 0)
+		return 0;
+	if (position > length)
+		return length;
+	return static_cast<sptr_t>(position);
+}
+
+// Lua pattern matching over a document view.
+// Adapted from lstrlib.c in Lua 5.3 which is Copyright (C) 1994-2017 Lua.org, PUC-Rio
+// and distributed under the MIT license.  Position captures return document positions.
+
+namespace {
+
+constexpr int capUnfinished = -1;
+constexpr int capPosition = -2;
+constexpr int maxMatchCalls = 200;
+constexpr int maxCaptures = 32;
+constexpr char escapeChar = '%';
+const char patternSpecials[] = "^$*+?.([%-";
+
+struct MatchState {
+	const char *src_init;	// start of document
+	const char *src_end;	// end of document
+	const char *p_end;	// end of pattern
+	lua_State *L;
+	int matchdepth;	// control for recursive depth (to avoid C stack overflow)
+	unsigned char level;	// total number of captures (finished or unfinished)
+	struct {
+		const char *init;
+		ptrdiff_t len;
+	} capture[maxCaptures];
+};
+
+inline int uchar(char c) noexcept {
+	return static_cast<unsigned char>(c);
+}
+
+const char *pattern_match(MatchState *ms, const char *s, const char *p);
+
+int check_capture(MatchState *ms, int l) {
+	l -= '1';
+	if (l < 0 || l >= ms->level || ms->capture[l].len == capUnfinished)
+		return luaL_error(ms->L, "invalid capture index %%%d", l + 1);
+	return l;
+}
+
+int capture_to_close(MatchState *ms) {
+	int level = ms->level;
+	for (level--; level >= 0; level--)
+		if (ms->capture[level].len == capUnfinished)
+			return level;
+	return luaL_error(ms->L, "invalid pattern capture");
+}
+
+const char *classend(MatchState *ms, const char *p) {
+	switch (*p++) {
+	case escapeChar:
+		if (p == ms->p_end)
+			luaL_error(ms->L, "malformed pattern (ends with '%%')");
+		return p + 1;
+	case '[':
+		if (*p == '^')
+			p++;
+		do {	// look for a ']'
+			if (p == ms->p_end)
+				luaL_error(ms->L, "malformed pattern (missing ']')");
+			if (*(p++) == escapeChar && p < ms->p_end)
+				p++;	// skip escapes (e.g. '%]')
+		} while (*p != ']');
+		return p + 1;
+	default:
+		return p;
+	}
+}
+
+int match_class(int c, int cl) {
+	int res;
+	switch (tolower(cl)) {
+	case 'a': res = isalpha(c); break;
+	case 'c': res = iscntrl(c); break;
+	case 'd': res = isdigit(c); break;
+	case 'g': res = isgraph(c); break;
+	case 'l': res = islower(c); break;
+	case 'p': res = ispunct(c); break;
+	case 's': res = isspace(c); break;
+	case 'u': res = isupper(c); break;
+	case 'w': res = isalnum(c); break;
+	case 'x': res = isxdigit(c); break;
+	case 'z': res = (c == 0); break;	// deprecated option
+	default: return (cl == c);
+	}
+	return (islower(cl) ? res : !res);
+}
+
+int matchbracketclass(int c, const char *p, const char *ec) {
+	int sig = 1;
+	if (*(p + 1) == '^') {
+		sig = 0;
+		p++;	// skip the '^'
+	}
+	while (++p < ec) {
+		if (*p == escapeChar) {
+			p++;
+			if (match_class(c, uchar(*p)))
+				return sig;
+		} else if ((*(p + 1) == '-') && (p + 2 < ec)) {
+			p += 2;
+			if (uchar(*(p - 2)) <= c && c <= uchar(*p))
+				return sig;
+		} else if (uchar(*p) == c) {
+			return sig;
+		}
+	}
+	return !sig;
+}
+
+int singlematch(MatchState *ms, const char *s, const char *p, const char *ep) {
+	if (s >= ms->src_end)
+		return 0;
+	const int c = uchar(*s);
+	switch (*p) {
+	case '.': return 1;	// matches any char
+	case escapeChar: return match_class(c, uchar(*(p + 1)));
+	case '[': return matchbracketclass(c, p, ep - 1);
+	default: return (uchar(*p) == c);
+	}
+}
+
+const char *matchbalance(MatchState *ms, const char *s, const char *p) {
+	if (p >= ms->p_end - 1)
+		luaL_error(ms->L, "malformed pattern (missing arguments to '%%b')");
+	if (*s != *p)
+		return nullptr;
+	const int b = *p;
+	const int e = *(p + 1);
+	int cont = 1;
+	while (++s < ms->src_end) {
+		if (*s == e) {
+			if (--cont == 0)
+				return s + 1;
+		} else if (*s == b) {
+			cont++;
+		}
+	}
+	return nullptr;	// string ends out of balance
+}
+
+const char *max_expand(MatchState *ms, const char *s, const char *p, const char *ep) {
+	ptrdiff_t i = 0;	// counts maximum expand for item
+	while (singlematch(ms, s + i, p, ep))
+		i++;
+	// keeps trying to match with the maximum repetitions
+	while (i >= 0) {
+		const char *res = pattern_match(ms, (s + i), ep + 1);
+		if (res)
+			return res;
+		i--;	// else didn't match; reduce 1 repetition to try again
+	}
+	return nullptr;
+}
+
+const char *min_expand(MatchState *ms, const char *s, const char *p, const char *ep) {
+	for (;;) {
+		const char *res = pattern_match(ms, s, ep + 1);
+		if (res)
+			return res;
+		else if (singlematch(ms, s, p, ep))
+			s++;	// try with one more repetition
+		else
+			return nullptr;
+	}
+}
+
+const char *start_capture(MatchState *ms, const char *s, const char *p, int what) {
+	const int level = ms->level;
+	if (level >= maxCaptures)
+		luaL_error(ms->L, "too many captures");
+	ms->capture[level].init = s;
+	ms->capture[level].len = what;
+	ms->level = static_cast<unsigned char>(level + 1);
+	const char *res = pattern_match(ms, s, p);
+	if (!res)	// match failed?
+		ms->level--;	// undo capture
+	return res;
+}
+
+const char *end_capture(MatchState *ms, const char *s, const char *p) {
+	const int l = capture_to_close(ms);
+	ms->capture[l].len = s - ms->capture[l].init;	// close capture
+	const char *res = pattern_match(ms, s, p);
+	if (!res)	// match failed?
+		ms->capture[l].len = capUnfinished;	// undo capture
+	return res;
+}
+
+const char *match_capture(MatchState *ms, const char *s, int l) {
+	l = check_capture(ms, l);
+	const size_t len = ms->capture[l].len;
+	if (static_cast<size_t>(ms->src_end - s) >= len &&
+		memcmp(ms->capture[l].init, s, len) == 0)
+		return s + len;
+	return nullptr;
+}
+
+const char *pattern_match(MatchState *ms, const char *s, const char *p) {
+	if (ms->matchdepth-- == 0)
+		luaL_error(ms->L, "pattern too complex");
+	while (p != ms->p_end) {	// end of pattern?
+		bool tail = false;	// set to continue with updated s and p
+		switch (*p) {
+		case '(':	// start capture
+			if (*(p + 1) == ')')	// position capture?
+				s = start_capture(ms, s, p + 2, capPosition);
+			else
+				s = start_capture(ms, s, p + 1, capUnfinished);
+			break;
+		case ')':	// end capture
+			s = end_capture(ms, s, p + 1);
+			break;
+		case '$':
+			if ((p + 1) == ms->p_end) {	// is the '$' the last char in pattern?
+				s = (s == ms->src_end) ? s : nullptr;	// check end of string
+				break;
+			}
+			[[fallthrough]];
+		default: {
+				if (*p == escapeChar) {	// escaped sequences not in the format class[*+?-]?
+					const char next = *(p + 1);
+					if (next == 'b') {	// balanced string?
+						s = matchbalance(ms, s, p + 2);
+						if (s) {
+							p += 4;
+							tail = true;
+						}
+						break;
+					} else if (next == 'f') {	// frontier?
+						p += 2;
+						if (*p != '[')
+							luaL_error(ms->L, "missing '[' after '%%f' in pattern");
+						const char *ep = classend(ms, p);	// points to what is next
+						const char previous = (s == ms->src_init) ? '\0' : *(s - 1);
+						if (!matchbracketclass(uchar(previous), p, ep - 1) &&
+							matchbracketclass(uchar(*s), p, ep - 1)) {
+							p = ep;
+							tail = true;
+						} else {
+							s = nullptr;	// match failed
+						}
+						break;
+					} else if (next >= '0' && next <= '9') {	// capture results (%0-%9)?
+						s = match_capture(ms, s, uchar(next));
+						if (s) {
+							p += 2;
+							tail = true;
+						}
+						break;
+					}
+				}
+				// pattern class plus optional suffix
+				const char *ep = classend(ms, p);	// points to optional suffix
+				if (!singlematch(ms, s, p, ep)) {	// does not match at least once?
+					if (*ep == '*' || *ep == '?' || *ep == '-') {	// accept empty?
+						p = ep + 1;
+						tail = true;
+					} else {	// '+' or no suffix
+						s = nullptr;	// fail
+					}
+				} else {	// matched once
+					switch (*ep) {	// handle optional suffix
+					case '?': {	// optional
+							const char *res = pattern_match(ms, s + 1, ep + 1);
+							if (res) {
+								s = res;
+							} else {
+								p = ep + 1;
+								tail = true;
+							}
+							break;
+						}
+					case '+':	// 1 or more repetitions
+						s++;	// 1 match already done
+						s = max_expand(ms, s, p, ep);
+						break;
+					case '*':	// 0 or more repetitions
+						s = max_expand(ms, s, p, ep);
+						break;
+					case '-':	// 0 or more repetitions (minimum)
+						s = min_expand(ms, s, p, ep);
+						break;
+					default:	// no suffix
+						s++;
+						p = ep;
+						tail = true;
+					}
+				}
+				break;
+			}
+		}
+		if (!tail)
+			break;
+	}
+	ms->matchdepth++;
+	return s;
+}
+
+void push_onecapture(MatchState *ms, int i, const char *s, const char *e) {
+	if (i >= ms->level) {
+		if (i == 0)	// ms->level == 0, too
+			lua_pushlstring(ms->L, s, e - s);	// add whole match
+		else
+			luaL_error(ms->L, "invalid capture index %%%d", i + 1);
+	} else {
+		const ptrdiff_t l = ms->capture[i].len;
+		if (l == capUnfinished)
+			luaL_error(ms->L, "unfinished capture");
+		if (l == capPosition)
+			lua_pushinteger(ms->L, ms->capture[i].init - ms->src_init);
+		else
+			lua_pushlstring(ms->L, ms->capture[i].init, l);
+	}
+}
+
+int push_captures(MatchState *ms, const char *s, const char *e) {
+	const int nlevels = (ms->level == 0 && s) ? 1 : ms->level;
+	luaL_checkstack(ms->L, nlevels, "too many captures");
+	for (int i = 0; i < nlevels; i++)
+		push_onecapture(ms, i, s, e);
+	return nlevels;	// number of strings pushed
+}
+
+void prepstate(MatchState *ms, lua_State *L, const char *s, size_t ls, const char *p, size_t lp) {
+	ms->L = L;
+	ms->matchdepth = maxMatchCalls;
+	ms->src_init = s;
+	ms->src_end = s + ls;
+	ms->p_end = p + lp;
+	ms->level = 0;
+}
+
+}
+
+static int view_find_aux(lua_State *L, bool find) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	size_t lp = 0;
+	const char *p = luaL_checklstring(L, 2, &lp);
+	const sptr_t init = view_position(L, 3, 0, pdv->length);
+	const char *s = pdv->text;
+	const size_t ls = pdv->length;
+	if (find && (lua_toboolean(L, 4) || !strpbrk(p, patternSpecials))) {
+		// Plain search
+		const std::string_view text(s + init, ls - init);
+		const size_t found = text.find(std::string_view(p, lp));
+		if (found != std::string_view::npos) {
+			lua_pushinteger(L, init + found);
+			lua_pushinteger(L, init + found + lp);
+			return 2;
+		}
+	} else {
+		MatchState ms;
+		const char *s1 = s + init;
+		const bool anchor = (*p == '^');
+		if (anchor) {
+			p++;
+			lp--;	// skip anchor character
+		}
+		prepstate(&ms, L, s, ls, p, lp);
+		do {
+			ms.level = 0;
+			const char *res = pattern_match(&ms, s1, p);
+			if (res) {
+				if (find) {
+					lua_pushinteger(L, s1 - s);	// start
+					lua_pushinteger(L, res - s);	// end
+					return push_captures(&ms, nullptr, nullptr) + 2;
+				} else {
+					return push_captures(&ms, s1, res);
+				}
+			}
+		} while (s1++ < ms.src_end && !anchor);
+	}
+	lua_pushnil(L);	// not found
+	return 1;
+}
+
+static int cf_view_find(lua_State *L) {
+	return view_find_aux(L, true);
+}
+
+static int cf_view_match(lua_State *L) {
+	return view_find_aux(L, false);
+}
+
+// State for gmatch held as positions so it survives validation of the view on each call
+struct ViewMatchState {
+	sptr_t position;
+	sptr_t lastMatch;
+};
+
+static int cf_view_gmatch_aux(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, lua_upvalueindex(1));
+	size_t lp = 0;
+	const char *p = lua_tolstring(L, lua_upvalueindex(2), &lp);
+	ViewMatchState *pvms = static_cast<ViewMatchState *>(lua_touserdata(L, lua_upvalueindex(3)));
+	MatchState ms;
+	prepstate(&ms, L, pdv->text, pdv->length, p, lp);
+	for (const char *src = pdv->text + pvms->position; src <= ms.src_end; src++) {
+		ms.level = 0;
+		const char *e = pattern_match(&ms, src, p);
+		if (e && (e - pdv->text != pvms->lastMatch)) {
+			pvms->position = pvms->lastMatch = e - pdv->text;
+			return push_captures(&ms, src, e);
+		}
+	}
+	return 0;	// not found
+}
+
+static int cf_view_gmatch(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	luaL_checkstring(L, 2);
+	const sptr_t init = view_position(L, 3, 0, pdv->length);
+	lua_settop(L, 2);	// view and pattern kept as upvalues so not collected
+	ViewMatchState *pvms = static_cast<ViewMatchState *>(lua_newuserdata(L, sizeof(ViewMatchState)));
+	pvms->position = init;
+	pvms->lastMatch = -1;
+	lua_pushcclosure(L, cf_view_gmatch_aux, 3);
+	return 1;
+}
+
+static int cf_view_sub(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	const sptr_t start = view_position(L, 2, 0, pdv->length);
+	const sptr_t end = view_position(L, 3, pdv->length, pdv->length);
+	if (end > start)
+		lua_pushlstring(L, pdv->text + start, end - start);
+	else
+		lua_pushliteral(L, "");
+	return 1;
+}
+
+static int cf_view_byte(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	const lua_Integer position = luaL_checkinteger(L, 2);
+	if (position >= 0 && position < pdv->length)
+		lua_pushinteger(L, uchar(pdv->text[position]));
+	else
+		lua_pushnil(L);
+	return 1;
+}
+
+static bool push_view_line(lua_State *L, const DocumentView *pdv, lua_Integer line) {
+	if (line < 0 || line >= host->Send(pdv->pane, SCI_GETLINECOUNT))
+		return false;
+	const sptr_t start = host->Send(pdv->pane, SCI_POSITIONFROMLINE, static_cast<uptr_t>(line));
+	const sptr_t end = host->Send(pdv->pane, SCI_GETLINEENDPOSITION, static_cast<uptr_t>(line));
+	lua_pushlstring(L, pdv->text + start, end - start);
+	return true;
+}
+
+// Text of a line without its line end
+static int cf_view_line(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	if (!push_view_line(L, pdv, luaL_checkinteger(L, 2)))
+		lua_pushnil(L);
+	return 1;
+}
+
+static int cf_view_lines_aux(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, lua_upvalueindex(1));
+	const lua_Integer line = lua_tointeger(L, lua_upvalueindex(2));
+	const lua_Integer lineLast = lua_tointeger(L, lua_upvalueindex(3));
+	if (line > lineLast)
+		return 0;
+	lua_pushinteger(L, line);
+	if (!push_view_line(L, pdv, line))
+		return 0;
+	lua_pushinteger(L, line + 1);
+	lua_replace(L, lua_upvalueindex(2));
+	return 2;
+}
+
+// Iterate over lines returning line number and text without line end
+static int cf_view_lines(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	const lua_Integer lineFirst = luaL_optinteger(L, 2, 0);
+	const lua_Integer lineLast = luaL_optinteger(L, 3, host->Send(pdv->pane, SCI_GETLINECOUNT) - 1);
+	lua_settop(L, 1);
+	lua_pushinteger(L, lineFirst);
+	lua_pushinteger(L, lineLast);
+	lua_pushcclosure(L, cf_view_lines_aux, 3);
+	return 1;
+}
+
+static int cf_view_metatable_index(lua_State *L) {
+	if (lua_isnumber(L, 2)) {
+		return cf_view_byte(L);
+	} else if (lua_isstring(L, 2)) {
+		lua_getmetatable(L, 1);
+		lua_pushvalue(L, 2);
+		lua_rawget(L, -2);
+		if (lua_iscfunction(L, -1))
+			return 1;
+	}
+	raise_error(L, "Invalid method name or position for document view.");
+	return 0;
+}
+
+static int cf_view_metatable_len(lua_State *L) {
+	const DocumentView *pdv = check_view_object(L, 1);
+	lua_pushinteger(L, pdv->length);
+	return 1;
+}
+
+static int push_view_object(lua_State *L, ExtensionAPI::Pane p) {
+	DocumentView *pdv = static_cast<DocumentView *>(lua_newuserdata(L, sizeof(DocumentView)));
+	pdv->pane = p;
+	pdv->doc = host->Send(p, SCI_GETDOCPOINTER);
+	pdv->revision = host->Revision(p);
+	pdv->text = reinterpret_cast<const char *>(host->Send(p, SCI_GETCHARACTERPOINTER));
+	pdv->length = host->Send(p, SCI_GETLENGTH);
+	if (luaL_newmetatable(L, "SciTE_MT_DocumentView")) {
+		lua_pushcfunction(L, cf_view_metatable_index);
+		lua_setfield(L, -2, "__index");
+		lua_pushcfunction(L, cf_view_metatable_len);
+		lua_setfield(L, -2, "__len");
+
+		lua_pushcfunction(L, cf_view_sub);
+		lua_setfield(L, -2, "sub");
+		lua_pushcfunction(L, cf_view_byte);
+		lua_setfield(L, -2, "byte");
+		lua_pushcfunction(L, cf_view_line);
+		lua_setfield(L, -2, "line");
+		lua_pushcfunction(L, cf_view_lines);
+		lua_setfield(L, -2, "lines");
+		lua_pushcfunction(L, cf_view_find);
+		lua_setfield(L, -2, "find");
+		lua_pushcfunction(L, cf_view_match);
+		lua_setfield(L, -2, "match");
+		lua_pushcfunction(L, cf_view_gmatch);
+		lua_setfield(L, -2, "gmatch");
+	}
+	lua_setmetatable(L, -2);
+	return 1;
+}
+
 static int cf_props_metatable_index(lua_State *L) {
 	const int selfArg = lua_isuserdata(L, 1) ? 1 : 0;
 
@@ -746,6 +1345,232 @@ static int cf_global_dostring(lua_State *L) {
 	return 0;
 }
 
+// Allocator for the main Lua state.  Event handlers like OnUpdateUI and OnChar run
+// often and mostly allocate small strings, tables, and closures so blocks up to
+// 256 bytes are taken from a free list for each 16 byte size class, carved from
+// 64K slabs.  Larger blocks use the C library.  Not thread safe so worker states
+// use the default allocator.
+
+class LuaPoolAllocator {
+	static constexpr size_t granularity = 16;
+	static constexpr size_t sizePooledMax = 256;
+	static constexpr size_t sizeClasses = sizePooledMax / granularity;
+	static constexpr size_t slabSize = 64 * 1024;
+	struct FreeBlock {
+		FreeBlock *next;
+	};
+	FreeBlock *freeLists[sizeClasses] {};
+	std::vector<std::unique_ptr<char[]>> slabs;
+	char *slabNext = nullptr;
+	size_t slabLeft = 0;
+
+	static size_t SizeClass(size_t size) noexcept {
+		return (size - 1) / granularity;
+	}
+	void *Allocate(size_t size) noexcept;
+	void Free(void *p, size_t size) noexcept;
+	void *Reallocate(void *p, size_t sizeOld, size_t sizeNew) noexcept;
+public:
+	size_t bytesInUse = 0;
+	size_t bytesAllocated = 0;	// Total of all allocations
+	size_t allocations = 0;
+
+	size_t SlabBytes() const noexcept {
+		return slabs.size() * slabSize;
+	}
+	// lua_Alloc
+	static void *Alloc(void *ud, void *ptr, size_t osize, size_t nsize) noexcept {
+		// When ptr is null, osize is the type of object being allocated
+		return static_cast<LuaPoolAllocator *>(ud)->Reallocate(ptr, ptr ? osize : 0, nsize);
+	}
+};
+
+void *LuaPoolAllocator::Allocate(size_t size) noexcept {
+	void *p = nullptr;
+	if (size > sizePooledMax) {
+		p = malloc(size);
+	} else {
+		const size_t sizeClass = SizeClass(size);
+		if (freeLists[sizeClass]) {
+			p = freeLists[sizeClass];
+			freeLists[sizeClass] = freeLists[sizeClass]->next;
+		} else {
+			const size_t sizeBlock = (sizeClass + 1) * granularity;
+			if (slabLeft < sizeBlock) {
+				try {
+					slabs.push_back(std::unique_ptr<char[]>(new char[slabSize]));
+				} catch (std::bad_alloc &) {
+					return nullptr;
+				}
+				slabNext = slabs.back().get();
+				slabLeft = slabSize;
+			}
+			p = slabNext;
+			slabNext += sizeBlock;
+			slabLeft -= sizeBlock;
+		}
+	}
+	if (p) {
+		bytesInUse += size;
+		bytesAllocated += size;
+		allocations++;
+	}
+	return p;
+}
+
+void LuaPoolAllocator::Free(void *p, size_t size) noexcept {
+	bytesInUse -= size;
+	if (size > sizePooledMax) {
+		free(p);
+	} else {
+		FreeBlock *block = static_cast<FreeBlock *>(p);
+		const size_t sizeClass = SizeClass(size);
+		block->next = freeLists[sizeClass];
+		freeLists[sizeClass] = block;
+	}
+}
+
+void *LuaPoolAllocator::Reallocate(void *p, size_t sizeOld, size_t sizeNew) noexcept {
+	if (sizeNew == 0) {
+		if (p)
+			Free(p, sizeOld);
+		return nullptr;
+	}
+	if (!p)
+		return Allocate(sizeNew);
+	// Lua assumes shrinking never fails so a block that can not move stays where it is.
+	// A block is freed by the size class of the size Lua last asked for and any block
+	// at least that large can serve that class.
+	if ((sizeOld > sizePooledMax) && (sizeNew > sizePooledMax)) {
+		void *pNew = realloc(p, sizeNew);
+		if (!pNew) {
+			if (sizeNew > sizeOld)
+				return nullptr;
+			pNew = p;
+		}
+		bytesInUse = bytesInUse - sizeOld + sizeNew;
+		if (sizeNew > sizeOld)
+			bytesAllocated += sizeNew - sizeOld;
+		return pNew;
+	}
+	if ((sizeOld <= sizePooledMax) && (sizeNew <= sizeOld)) {
+		// Block is already large enough so stays in its size class
+		bytesInUse = bytesInUse - sizeOld + sizeNew;
+		return p;
+	}
+	if ((sizeOld <= sizePooledMax) && (SizeClass(sizeOld) == SizeClass(sizeNew))) {
+		bytesInUse = bytesInUse - sizeOld + sizeNew;
+		bytesAllocated += sizeNew - sizeOld;
+		return p;
+	}
+	void *pNew = Allocate(sizeNew);
+	if (pNew) {
+		memcpy(pNew, p, std::min(sizeOld, sizeNew));
+		Free(p, sizeOld);
+	} else if (sizeNew < sizeOld) {
+		// Large block becomes small, keep it rather than fail
+		bytesInUse = bytesInUse - sizeOld + sizeNew;
+		return p;
+	}
+	return pNew;
+}
+
+static std::unique_ptr<LuaPoolAllocator> luaAllocator;
+
+// Statistics reported by scite.LuaStats
+// Collector pauses are not timed on their own as Lua 5.3 performs incremental steps
+// inside allocations without any hook, so their cost is part of the handler times.
+
+struct HandlerStatistics {
+	size_t calls = 0;
+	double total = 0.0;
+	double longestCall = 0.0;	// Run time of the slowest call including any collection steps
+	size_t allocated = 0;
+};
+
+static std::map<std::string, HandlerStatistics> handlerStatistics;
+static size_t gcCycles = 0;
+
+// Measures an event handler call from construction to destruction
+class HandlerTiming {
+	const char *name;
+	GUI::ElapsedTime et;
+	size_t allocatedStart;
+public:
+	explicit HandlerTiming(const char *name_) :
+		name(name_), allocatedStart(luaAllocator ? luaAllocator->bytesAllocated : 0) {
+	}
+	// Deleted so HandlerTiming objects can not be copied.
+	HandlerTiming(const HandlerTiming &) = delete;
+	void operator=(const HandlerTiming &) = delete;
+	~HandlerTiming() {
+		const double duration = et.Duration();
+		HandlerStatistics &hs = handlerStatistics[name];
+		hs.calls++;
+		hs.total += duration;
+		hs.longestCall = std::max(hs.longestCall, duration);
+		if (luaAllocator)
+			hs.allocated += luaAllocator->bytesAllocated - allocatedStart;
+	}
+};
+
+// A finalizer is called once per garbage collection cycle on an unreachable object
+// which then creates its replacement to count the next cycle.
+static void push_gc_sentinel(lua_State *L);
+
+static int cf_gc_sentinel(lua_State *L) {
+	gcCycles++;
+	// Finalizers run on whichever thread, possibly a coroutine, made the collector step.
+	// luaState is cleared before the state is closed.
+	if (luaState) {
+		push_gc_sentinel(L);
+	}
+	return 0;
+}
+
+static void push_gc_sentinel(lua_State *L) {
+	lua_newuserdata(L, 1);
+	if (luaL_newmetatable(L, "SciTE_MT_GCSentinel")) {
+		lua_pushcfunction(L, cf_gc_sentinel);
+		lua_setfield(L, -2, "__gc");
+	}
+	lua_setmetatable(L, -2);
+	lua_pop(L, 1);
+}
+
+static void set_field_integer(lua_State *L, const char *name, size_t value) {
+	lua_pushinteger(L, static_cast<lua_Integer>(value));
+	lua_setfield(L, -2, name);
+}
+
+static void set_field_number(lua_State *L, const char *name, double value) {
+	lua_pushnumber(L, value);
+	lua_setfield(L, -2, name);
+}
+
+static int cf_scite_lua_stats(lua_State *L) {
+	lua_newtable(L);
+	if (luaAllocator) {
+		set_field_integer(L, "bytes", luaAllocator->bytesInUse);
+		set_field_integer(L, "allocated", luaAllocator->bytesAllocated);
+		set_field_integer(L, "allocations", luaAllocator->allocations);
+		set_field_integer(L, "pooled", luaAllocator->SlabBytes());
+	}
+	set_field_integer(L, "gccycles", gcCycles);
+	lua_newtable(L);
+	for (const std::pair<const std::string, HandlerStatistics> &handler : handlerStatistics) {
+		// Times are in milliseconds
+		lua_newtable(L);
+		set_field_integer(L, "calls", handler.second.calls);
+		set_field_number(L, "total", handler.second.total * 1000.0);
+		set_field_number(L, "longestcall", handler.second.longestCall * 1000.0);
+		set_field_integer(L, "allocated", handler.second.allocated);
+		lua_setfield(L, -2, handler.first.c_str());
+	}
+	lua_setfield(L, -2, "handlers");
+	return 1;
+}
+
 static bool call_function(lua_State *L, int nargs, bool ignoreFunctionReturnValue=false) {
 	bool handled = false;
 	if (L) {
@@ -806,6 +1631,7 @@ static bool CallNamedFunction(const char *name) {
 	bool handled = false;
 	if (luaState) {
 		if (lua_getglobal(luaState, name) != LUA_TNIL) {
+			const HandlerTiming timing(name);
 			handled = call_function(luaState, 0);
 		} else {
 			lua_pop(luaState, 1);
@@ -818,6 +1644,7 @@ static bool CallNamedFunction(const char *name, const char *arg) {
 	bool handled = false;
 	if (luaState) {
 		if (lua_getglobal(luaState, name) != LUA_TNIL) {
+			const HandlerTiming timing(name);
 			lua_pushstring(luaState, arg);
 			handled = call_function(luaState, 1);
 		} else {
@@ -831,6 +1658,7 @@ static bool CallNamedFunction(const char *name, int numberArg, const char *strin
 	bool handled = false;
 	if (luaState) {
 		if (lua_getglobal(luaState, name) != LUA_TNIL) {
+			const HandlerTiming timing(name);
 			lua_pushinteger(luaState, numberArg);
 			lua_pushstring(luaState, stringArg);
 			handled = call_function(luaState, 2);
@@ -845,6 +1673,7 @@ static bool CallNamedFunction(const char *name, int numberArg, int numberArg2) {
 	bool handled = false;
 	if (luaState) {
 		if (lua_getglobal(luaState, name) != LUA_TNIL) {
+			const HandlerTiming timing(name);
 			lua_pushinteger(luaState, numberArg);
 			lua_pushinteger(luaState, numberArg2);
 			handled = call_function(luaState, 2);
@@ -1014,24 +1843,17 @@ static int push_iface_function(lua_State *L, const char *name) {
 		if (IFaceFunctionIsScriptable(IFaceTable::functions[i])) {
 			lua_pushlightuserdata(L, const_cast<IFaceFunction *>(IFaceTable::functions+i));
 			lua_pushcclosure(L, cf_pane_iface_function, 1);
-
-			// Since Lua experts say it is inefficient to create closures / cfunctions
-			// in an inner loop, I tried caching the closures in the metatable, and looking
-			// for them there first.  However, it made very little difference and did not
-			// seem worth the added complexity. - WBD
-
 			return 1;
 		}
 	}
 	return -1; // signal to try next pane index handler
 }
 
-static int push_iface_propval(lua_State *L, const char *name) {
+static int push_iface_propval(lua_State *L, const IFaceProperty *pprop) {
 	// this function doesn't raise errors, but returns 0 if the function is not handled.
 
-	const int propidx = IFaceTable::FindProperty(name);
-	if (propidx >= 0) {
-		const IFaceProperty &prop = IFaceTable::properties[propidx];
+	if (pprop) {
+		const IFaceProperty &prop = *pprop;
 		if (!IFacePropertyIsScriptable(prop)) {
 			raise_error(L, "Error: iface property is not scriptable.");
 			return -1;
@@ -1088,14 +1910,52 @@ static int push_iface_propval(lua_State *L, const char *name) {
 	return -1; // signal to try next pane index handler
 }
 
+// Names resolved against IFaceTable are remembered in a cache table shared by the
+// pane __index and __newindex closures: iface functions as the closure to return and
+// properties as a light userdata pointing to their IFaceProperty.
+
+static const IFaceProperty *cached_iface_property(lua_State *L, const char *name) {
+	const int cacheIndex = lua_upvalueindex(1);
+	lua_pushvalue(L, 2);
+	if (lua_rawget(L, cacheIndex) == LUA_TLIGHTUSERDATA) {
+		const IFaceProperty *prop = static_cast<const IFaceProperty *>(lua_touserdata(L, -1));
+		lua_pop(L, 1);
+		return prop;
+	}
+	lua_pop(L, 1);
+	const int propidx = IFaceTable::FindProperty(name);
+	if (propidx < 0)
+		return nullptr;
+	const IFaceProperty *prop = IFaceTable::properties + propidx;
+	lua_pushvalue(L, 2);
+	lua_pushlightuserdata(L, const_cast<IFaceProperty *>(prop));
+	lua_rawset(L, cacheIndex);
+	return prop;
+}
+
 static int cf_pane_metatable_index(lua_State *L) {
 	if (lua_isstring(L, 2)) {
 		const char *name = lua_tostring(L, 2);
 
+		if (0 == strcmp(name, "view")) {
+			return push_view_object(L, check_pane_object(L, 1));
+		}
+
+		const int cacheIndex = lua_upvalueindex(1);
+		lua_pushvalue(L, 2);
+		if (lua_rawget(L, cacheIndex) == LUA_TFUNCTION)
+			return 1;
+		lua_pop(L, 1);
+
 		// these return the number of values pushed (possibly 0), or -1 if no match
 		int results = push_iface_function(L, name);
-		if (results < 0)
-			results = push_iface_propval(L, name);
+		if (results > 0) {
+			lua_pushvalue(L, 2);
+			lua_pushvalue(L, -2);
+			lua_rawset(L, cacheIndex);
+		} else {
+			results = push_iface_propval(L, cached_iface_property(L, name));
+		}
 
 		if (results >= 0) {
 			return results;
@@ -1116,9 +1976,9 @@ static int cf_pane_metatable_index(lua_State *L) {
 
 static int cf_pane_metatable_newindex(lua_State *L) {
 	if (lua_isstring(L, 2)) {
-		const int propidx = IFaceTable::FindProperty(lua_tostring(L, 2));
-		if (propidx >= 0) {
-			const IFaceProperty &prop = IFaceTable::properties[propidx];
+		const IFaceProperty *pprop = cached_iface_property(L, lua_tostring(L, 2));
+		if (pprop) {
+			const IFaceProperty &prop = *pprop;
 			if (IFacePropertyIsScriptable(prop)) {
 				if (prop.setter) {
 					// stack needs to be rearranged to look like an iface function call
@@ -1155,9 +2015,11 @@ static int cf_pane_metatable_newindex(lua_State *L) {
 void push_pane_object(lua_State *L, ExtensionAPI::Pane p) {
 	*static_cast<ExtensionAPI::Pane *>(lua_newuserdata(L, sizeof(p))) = p;
 	if (luaL_newmetatable(L, "SciTE_MT_Pane")) {
-		lua_pushcfunction(L, cf_pane_metatable_index);
-		lua_setfield(L, -2, "__index");
-		lua_pushcfunction(L, cf_pane_metatable_newindex);
+		lua_newtable(L);	// Cache of resolved iface names
+		lua_pushvalue(L, -1);
+		lua_pushcclosure(L, cf_pane_metatable_index, 1);
+		lua_setfield(L, -3, "__index");
+		lua_pushcclosure(L, cf_pane_metatable_newindex, 1);
 		lua_setfield(L, -2, "__newindex");
 
 		// Push built-in functions into the metatable, where the custom
@@ -1215,14 +2077,591 @@ static int cf_global_metatable_index(lua_State *L) {
 
 static int LuaPanicFunction(lua_State *L) {
 	if (L == luaState) {
-		lua_close(luaState);
 		luaState = nullptr;
+		lua_close(L);
+		luaAllocator.reset();
 		luaDisabled = true;
 	}
 	host->Trace("\n> Lua: error occurred in unprotected call.  This is very bad.\n");
 	return 1;
 }
 
+// Background workers.
+// scite.Spawn(func, ...) runs func with copies of the arguments in a separate Lua
+// state on a worker thread.  The function is transferred as bytecode so it may use
+// globals but not local variables of enclosing functions.  Values passed between
+// states are serialised and may be nil, booleans, numbers, strings, or tables of
+// these.  A document view is passed as a string snapshot of the document.
+// Worker states can read files but have no access to panes or properties: only the
+// main state touches the user interface.  Messages sent by scite.Post in a worker
+// and the worker's return values are delivered to OnWorkerResult(id, status, ...)
+// where status is "message", "done", or "error".
+
+namespace {
+
+constexpr int maxSerialDepth = 100;
+constexpr char messagePosted = 'm';
+constexpr char messageDone = 'd';
+constexpr char messageError = 'e';
+
+const char *valueNotTransferable =
+	"Only nil, boolean, number, string, and table values can be passed between Lua states.";
+
+template <typename T>
+void AppendBytes(std::string &out, T value) {
+	out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void AppendString(std::string &out, const char *s, size_t len) {
+	out += 's';
+	AppendBytes(out, len);
+	out.append(s, len);
+}
+
+// Returns an error message if the value can not be serialised.
+// Does not raise Lua errors so callers can release resources before reporting.
+const char *SerialiseValue(lua_State *L, int index, std::string &out, int depth) {
+	index = absolute_index(L, index);
+	switch (lua_type(L, index)) {
+	case LUA_TNIL:
+		out += 'n';
+		break;
+	case LUA_TBOOLEAN:
+		out += lua_toboolean(L, index) ? 't' : 'f';
+		break;
+	case LUA_TNUMBER:
+		if (lua_isinteger(L, index)) {
+			out += 'i';
+			AppendBytes(out, lua_tointeger(L, index));
+		} else {
+			out += 'r';
+			AppendBytes(out, lua_tonumber(L, index));
+		}
+		break;
+	case LUA_TSTRING: {
+			size_t len = 0;
+			const char *s = lua_tolstring(L, index, &len);
+			AppendString(out, s, len);
+		}
+		break;
+	case LUA_TTABLE:
+		if (depth >= maxSerialDepth || !lua_checkstack(L, 3))
+			return "Tables passed between Lua states are nested too deeply or are recursive.";
+		out += '{';
+		lua_pushnil(L);
+		while (lua_next(L, index)) {
+			const char *failure = SerialiseValue(L, -2, out, depth + 1);
+			if (!failure)
+				failure = SerialiseValue(L, -1, out, depth + 1);
+			if (failure) {
+				lua_pop(L, 2);
+				return failure;
+			}
+			lua_pop(L, 1);
+		}
+		out += '}';
+		break;
+	case LUA_TUSERDATA:
+		if (const DocumentView *pdv = static_cast<DocumentView *>(checkudata(L, index, "SciTE_MT_DocumentView"))) {
+			if (!view_valid(pdv))
+				return "Blocked attempt to use invalidated document view.";
+			AppendString(out, pdv->text, pdv->length);
+			break;
+		}
+		return valueNotTransferable;
+	default:
+		return valueNotTransferable;
+	}
+	return nullptr;
+}
+
+const char *SerialiseValues(lua_State *L, int first, std::string &out) {
+	const int top = lua_gettop(L);
+	for (int index = first; index <= top; index++) {
+		const char *failure = SerialiseValue(L, index, out, 0);
+		if (failure)
+			return failure;
+	}
+	return nullptr;
+}
+
+template <typename T>
+bool ReadBytes(const char *&p, const char *end, T &value) {
+	if (static_cast<size_t>(end - p) < sizeof(value))
+		return false;
+	memcpy(&value, p, sizeof(value));
+	p += sizeof(value);
+	return true;
+}
+
+// Pushes one value, returning false if the data is malformed.
+bool DeserialiseValue(lua_State *L, const char *&p, const char *end) {
+	if (p >= end || !lua_checkstack(L, 3))
+		return false;
+	switch (*p++) {
+	case 'n':
+		lua_pushnil(L);
+		return true;
+	case 'f':
+		lua_pushboolean(L, 0);
+		return true;
+	case 't':
+		lua_pushboolean(L, 1);
+		return true;
+	case 'i': {
+			lua_Integer value = 0;
+			if (!ReadBytes(p, end, value))
+				return false;
+			lua_pushinteger(L, value);
+			return true;
+		}
+	case 'r': {
+			lua_Number value = 0;
+			if (!ReadBytes(p, end, value))
+				return false;
+			lua_pushnumber(L, value);
+			return true;
+		}
+	case 's': {
+			size_t len = 0;
+			if (!ReadBytes(p, end, len) || (static_cast<size_t>(end - p) < len))
+				return false;
+			lua_pushlstring(L, p, len);
+			p += len;
+			return true;
+		}
+	case '{':
+		lua_newtable(L);
+		while (p < end && *p != '}') {
+			if (!DeserialiseValue(L, p, end) || !DeserialiseValue(L, p, end))
+				return false;
+			lua_rawset(L, -3);
+		}
+		if (p >= end)
+			return false;
+		p++;
+		return true;
+	}
+	return false;
+}
+
+// Pushes all values in data returning their count or -1 if malformed.
+int DeserialiseValues(lua_State *L, const char *p, const char *end) {
+	int count = 0;
+	while (p < end) {
+		if (!DeserialiseValue(L, p, end))
+			return -1;
+		count++;
+	}
+	return count;
+}
+
+int StringWriter(lua_State *, const void *p, size_t sz, void *ud) {
+	static_cast<std::string *>(ud)->append(static_cast<const char *>(p), sz);
+	return 0;
+}
+
+class LuaJob : public Worker {
+	std::mutex mutexMessages;
+	std::condition_variable finishing;	///< Signalled when the final message is posted
+	std::vector<std::string> messages;
+	bool posted;
+	bool finished;
+	bool cancelled;
+	bool abandoned;	///< Main thread stopped waiting so the worker thread frees the job
+public:
+	int id;
+	lua_State *L;
+	std::string code;
+	std::string arguments;
+
+	explicit LuaJob(int id_) : posted(false), finished(false), cancelled(false), abandoned(false), id(id_), L(nullptr) {
+	}
+	void Execute() override;
+	void Cancel() override;
+	// Ask the job to stop and wait up to timeout for it to finish, returning whether it did.
+	// When it did not, the job is abandoned to the worker thread which frees it and its state.
+	bool CancelAndWait(std::chrono::milliseconds timeout);
+	bool Cancelled();
+	// Called on the worker thread to queue a message, waking the main thread if needed.
+	// Returns true when the job has been abandoned so the main thread no longer uses it.
+	bool Post(std::string &&message, bool final);
+	// Called on the main thread to retrieve messages
+	std::vector<std::string> TakeMessages(bool &final);
+};
+
+void LuaJob::Execute() {
+	std::string result(1, messageDone);
+	int status = LUA_ERRRUN;
+	if (Cancelled())
+		lua_pushliteral(L, "worker cancelled");
+	else
+		status = luaL_loadbufferx(L, code.data(), code.size(), "=spawn", "b");
+	if (status == LUA_OK) {
+		const int nargs = DeserialiseValues(L, arguments.data(), arguments.data() + arguments.size());
+		status = lua_pcall(L, (nargs < 0) ? 0 : nargs, LUA_MULTRET, 0);
+	}
+	const char *failure = nullptr;
+	if (status == LUA_OK) {
+		failure = SerialiseValues(L, 1, result);
+	} else {
+		failure = lua_tostring(L, -1);
+		if (!failure)
+			failure = "error object is not a string";
+	}
+	if (failure) {
+		result.assign(1, messageError);
+		AppendString(result, failure, strlen(failure));
+	}
+	lua_settop(L, 0);
+	SetCompleted();
+	// The main thread may destroy the job once it has the final message so
+	// this must be the last access to the job unless it was abandoned.
+	if (Post(std::move(result), true)) {
+		lua_close(L);
+		delete this;
+	}
+}
+
+void LuaJob::Cancel() {
+	CancelAndWait(std::chrono::milliseconds(2000));
+}
+
+bool LuaJob::CancelAndWait(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(mutexMessages);
+	cancelled = true;
+	// Wait for the final message as the worker thread may still be posting it.
+	// A job blocked in a C function such as a read notices only when that returns.
+	const bool stopped = finishing.wait_for(lock, timeout, [this]() noexcept { return finished; });
+	abandoned = !stopped;
+	return stopped;
+}
+
+bool LuaJob::Cancelled() {
+	std::lock_guard<std::mutex> lock(mutexMessages);
+	return cancelled;
+}
+
+bool LuaJob::Post(std::string &&message, bool final) {
+	std::lock_guard<std::mutex> lock(mutexMessages);
+	// The host may already be gone
+	if (abandoned)
+		return true;
+	messages.push_back(std::move(message));
+	finished = final;
+	if (final) {
+		finishing.notify_all();
+	}
+	if (!posted) {
+		posted = true;
+		host->PostOnMainThread(WORK_EXTENSION, this);
+	}
+	return false;
+}
+
+std::vector<std::string> LuaJob::TakeMessages(bool &final) {
+	std::lock_guard<std::mutex> lock(mutexMessages);
+	posted = false;
+	final = finished;
+	std::vector<std::string> taken;
+	taken.swap(messages);
+	return taken;
+}
+
+// A few threads that run jobs one after another so each job does not start a thread.
+// Threads are started on demand up to the worker limit and then wait for more jobs.
+// The queue is shared with the threads so a thread left running an abandoned job
+// can still use it after the pool has stopped.
+class WorkerPool {
+	struct Queue {
+		std::mutex mutexQueue;
+		std::condition_variable queued;
+		std::deque<LuaJob *> jobs;
+		size_t idle = 0;
+		bool stopping = false;
+	};
+	std::shared_ptr<Queue> queue;
+	std::vector<std::thread> threads;
+	static void Run(std::shared_ptr<Queue> queue);
+public:
+	WorkerPool() = default;
+	// Deleted so WorkerPool objects can not be copied.
+	WorkerPool(const WorkerPool &) = delete;
+	WorkerPool(WorkerPool &&) = delete;
+	WorkerPool &operator=(const WorkerPool &) = delete;
+	WorkerPool &operator=(WorkerPool &&) = delete;
+	~WorkerPool();
+	// Returns false when no thread could run the job
+	bool Submit(LuaJob *job, size_t threadsMax);
+	// Joins the threads or, when some may still be running a job, leaves them behind
+	void Stop(bool join);
+};
+
+void WorkerPool::Run(std::shared_ptr<Queue> queue) {
+	std::unique_lock<std::mutex> lock(queue->mutexQueue);
+	for (;;) {
+		queue->idle++;
+		queue->queued.wait(lock, [&queue]() noexcept { return queue->stopping || !queue->jobs.empty(); });
+		queue->idle--;
+		if (queue->stopping)
+			return;
+		LuaJob *job = queue->jobs.front();
+		queue->jobs.pop_front();
+		lock.unlock();
+		job->Execute();
+		lock.lock();
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	Stop(true);
+}
+
+bool WorkerPool::Submit(LuaJob *job, size_t threadsMax) {
+	if (!queue)
+		queue = std::make_shared<Queue>();
+	std::lock_guard<std::mutex> lock(queue->mutexQueue);
+	if ((queue->idle <= queue->jobs.size()) && (threads.size() < threadsMax)) {
+		try {
+			threads.emplace_back(&WorkerPool::Run, queue);
+		} catch (const std::system_error &) {
+			if (threads.empty())
+				return false;
+		}
+	}
+	queue->jobs.push_back(job);
+	queue->queued.notify_one();
+	return true;
+}
+
+void WorkerPool::Stop(bool join) {
+	if (!queue)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(queue->mutexQueue);
+		queue->stopping = true;
+		queue->jobs.clear();
+	}
+	queue->queued.notify_all();
+	for (std::thread &thread : threads) {
+		if (join)
+			thread.join();
+		else
+			thread.detach();
+	}
+	threads.clear();
+	queue.reset();
+}
+
+}
+
+static WorkerPool workerPool;
+static std::vector<lua_State *> workerStatesIdle;
+static std::vector<std::unique_ptr<LuaJob>> jobsRunning;
+static std::deque<std::unique_ptr<LuaJob>> jobsQueued;
+static int jobIdLast = 0;
+
+static LuaJob *job_of_state(lua_State *L) {
+	lua_getfield(L, LUA_REGISTRYINDEX, "SciTE_WorkerJob");
+	LuaJob *job = static_cast<LuaJob *>(lua_touserdata(L, -1));
+	lua_pop(L, 1);
+	return job;
+}
+
+// Abandon long running jobs when SciTE is closing
+static void cf_worker_hook(lua_State *L, lua_Debug *) {
+	LuaJob *job = job_of_state(L);
+	if (job && job->Cancelled()) {
+		raise_error(L, "Worker cancelled.");
+	}
+}
+
+static int cf_worker_post(lua_State *L) {
+	LuaJob *job = job_of_state(L);
+	const char *failure = nullptr;
+	{
+		std::string message(1, messagePosted);
+		failure = SerialiseValues(L, 1, message);
+		if (!failure && job)
+			job->Post(std::move(message), false);
+	}
+	if (failure)
+		raise_error(L, failure);
+	return 0;
+}
+
+static int cf_worker_open(lua_State *L) {
+	const char *mode = luaL_optstring(L, 2, "r");
+	if (strpbrk(mode, "wa+")) {
+		raise_error(L, "Workers may only open files for reading.");
+	}
+	lua_pushvalue(L, lua_upvalueindex(1));
+	lua_insert(L, 1);
+	lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+	return lua_gettop(L);
+}
+
+static void remove_fields(lua_State *L, const char *table, std::initializer_list<const char *> names) {
+	lua_getglobal(L, table);
+	for (const char *name : names) {
+		lua_pushnil(L);
+		lua_setfield(L, -2, name);
+	}
+	lua_pop(L, 1);
+}
+
+// The standard libraries except debug, which could retrieve the functions removed
+// from the worker sandbox through upvalues.
+static const luaL_Reg workerLibs[] = {
+	{"_G", luaopen_base},
+	{LUA_LOADLIBNAME, luaopen_package},
+	{LUA_COLIBNAME, luaopen_coroutine},
+	{LUA_TABLIBNAME, luaopen_table},
+	{LUA_IOLIBNAME, luaopen_io},
+	{LUA_OSLIBNAME, luaopen_os},
+	{LUA_STRLIBNAME, luaopen_string},
+	{LUA_MATHLIBNAME, luaopen_math},
+	{LUA_UTF8LIBNAME, luaopen_utf8},
+#if defined(LUA_COMPAT_BITLIB)
+	{LUA_BITLIBNAME, luaopen_bit32},
+#endif
+};
+
+static lua_State *NewWorkerState() {
+	lua_State *L = luaL_newstate();
+	if (!L)
+		return nullptr;
+	lua_atpanic(L, LuaPanicFunction);
+	for (const luaL_Reg &lib : workerLibs) {
+		luaL_requiref(L, lib.name, lib.func, 1);
+		lua_pop(L, 1);
+	}
+
+	// Workers may read files but not change them or run other programs
+	remove_fields(L, "io", { "popen", "output", "write", "tmpfile" });
+	remove_fields(L, "os", { "execute", "exit", "remove", "rename", "tmpname", "setlocale" });
+	remove_fields(L, "package", { "loadlib", "cpath" });
+	// Only the preload and Lua searchers remain so require can not load native modules
+	lua_getglobal(L, "package");
+	lua_getfield(L, -1, "searchers");
+	for (lua_Integer searcher = luaL_len(L, -1); searcher > 2; searcher--) {
+		lua_pushnil(L);
+		lua_seti(L, -2, searcher);
+	}
+	lua_pop(L, 2);
+	lua_getglobal(L, "io");
+	lua_getfield(L, -1, "open");
+	lua_pushcclosure(L, cf_worker_open, 1);
+	lua_setfield(L, -2, "open");
+	lua_pop(L, 1);
+
+	lua_newtable(L);
+	lua_pushcfunction(L, cf_worker_post);
+	lua_setfield(L, -2, "Post");
+	lua_setglobal(L, "scite");
+
+	lua_sethook(L, cf_worker_hook, LUA_MASKCOUNT, 10000);
+	return L;
+}
+
+static void StartJobs() {
+	int workersMax = GetPropertyInt("ext.lua.workers");
+	if (workersMax <= 0)
+		workersMax = 4;
+	while (!jobsQueued.empty() && (jobsRunning.size() < static_cast<size_t>(workersMax))) {
+		lua_State *L = nullptr;
+		if (workerStatesIdle.empty()) {
+			L = NewWorkerState();
+			if (!L) {
+				host->Trace("> Lua: worker state failed to initialise\n");
+				return;
+			}
+		} else {
+			L = workerStatesIdle.back();
+			workerStatesIdle.pop_back();
+		}
+		LuaJob *job = jobsQueued.front().get();
+		jobsRunning.push_back(std::move(jobsQueued.front()));
+		jobsQueued.pop_front();
+		job->L = L;
+		lua_pushlightuserdata(L, job);
+		lua_setfield(L, LUA_REGISTRYINDEX, "SciTE_WorkerJob");
+		if (!workerPool.Submit(job, static_cast<size_t>(workersMax))) {
+			// Still produces a result, just not in the background
+			job->Execute();
+		}
+	}
+}
+
+static void CloseWorkers() {
+	jobsQueued.clear();
+	bool allFinished = true;
+	for (std::unique_ptr<LuaJob> &job : jobsRunning) {
+		if (job->CancelAndWait(std::chrono::milliseconds(2000))) {
+			lua_close(job->L);
+		} else {
+			// Still inside a blocking call so its thread frees the job and state when that returns
+			allFinished = false;
+			job.release();
+		}
+	}
+	jobsRunning.clear();
+	workerPool.Stop(allFinished);
+	for (lua_State *L : workerStatesIdle) {
+		lua_close(L);
+	}
+	workerStatesIdle.clear();
+}
+
+static const char *QueueJob(lua_State *L) {
+	if (lua_iscfunction(L, 1))
+		return "scite.Spawn requires a Lua function.";
+	for (int n = 1; const char *name = lua_getupvalue(L, 1, n); n++) {
+		lua_pop(L, 1);
+		if (strcmp(name, "_ENV") != 0)
+			return "Functions passed to scite.Spawn can not use local variables of enclosing functions.";
+	}
+	std::unique_ptr<LuaJob> job = std::make_unique<LuaJob>(jobIdLast + 1);
+	lua_pushvalue(L, 1);
+	lua_dump(L, StringWriter, &job->code, 0);
+	lua_pop(L, 1);
+	const char *failure = SerialiseValues(L, 2, job->arguments);
+	if (failure)
+		return failure;
+	jobIdLast = job->id;
+	jobsQueued.push_back(std::move(job));
+	StartJobs();
+	return nullptr;
+}
+
+static int cf_scite_spawn(lua_State *L) {
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	const char *failure = QueueJob(L);
+	if (failure)
+		raise_error(L, failure);
+	lua_pushinteger(L, jobIdLast);
+	return 1;
+}
+
+static void DeliverWorkerMessage(int id, const std::string &message) {
+	if (!luaState || message.empty())
+		return;
+	const int top = lua_gettop(luaState);
+	if (lua_getglobal(luaState, "OnWorkerResult") != LUA_TNIL) {
+		const HandlerTiming timing("OnWorkerResult");
+		lua_pushinteger(luaState, id);
+		lua_pushstring(luaState, (message[0] == messagePosted) ? "message" :
+			((message[0] == messageDone) ? "done" : "error"));
+		const int nvalues = DeserialiseValues(luaState, message.data() + 1, message.data() + message.size());
+		if (nvalues >= 0) {
+			call_function(luaState, 2 + nvalues, true);
+		} else {
+			host->Trace("> Lua: malformed message from worker\n");
+		}
+	}
+	lua_settop(luaState, top);
+}
+
 // Don't initialise Lua in LuaExtension::Initialise.  Wait and initialise Lua the
 // first time Lua is used, e.g. when a Load event is called with an argument that
 // appears to be the name of a Lua script.  This just-in-time initialisation logic
@@ -1235,6 +2674,170 @@ static bool CheckStartupScript() {
 	return startupScript.length() > 0;
 }
 
+// Bytecode cache.
+// When ext.lua.bytecode.cache is 1, compiled scripts are kept in a file in the user
+// directory so the startup script, extension scripts, and modules loaded through
+// require are only parsed again when their modification time or size changes.
+
+namespace {
+
+const char bytecodeCacheHeader[] = "SciTE Lua bytecode cache 1\n";
+
+struct CachedChunk {
+	time_t modified = 0;
+	long long size = 0;
+	std::string bytecode;
+};
+
+// lua_Reader that provides a cached chunk as a single block
+struct ChunkReader {
+	const std::string *bytecode;
+	bool done;
+};
+
+const char *ReadChunk(lua_State *, void *ud, size_t *size) {
+	ChunkReader *reader = static_cast<ChunkReader *>(ud);
+	if (reader->done) {
+		*size = 0;
+		return nullptr;
+	}
+	reader->done = true;
+	*size = reader->bytecode->size();
+	return reader->bytecode->data();
+}
+
+}
+
+static bool bytecodeCacheEnabled = false;
+static bool bytecodeCacheRead = false;
+static bool bytecodeCacheChanged = false;
+static std::map<std::string, CachedChunk> bytecodeCache;
+
+static FilePath BytecodeCachePath() {
+	GUI::gui_string name(configFileVisibilityString);
+	name += GUI_TEXT("SciTE.luac");
+	return FilePath(FilePath(GUI::StringFromUTF8(host->Property("SciteUserHome"))), FilePath(name));
+}
+
+static void ReadBytecodeCache() {
+	bytecodeCacheRead = true;
+	const std::string data = BytecodeCachePath().Read();
+	const size_t lengthHeader = strlen(bytecodeCacheHeader);
+	if (data.compare(0, lengthHeader, bytecodeCacheHeader) != 0)
+		return;
+	const char *p = data.data() + lengthHeader;
+	const char *end = data.data() + data.size();
+	while (p < end) {
+		size_t lengthPath = 0;
+		if (!ReadBytes(p, end, lengthPath) || (static_cast<size_t>(end - p) < lengthPath))
+			return;
+		const std::string path(p, lengthPath);
+		p += lengthPath;
+		long long modified = 0;
+		CachedChunk chunk;
+		size_t lengthCode = 0;
+		if (!ReadBytes(p, end, modified) || !ReadBytes(p, end, chunk.size) ||
+			!ReadBytes(p, end, lengthCode) || (static_cast<size_t>(end - p) < lengthCode))
+			return;
+		chunk.modified = static_cast<time_t>(modified);
+		chunk.bytecode.assign(p, lengthCode);
+		p += lengthCode;
+		bytecodeCache[path] = std::move(chunk);
+	}
+}
+
+static void WriteBytecodeCache() {
+	if (!bytecodeCacheChanged)
+		return;
+	bytecodeCacheChanged = false;
+	std::string data(bytecodeCacheHeader);
+	for (const std::pair<const std::string, CachedChunk> &entry : bytecodeCache) {
+		// Drop scripts that have been deleted
+		if (!FilePath(GUI::StringFromUTF8(entry.first)).Exists())
+			continue;
+		AppendBytes(data, entry.first.length());
+		data += entry.first;
+		AppendBytes(data, static_cast<long long>(entry.second.modified));
+		AppendBytes(data, entry.second.size);
+		AppendBytes(data, entry.second.bytecode.length());
+		data += entry.second.bytecode;
+	}
+	// Write to a temporary file that then replaces the cache so that another instance
+	// reading the cache never sees a partly written file.
+	const FilePath pathCache = BytecodeCachePath();
+	const FilePath pathTemporary(GUI::gui_string(pathCache.AsInternal()) + GUI_TEXT(".new"));
+	FILE *fp = pathTemporary.Open(fileWrite);
+	if (!fp)
+		return;
+	bool written = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	written = (fclose(fp) == 0) && written;
+	if (!written || !pathTemporary.Rename(pathCache))
+		pathTemporary.Remove();
+}
+
+// Same as luaL_loadfile but uses the bytecode cache when enabled
+static int load_script(lua_State *L, const char *filename) {
+	if (!bytecodeCacheEnabled)
+		return luaL_loadfile(L, filename);
+	if (!bytecodeCacheRead)
+		ReadBytecodeCache();
+	const FilePath path(GUI::StringFromUTF8(filename));
+	const time_t modified = path.ModifiedTime();
+	const long long size = path.GetFileLength();
+	CachedChunk &chunk = bytecodeCache[filename];
+	if (!chunk.bytecode.empty() && (chunk.modified == modified) && (chunk.size == size)) {
+		ChunkReader reader { &chunk.bytecode, false };
+		if (lua_load(L, ReadChunk, &reader, filename, "b") == LUA_OK)
+			return LUA_OK;
+		lua_pop(L, 1);	// Damaged cache entry so compile again
+	}
+	const int status = luaL_loadfile(L, filename);
+	if (status == LUA_OK) {
+		chunk.modified = modified;
+		chunk.size = size;
+		chunk.bytecode.clear();
+		lua_dump(L, StringWriter, &chunk.bytecode, 0);
+		bytecodeCacheChanged = true;
+	} else {
+		bytecodeCache.erase(filename);
+	}
+	return status;
+}
+
+// Searcher for package.searchers that finds modules on package.path and loads them through the cache
+static int cf_package_searcher_cached(lua_State *L) {
+	const char *name = luaL_checkstring(L, 1);
+	lua_getglobal(L, "package");
+	lua_getfield(L, -1, "searchpath");
+	lua_pushvalue(L, 1);
+	lua_getfield(L, -3, "path");
+	lua_call(L, 2, 2);
+	if (lua_isnil(L, -2))
+		return 1;	// Message describing the places searched
+	const char *filename = lua_tostring(L, -2);
+	if (load_script(L, filename) != LUA_OK) {
+		return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s",
+			name, filename, lua_tostring(L, -1));
+	}
+	lua_pushstring(L, filename);
+	return 2;
+}
+
+static void install_package_searcher_cached(lua_State *L) {
+	lua_getglobal(L, "package");
+	lua_getfield(L, -1, "searchers");
+	if (lua_istable(L, -1)) {
+		// Insert after the preload searcher so it takes precedence over the standard Lua searcher
+		for (lua_Integer i = luaL_len(L, -1); i >= 2; i--) {
+			lua_rawgeti(L, -1, i);
+			lua_rawseti(L, -2, i + 1);
+		}
+		lua_pushcfunction(L, cf_package_searcher_cached);
+		lua_rawseti(L, -2, 2);
+	}
+	lua_pop(L, 2);
+}
+
 static void PublishGlobalBufferData() {
 // release 1.62
 // A Lua table called 'buffer' is associated with each buffer
@@ -1280,6 +2883,7 @@ static bool InitGlobalScope(bool checkProperties, bool forceReload = false) {
 	}
 
 	tracebackEnabled = (GetPropertyInt("ext.lua.debug.traceback") == 1);
+	bytecodeCacheEnabled = (GetPropertyInt("ext.lua.bytecode.cache") == 1);
 
 	if (luaState) {
 		// The Clear / Load used to use metatables to setup without having to re-run the scripts,
@@ -1333,20 +2937,32 @@ static bool InitGlobalScope(bool checkProperties, bool forceReload = false) {
 		lua_setfield(luaState, LUA_REGISTRYINDEX, "_LOADED");
 
 	} else if (!luaDisabled) {
-		luaState = luaL_newstate();
+		luaAllocator = std::make_unique<LuaPoolAllocator>();
+		luaState = lua_newstate(LuaPoolAllocator::Alloc, luaAllocator.get());
 		if (!luaState) {
+			luaAllocator.reset();
 			luaDisabled = true;
 			host->Trace("> Lua: scripting engine failed to initialise\n");
 			return false;
 		}
 		lua_atpanic(luaState, LuaPanicFunction);
+		push_gc_sentinel(luaState);
 
 	} else {
 		return false;
 	}
 
+	// Garbage collector tuning, 200 is Lua's default for both
+	const int gcPause = GetPropertyInt("ext.lua.gc.pause");
+	lua_gc(luaState, LUA_GCSETPAUSE, (gcPause > 0) ? gcPause : 200);
+	const int gcStepMultiplier = GetPropertyInt("ext.lua.gc.stepmul");
+	lua_gc(luaState, LUA_GCSETSTEPMUL, (gcStepMultiplier > 0) ? gcStepMultiplier : 200);
+
 	// ...register standard libraries
 	luaL_openlibs(luaState);
+	if (bytecodeCacheEnabled) {
+		install_package_searcher_cached(luaState);
+	}
 
 	lua_register(luaState, "_ALERT", cf_global_print);
 
@@ -1398,6 +3014,9 @@ static bool InitGlobalScope(bool checkProperties, bool forceReload = false) {
 	lua_pushcfunction(luaState, cf_scite_menu_command);
 	lua_setfield(luaState, -2, "MenuCommand");
 
+	lua_pushcfunction(luaState, cf_scite_enable_feature);
+	lua_setfield(luaState, -2, "EnableFeature");
+
 	lua_pushcfunction(luaState, cf_scite_update_status_bar);
 	lua_setfield(luaState, -2, "UpdateStatusBar");
 
@@ -1413,6 +3032,12 @@ static bool InitGlobalScope(bool checkProperties, bool forceReload = false) {
 	lua_pushcfunction(luaState, cf_scite_strip_value);
 	lua_setfield(luaState, -2, "StripValue");
 
+	lua_pushcfunction(luaState, cf_scite_spawn);
+	lua_setfield(luaState, -2, "Spawn");
+
+	lua_pushcfunction(luaState, cf_scite_lua_stats);
+	lua_setfield(luaState, -2, "LuaStats");
+
 	lua_setglobal(luaState, "scite");
 
 	// append a Metatable onto global namespace, to publish iface constants
@@ -1438,7 +3063,7 @@ static bool InitGlobalScope(bool checkProperties, bool forceReload = false) {
 
 		FilePath fpTest(GUI::StringFromUTF8(startupScript));
 		if (fpTest.Exists()) {
-			if (0 == luaL_loadfile(luaState, startupScript.c_str())) {
+			if (0 == load_script(luaState, startupScript.c_str())) {
 				if (!call_function(luaState, 0, true)) {
 					host->Trace(">Lua: error occurred while running startup script\n");
 				}
@@ -1446,6 +3071,7 @@ static bool InitGlobalScope(bool checkProperties, bool forceReload = false) {
 				host->Trace(lua_tostring(luaState, -1));
 				host->Trace("\n>Lua: error occured while loading startup script\n");
 			}
+			WriteBytecodeCache();
 		}
 	}
 
@@ -1480,11 +3106,16 @@ bool LuaExtension::Initialise(ExtensionAPI *host_) {
 }
 
 bool LuaExtension::Finalise() {
+	CloseWorkers();
+	WriteBytecodeCache();
+
 	if (luaState) {
-		lua_close(luaState);
+		lua_State *L = luaState;
+		luaState = nullptr;
+		lua_close(L);
 	}
 
-	luaState = nullptr;
+	luaAllocator.reset();
 	host = nullptr;
 
 	// The rest don't strictly need to be cleared since they
@@ -1516,10 +3147,11 @@ bool LuaExtension::Load(const char *filename) {
 		if (sl >= 4 && strcmp(filename+sl-4, ".lua")==0) {
 			if (luaState || InitGlobalScope(false)) {
 				extensionScript = filename;
-				luaL_loadfile(luaState, extensionScript.c_str());
+				load_script(luaState, extensionScript.c_str());
 				if (!call_function(luaState, 0, true)) {
 					host->Trace(">Lua: error occurred while loading extension script\n");
 				}
+				WriteBytecodeCache();
 				loaded = true;
 			}
 		}
@@ -1730,8 +3362,12 @@ struct StylingContext {
 	int lenNext;
 
 	static StylingContext *Context(lua_State *L) {
-		return static_cast<StylingContext *>(
+		StylingContext *context = static_cast<StylingContext *>(
 			       lua_touserdata(L, lua_upvalueindex(1)));
+		// The context table is kept between calls so may be used after OnStyle returns
+		if (!context->styler)
+			luaL_error(L, "Styling context used outside OnStyle");
+		return context;
 	}
 
 	void Colourize() {
@@ -1991,70 +3627,126 @@ struct StylingContext {
 		return 1;
 	}
 
+	// Batched interface: styles from startPos are given as a flat array of
+	// {length, style, length, style, ...} and written in one pass.
+	static int StyleRuns(lua_State *L) {
+		StylingContext *context = Context(L);
+		const unsigned int startPosStyle = luaL_checkint(L, 2);
+		luaL_checktype(L, 3, LUA_TTABLE);
+		const lua_Integer runs = luaL_len(L, 3) / 2;
+		const unsigned int endStyle = context->styler->Length();
+		unsigned int pos = std::min(startPosStyle, endStyle);
+		context->styler->StartAt(pos, static_cast<char>(0xffu));
+		context->styler->StartSegment(pos);
+		for (lua_Integer run = 0; (run < runs) && (pos < endStyle); run++) {
+			lua_rawgeti(L, 3, run * 2 + 1);
+			lua_rawgeti(L, 3, run * 2 + 2);
+			const lua_Integer length = lua_tointeger(L, -2);
+			const int style = static_cast<int>(lua_tointeger(L, -1));
+			lua_pop(L, 2);
+			if (length > 0) {
+				pos = static_cast<unsigned int>(std::min<lua_Integer>(pos + length, endStyle));
+				context->styler->ColourTo(pos - 1, style);
+			}
+		}
+		lua_pushinteger(L, pos);
+		return 1;
+	}
+
+	// Sets the fold levels of consecutive lines starting at firstLine.
+	static int SetLevels(lua_State *L) {
+		StylingContext *context = Context(L);
+		const int firstLine = luaL_checkint(L, 2);
+		luaL_checktype(L, 3, LUA_TTABLE);
+		const lua_Integer lines = luaL_len(L, 3);
+		for (lua_Integer i = 0; i < lines; i++) {
+			lua_rawgeti(L, 3, i + 1);
+			const int level = static_cast<int>(lua_tointeger(L, -1));
+			lua_pop(L, 1);
+			const int line = firstLine + static_cast<int>(i);
+			if (context->styler->LevelAt(line) != level)
+				context->styler->SetLevel(line, level);
+		}
+		return 0;
+	}
+
 	void PushMethod(lua_State *L, lua_CFunction fn, const char *name) {
 		lua_pushlightuserdata(L, this);
 		lua_pushcclosure(L, fn, 1);
-		lua_setfield(luaState, -2, name);
+		lua_setfield(L, -2, name);
+	}
+
+	void PushMethods(lua_State *L) {
+		PushMethod(L, Line, "Line");
+		PushMethod(L, CharAt, "CharAt");
+		PushMethod(L, StyleAt, "StyleAt");
+		PushMethod(L, LevelAt, "LevelAt");
+		PushMethod(L, SetLevelAt, "SetLevelAt");
+		PushMethod(L, LineState, "LineState");
+		PushMethod(L, SetLineState, "SetLineState");
+
+		PushMethod(L, StartStyling, "StartStyling");
+		PushMethod(L, EndStyling, "EndStyling");
+		PushMethod(L, More, "More");
+		PushMethod(L, Forward, "Forward");
+		PushMethod(L, Position, "Position");
+		PushMethod(L, AtLineStart, "AtLineStart");
+		PushMethod(L, AtLineEnd, "AtLineEnd");
+		PushMethod(L, State, "State");
+		PushMethod(L, SetState, "SetState");
+		PushMethod(L, ForwardSetState, "ForwardSetState");
+		PushMethod(L, ChangeState, "ChangeState");
+		PushMethod(L, Current, "Current");
+		PushMethod(L, Next, "Next");
+		PushMethod(L, Previous, "Previous");
+		PushMethod(L, Token, "Token");
+		PushMethod(L, Match, "Match");
+
+		PushMethod(L, StyleRuns, "StyleRuns");
+		PushMethod(L, SetLevels, "SetLevels");
 	}
 };
 
+// One context serves every OnStyle call. Its method table is built once per
+// Lua state and kept in the registry; only the fields are updated per call.
+static StylingContext stylingContext;
+static const char stylingContextKey[] = "SciTE_StylingContext";
+
 bool LuaExtension::OnStyle(unsigned int startPos, int lengthDoc, int initStyle, StyleWriter *styler) {
 	bool handled = false;
 	if (luaState) {
 		if (lua_getglobal(luaState, "OnStyle") != LUA_TNIL) {
+			const HandlerTiming timing("OnStyle");
 
-			StylingContext sc;
-			sc.startPos = startPos;
-			sc.lengthDoc = lengthDoc;
-			sc.initStyle = initStyle;
-			sc.styler = styler;
-			sc.codePage = static_cast<int>(host->Send(ExtensionAPI::paneEditor, SCI_GETCODEPAGE));
+			stylingContext.startPos = startPos;
+			stylingContext.lengthDoc = lengthDoc;
+			stylingContext.initStyle = initStyle;
+			stylingContext.styler = styler;
+			stylingContext.codePage = static_cast<int>(host->Send(ExtensionAPI::paneEditor, SCI_GETCODEPAGE));
 
-			lua_newtable(luaState);
+			if (lua_getfield(luaState, LUA_REGISTRYINDEX, stylingContextKey) != LUA_TTABLE) {
+				lua_pop(luaState, 1);
+				lua_newtable(luaState);
+				stylingContext.PushMethods(luaState);
+				lua_pushvalue(luaState, -1);
+				lua_setfield(luaState, LUA_REGISTRYINDEX, stylingContextKey);
+			}
 
-			lua_pushstring(luaState, "startPos");
 			lua_pushinteger(luaState, startPos);
-			lua_settable(luaState, -3);
+			lua_setfield(luaState, -2, "startPos");
 
-			lua_pushstring(luaState, "lengthDoc");
 			lua_pushinteger(luaState, lengthDoc);
-			lua_settable(luaState, -3);
+			lua_setfield(luaState, -2, "lengthDoc");
 
-			lua_pushstring(luaState, "initStyle");
 			lua_pushinteger(luaState, initStyle);
-			lua_settable(luaState, -3);
+			lua_setfield(luaState, -2, "initStyle");
 
-			lua_pushstring(luaState, "language");
-			std::string lang = host->Property("Language");
+			const std::string lang = host->Property("Language");
 			lua_pushstring(luaState, lang.c_str());
-			lua_settable(luaState, -3);
-
-			sc.PushMethod(luaState, StylingContext::Line, "Line");
-			sc.PushMethod(luaState, StylingContext::CharAt, "CharAt");
-			sc.PushMethod(luaState, StylingContext::StyleAt, "StyleAt");
-			sc.PushMethod(luaState, StylingContext::LevelAt, "LevelAt");
-			sc.PushMethod(luaState, StylingContext::SetLevelAt, "SetLevelAt");
-			sc.PushMethod(luaState, StylingContext::LineState, "LineState");
-			sc.PushMethod(luaState, StylingContext::SetLineState, "SetLineState");
-
-			sc.PushMethod(luaState, StylingContext::StartStyling, "StartStyling");
-			sc.PushMethod(luaState, StylingContext::EndStyling, "EndStyling");
-			sc.PushMethod(luaState, StylingContext::More, "More");
-			sc.PushMethod(luaState, StylingContext::Forward, "Forward");
-			sc.PushMethod(luaState, StylingContext::Position, "Position");
-			sc.PushMethod(luaState, StylingContext::AtLineStart, "AtLineStart");
-			sc.PushMethod(luaState, StylingContext::AtLineEnd, "AtLineEnd");
-			sc.PushMethod(luaState, StylingContext::State, "State");
-			sc.PushMethod(luaState, StylingContext::SetState, "SetState");
-			sc.PushMethod(luaState, StylingContext::ForwardSetState, "ForwardSetState");
-			sc.PushMethod(luaState, StylingContext::ChangeState, "ChangeState");
-			sc.PushMethod(luaState, StylingContext::Current, "Current");
-			sc.PushMethod(luaState, StylingContext::Next, "Next");
-			sc.PushMethod(luaState, StylingContext::Previous, "Previous");
-			sc.PushMethod(luaState, StylingContext::Token, "Token");
-			sc.PushMethod(luaState, StylingContext::Match, "Match");
+			lua_setfield(luaState, -2, "language");
 
 			handled = call_function(luaState, 1);
+			stylingContext.styler = nullptr;
 		} else {
 			lua_pop(luaState, 1);
 		}
@@ -2070,6 +3762,30 @@ bool LuaExtension::OnUpdateUI() {
 	return CallNamedFunction("OnUpdateUI");
 }
 
+bool LuaExtension::OnModified(const DocumentDelta *deltas, size_t count) {
+	bool handled = false;
+	if (luaState) {
+		if (lua_getglobal(luaState, "OnModified") != LUA_TNIL) {
+			const HandlerTiming timing("OnModified");
+			lua_createtable(luaState, static_cast<int>(count), 0);
+			for (size_t i = 0; i < count; i++) {
+				lua_createtable(luaState, 0, 3);
+				lua_pushinteger(luaState, deltas[i].position);
+				lua_setfield(luaState, -2, "position");
+				lua_pushinteger(luaState, deltas[i].length);
+				lua_setfield(luaState, -2, "length");
+				lua_pushinteger(luaState, deltas[i].linesAdded);
+				lua_setfield(luaState, -2, "linesAdded");
+				lua_rawseti(luaState, -2, i + 1);
+			}
+			handled = call_function(luaState, 1);
+		} else {
+			lua_pop(luaState, 1);
+		}
+	}
+	return handled;
+}
+
 bool LuaExtension::OnMarginClick() {
 	return CallNamedFunction("OnMarginClick");
 }
@@ -2082,6 +3798,7 @@ bool LuaExtension::OnKey(int keyval, int modifiers) {
 	bool handled = false;
 	if (luaState) {
 		if (lua_getglobal(luaState, "OnKey") != LUA_TNIL) {
+			const HandlerTiming timing("OnKey");
 			lua_pushinteger(luaState, keyval);
 			lua_pushboolean(luaState, (SCMOD_SHIFT & modifiers) != 0 ? 1 : 0); // shift/lock
 			lua_pushboolean(luaState, (SCMOD_CTRL  & modifiers) != 0 ? 1 : 0); // control
@@ -2106,6 +3823,37 @@ bool LuaExtension::OnUserStrip(int control, int change) {
 	return CallNamedFunction("OnStrip", control, change);
 }
 
+bool LuaExtension::OnWorkerResult(Worker *pWorker) {
+	auto it = std::find_if(jobsRunning.begin(), jobsRunning.end(),
+		[pWorker](const std::unique_ptr<LuaJob> &job) noexcept { return job.get() == pWorker; });
+	if (it == jobsRunning.end())
+		return false;
+	const int id = (*it)->id;
+	bool final = false;
+	const std::vector<std::string> messages = (*it)->TakeMessages(final);
+	if (final) {
+		// Worker thread has finished with the job and its state
+		workerStatesIdle.push_back((*it)->L);
+		jobsRunning.erase(it);
+		StartJobs();
+	}
+	for (const std::string &message : messages) {
+		DeliverWorkerMessage(id, message);
+	}
+	return true;
+}
+
 bool LuaExtension::NeedsOnClose() {
 	return HasNamedFunction("OnClose");
 }
+
+// Handlers may come from the startup script and from the extension script of the current file
+const char *LuaExtension::Name() const {
+	static std::string name;
+	name = "Lua";
+	if (startupScript.length())
+		name += " " + startupScript;
+	if (extensionScript.length())
+		name += (startupScript.length() ? " + " : " ") + extensionScript;
+	return name.c_str();
+}
@@ -35,11 +35,14 @@ public:
 	bool OnStyle(unsigned int startPos, int lengthDoc, int initStyle, StyleWriter *styler) override;
 	bool OnDoubleClick() override;
 	bool OnUpdateUI() override;
+	bool OnModified(const DocumentDelta *deltas, size_t count) override;
 	bool OnMarginClick() override;
 	bool OnUserListSelection(int listType, const char *selection) override;
 	bool OnKey(int keyval, int modifiers) override;
 	bool OnDwellStart(int pos, const char *word) override;
 	bool OnClose(const char *filename) override;
 	bool OnUserStrip(int control, int change) override;
+	bool OnWorkerResult(Worker *pWorker) override;
 	bool NeedsOnClose() override;
+	const char *Name() const override;
 };
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 
 #include "Scintilla.h"
 
@@ -37,25 +38,132 @@ std::vector<LineRange> LinesBreak(GUI::ScintillaWindow *pSci) {
 	return lineRanges;
 }
 
+// Clear only the span between the first and last indicator instead of the whole document.
+void ClearIndicator(GUI::ScintillaWindow *pSci, int indicator) {
+	const int length = pSci->Call(SCI_GETLENGTH);
+	const bool markedAtStart = pSci->Call(SCI_INDICATORVALUEAT, indicator, 0) != 0;
+	const int start = markedAtStart ? 0 : pSci->Call(SCI_INDICATOREND, indicator, 0);
+	if ((markedAtStart || (start > 0)) && (start < length)) {
+		const int end = pSci->Call(SCI_INDICATORVALUEAT, indicator, length - 1) ?
+			length : pSci->Call(SCI_INDICATORSTART, indicator, length - 1);
+		pSci->Call(SCI_SETINDICATORCURRENT, indicator);
+		pSci->Call(SCI_INDICATORCLEARRANGE, start, end - start);
+	}
+}
+
+namespace {
+
+void RemoveLines(std::vector<LineRange> &ranges, LineRange rangeRemove) {
+	std::vector<LineRange> remaining;
+	for (const LineRange &range : ranges) {
+		if ((range.lineEnd <= rangeRemove.lineStart) || (range.lineStart >= rangeRemove.lineEnd)) {
+			remaining.push_back(range);
+		} else {
+			if (range.lineStart < rangeRemove.lineStart)
+				remaining.emplace_back(range.lineStart, rangeRemove.lineStart);
+			if (range.lineEnd > rangeRemove.lineEnd)
+				remaining.emplace_back(rangeRemove.lineEnd, range.lineEnd);
+		}
+	}
+	ranges = remaining;
+}
+
+void AddLines(std::vector<LineRange> &ranges, LineRange rangeAdd) {
+	RemoveLines(ranges, rangeAdd);
+	for (LineRange &range : ranges) {
+		if (range.lineEnd == rangeAdd.lineStart) {
+			range.lineEnd = rangeAdd.lineEnd;
+			return;
+		}
+	}
+	ranges.push_back(rangeAdd);
+}
+
+// Runs are sorted start, end pairs of positions.
+void AddRun(std::vector<int> &runs, int start, int end) {
+	if (!runs.empty() && (runs.back() == start)) {
+		runs.back() = end;
+	} else {
+		runs.push_back(start);
+		runs.push_back(end);
+	}
+}
+
+bool InRuns(const std::vector<int> &runs, size_t &index, int position) {
+	while ((index < runs.size()) && (runs[index + 1] <= position))
+		index += 2;
+	return (index < runs.size()) && (runs[index] <= position);
+}
+
+// Only modify the indicator where the marked runs differ from the wanted runs
+// so unchanged matches are not redrawn.
+void ApplyDifferences(GUI::ScintillaWindow *pSci, const std::vector<int> &marked, const std::vector<int> &wanted) {
+	if (marked == wanted)
+		return;
+	std::vector<int> boundaries(marked);
+	boundaries.insert(boundaries.end(), wanted.begin(), wanted.end());
+	std::sort(boundaries.begin(), boundaries.end());
+	boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+	size_t indexMarked = 0;
+	size_t indexWanted = 0;
+	for (size_t b = 0; b + 1 < boundaries.size(); b++) {
+		const int start = boundaries[b];
+		const int length = boundaries[b + 1] - start;
+		const bool isMarked = InRuns(marked, indexMarked, start);
+		const bool isWanted = InRuns(wanted, indexWanted, start);
+		if (isMarked && !isWanted)
+			pSci->Call(SCI_INDICATORCLEARRANGE, start, length);
+		else if (isWanted && !isMarked)
+			pSci->Call(SCI_INDICATORFILLRANGE, start, length);
+	}
+}
+
+}
+
 MatchMarker::MatchMarker() :
-	pSci(nullptr), styleMatch(-1), flagsMatch(0), indicator(0), bookMark(-1) {
+	pSci(nullptr), styleMatch(-1), flagsMatch(0), indicator(0), bookMark(-1), lazy(false) {
 }
 
 void MatchMarker::StartMatch(GUI::ScintillaWindow *pSci_,
 	const std::string &textMatch_, int flagsMatch_, int styleMatch_,
-	int indicator_, int bookMark_) {
+	int indicator_, int bookMark_, bool lazy_) {
 	lineRanges.clear();
+	if ((pSci_ != pSci) || !lazy_)
+		linesMarked.clear();
 	pSci = pSci_;
 	textMatch = textMatch_;
 	flagsMatch = flagsMatch_;
 	styleMatch = styleMatch_;
 	indicator = indicator_;
 	bookMark = bookMark_;
+	lazy = lazy_;
 	lineRanges = LinesBreak(pSci);
+	if (lazy && !lineRanges.empty()) {
+		// Search only around the visible lines and refresh lines marked for an earlier match
+		lineRanges.erase(lineRanges.begin() + 1, lineRanges.end());
+		std::vector<LineRange> linesRefresh = linesMarked;
+		RemoveLines(linesRefresh, lineRanges[0]);
+		lineRanges.insert(lineRanges.end(), linesRefresh.begin(), linesRefresh.end());
+	}
 	// Perform the initial marking immediately to avoid flashing
 	Continue();
 }
 
+// When lazy, queue lines scrolled into view that have not yet been searched.
+bool MatchMarker::ExtendToVisible() {
+	if (!pSci || !lazy)
+		return false;
+	std::vector<LineRange> linesVisible = LinesBreak(pSci);
+	if (linesVisible.size() > 1)
+		linesVisible.erase(linesVisible.begin() + 1, linesVisible.end());
+	for (const LineRange &range : linesMarked)
+		RemoveLines(linesVisible, range);
+	for (const LineRange &range : lineRanges)
+		RemoveLines(linesVisible, range);
+	lineRanges.insert(lineRanges.begin(), linesVisible.begin(), linesVisible.end());
+	return !linesVisible.empty();
+}
+
 bool MatchMarker::Complete() const noexcept {
 	return lineRanges.empty();
 }
@@ -63,7 +171,6 @@ bool MatchMarker::Complete() const noexcept {
 void MatchMarker::Continue() {
 	const int segment = 200;
 
-	// Remove old indicators if any exist.
 	pSci->Call(SCI_SETINDICATORCURRENT, indicator);
 
 	const LineRange rangeSearch = lineRanges[0];
@@ -76,7 +183,19 @@ void MatchMarker::Continue() {
 	const int positionEnd = pSci->Call(SCI_POSITIONFROMLINE, lineEndSegment);
 	pSci->Call(SCI_SETTARGETSTART, positionStart);
 	pSci->Call(SCI_SETTARGETEND, positionEnd);
-	pSci->Call(SCI_INDICATORCLEARRANGE, positionStart, positionEnd - positionStart);
+
+	// Existing indicator runs in the segment
+	std::vector<int> marked;
+	int position = positionStart;
+	while (position < positionEnd) {
+		int positionRunEnd = pSci->Call(SCI_INDICATOREND, indicator, position);
+		if ((positionRunEnd <= position) || (positionRunEnd > positionEnd))
+			positionRunEnd = positionEnd;
+		if (pSci->Call(SCI_INDICATORVALUEAT, indicator, position))
+			AddRun(marked, position, positionRunEnd);
+		position = positionRunEnd;
+	}
+	std::vector<int> wanted;
 
 	//Monitor the amount of time took by the search.
 	GUI::ElapsedTime searchElapsedTime;
@@ -88,14 +207,16 @@ void MatchMarker::Continue() {
 		// Limit the search duration to 250 ms. Avoid to freeze editor for huge lines.
 		if (searchElapsedTime.Duration() > 0.25) {
 			// Clear all indicators because timer has expired.
-			pSci->Call(SCI_INDICATORCLEARRANGE, 0, pSci->Call(SCI_GETLENGTH));
+			ClearIndicator(pSci, indicator);
 			lineRanges.clear();
-			break;
+			linesMarked.clear();
+			return;
 		}
 		int posEndFound = pSci->Call(SCI_GETTARGETEND);
 
 		if ((styleMatch < 0) || (styleMatch == pSci->Call(SCI_GETSTYLEAT, posFound))) {
-			pSci->Call(SCI_INDICATORFILLRANGE, posFound, posEndFound - posFound);
+			if (posEndFound > posFound)
+				AddRun(wanted, posFound, posEndFound);
 			if (bookMark >= 0) {
 				pSci->Call(SCI_MARKERADD,
 					pSci->Call(SCI_LINEFROMPOSITION, posFound), bookMark);
@@ -112,6 +233,10 @@ void MatchMarker::Continue() {
 			SCI_SEARCHINTARGET, textMatch.length(), textMatch.c_str());
 	}
 
+	ApplyDifferences(pSci, marked, wanted);
+	if (lazy)
+		AddLines(linesMarked, LineRange(rangeSearch.lineStart, lineEndSegment));
+
 	// Retire searched lines
 	if (!lineRanges.empty()) {
 		// Check in case of re-entrance
@@ -126,4 +251,5 @@ void MatchMarker::Continue() {
 void MatchMarker::Stop() noexcept {
 	pSci = nullptr;
 	lineRanges.clear();
+	linesMarked.clear();
 }
@@ -12,6 +12,7 @@ struct LineRange {
 };
 
 std::vector<LineRange> LinesBreak(GUI::ScintillaWindow *pSci);
+void ClearIndicator(GUI::ScintillaWindow *pSci, int indicator);
 
 class MatchMarker {
 	GUI::ScintillaWindow *pSci;
@@ -20,12 +21,15 @@ class MatchMarker {
 	int flagsMatch;
 	int indicator;
 	int bookMark;
+	bool lazy;
 	std::vector<LineRange> lineRanges;
+	std::vector<LineRange> linesMarked;	///< Lines that may hold indicators when lazy
 public:
 	MatchMarker();	// Not noexcept as std::vector constructor throws
 	void StartMatch(GUI::ScintillaWindow *pSci_,
 		const std::string &textMatch_, int flagsMatch_, int styleMatch_,
-		int indicator_, int bookMark_);
+		int indicator_, int bookMark_, bool lazy_=false);
+	bool ExtendToVisible();
 	bool Complete() const noexcept;
 	void Continue();
 	void Stop() noexcept;
@@ -5,14 +5,258 @@
 // Copyright 1998-2003 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <memory>
 
 #include "Scintilla.h"
 #include "GUI.h"
+#include "StringHelpers.h"
+#include "FilePath.h"
 #include "MultiplexExtension.h"
 
-MultiplexExtension::MultiplexExtension(): host(nullptr) {}
+namespace {
+
+// Extension methods that are timed
+enum LatencyEvent {
+	eventClear, eventLoad, eventInitBuffer, eventActivateBuffer, eventRemoveBuffer,
+	eventOpen, eventSwitchFile, eventBeforeSave, eventSave, eventChar, eventExecute,
+	eventSavePointReached, eventSavePointLeft, eventStyle, eventDoubleClick, eventUpdateUI,
+	eventModified, eventMarginClick, eventMacro, eventUserListSelection, eventSendProperty, eventKey,
+	eventDwellStart, eventClose, eventUserStrip, eventWorkerResult, eventCount
+};
+
+const char *const eventNames[eventCount] = {
+	"Clear", "Load", "InitBuffer", "ActivateBuffer", "RemoveBuffer",
+	"OnOpen", "OnSwitchFile", "OnBeforeSave", "OnSave", "OnChar", "OnExecute",
+	"OnSavePointReached", "OnSavePointLeft", "OnStyle", "OnDoubleClick", "OnUpdateUI",
+	"OnModified", "OnMarginClick", "OnMacro", "OnUserListSelection", "SendProperty", "OnKey",
+	"OnDwellStart", "OnClose", "OnUserStrip", "OnWorkerResult",
+};
+
+// Bucket n of a histogram counts calls taking less than 2^n microseconds that are not in bucket n-1
+constexpr size_t latencyBuckets = 24;
+// Number of recent calls kept for tracing
+constexpr size_t traceCapacity = 16384;
+// Seconds between warnings for one extension and event
+constexpr double warningInterval = 1.0;
+
+size_t LatencyBucket(double duration) noexcept {
+	const double microseconds = duration * 1.0e6;
+	size_t bucket = 0;
+	double limit = 1.0;
+	while ((microseconds >= limit) && (bucket < latencyBuckets - 1)) {
+		bucket++;
+		limit *= 2.0;
+	}
+	return bucket;
+}
+
+// Quote text as a JSON string
+std::string JSONString(const std::string &text) {
+	std::string quoted = "\"";
+	for (const char ch : text) {
+		if ((ch == '"') || (ch == '\\')) {
+			quoted += '\\';
+			quoted += ch;
+		} else if (static_cast<unsigned char>(ch) >= ' ') {
+			quoted += ch;
+		}
+	}
+	return quoted + "\"";
+}
+
+}
+
+// Always on timing of each call to each extension.  Calls add to a histogram for the
+// extension and event.  Calls that take longer than ext.latency.warn.ms are reported in the
+// output pane with the extension's name.  A handler that is slow on every call would flood the
+// output pane, so there is at most one warning each second for an extension and event that
+// also counts the slow calls since the previous warning.  The most recent calls are kept so they can be
+// written in Chrome trace format (chrome://tracing) by the ExtensionLatencyTrace command.
+class LatencyProfile {
+	struct Latency {
+		size_t calls = 0;
+		double total = 0.0;
+		double longest = 0.0;
+		size_t histogram[latencyBuckets] {};
+		double lastWarning = -warningInterval;
+		size_t overBudgetUnreported = 0;
+	};
+	struct TraceEvent {
+		double start;
+		double duration;
+		size_t extension;
+		LatencyEvent event;
+	};
+	ExtensionAPI *host = nullptr;
+	std::vector<const Extension *> extensions;
+	std::vector<std::vector<Latency>> latencies;
+	std::vector<TraceEvent> trace;
+	size_t traceNext = 0;
+	GUI::ElapsedTime epoch;
+	double budget = 0.0;	// Seconds, 0 for no warnings
+	std::string ExtensionName(size_t extension) const;
+public:
+	void SetHost(ExtensionAPI *host_);
+	void AddExtension(const Extension *pexp);
+	void ReadBudget();
+	double Now() {
+		return epoch.Duration();
+	}
+	void Record(const Extension *pexp, LatencyEvent event, double start);
+	std::string Report() const;
+	bool WriteTrace(const char *filename) const;
+	bool Command(const char *cmd);
+};
+
+void LatencyProfile::SetHost(ExtensionAPI *host_) {
+	host = host_;
+	ReadBudget();
+}
+
+void LatencyProfile::AddExtension(const Extension *pexp) {
+	extensions.push_back(pexp);
+	latencies.emplace_back(eventCount);
+}
+
+void LatencyProfile::ReadBudget() {
+	if (host)
+		budget = atof(host->Property("ext.latency.warn.ms").c_str()) / 1000.0;
+}
+
+std::string LatencyProfile::ExtensionName(size_t extension) const {
+	const char *name = extensions[extension]->Name();
+	return *name ? name : "Extension " + StdStringFromSizeT(extension + 1);
+}
+
+void LatencyProfile::Record(const Extension *pexp, LatencyEvent event, double start) {
+	const double end = Now();
+	const double duration = end - start;
+	const size_t extension = std::find(extensions.begin(), extensions.end(), pexp) - extensions.begin();
+	if (extension >= extensions.size())
+		return;
+	Latency &latency = latencies[extension][event];
+	if ((budget > 0.0) && (duration > budget) && host) {
+		if (end - latency.lastWarning >= warningInterval) {
+			std::string warning = "> " + ExtensionName(extension) + " " +
+				eventNames[event] + " took " + StdStringFromDouble(duration * 1000.0, 1) +
+				" ms, over ext.latency.warn.ms";
+			if (latency.overBudgetUnreported)
+				warning += ", as did " + StdStringFromSizeT(latency.overBudgetUnreported) +
+					" more calls since the last warning";
+			warning += "\n";
+			host->Trace(warning.c_str());
+			latency.lastWarning = end;
+			latency.overBudgetUnreported = 0;
+		} else {
+			latency.overBudgetUnreported++;
+		}
+	}
+	latency.calls++;
+	latency.total += duration;
+	latency.longest = std::max(latency.longest, duration);
+	latency.histogram[LatencyBucket(duration)]++;
+	if (trace.size() < traceCapacity) {
+		trace.push_back({start, duration, extension, event});
+	} else {
+		trace[traceNext] = {start, duration, extension, event};
+		traceNext = (traceNext + 1) % traceCapacity;
+	}
+}
+
+std::string LatencyProfile::Report() const {
+	std::string report = "> Extension latency: calls, mean and longest in microseconds, then calls under each power of 2 microseconds\n";
+	for (size_t extension = 0; extension < latencies.size(); extension++) {
+		for (size_t event = 0; event < eventCount; event++) {
+			const Latency &latency = latencies[extension][event];
+			if (latency.calls == 0)
+				continue;
+			report += ExtensionName(extension) + " " + eventNames[event] + " " +
+				StdStringFromSizeT(latency.calls) + " " +
+				StdStringFromDouble(latency.total * 1.0e6 / latency.calls, 1) + " " +
+				StdStringFromDouble(latency.longest * 1.0e6, 1);
+			size_t limit = 1;
+			for (size_t bucket = 0; bucket < latencyBuckets; bucket++) {
+				if (latency.histogram[bucket])
+					report += " <" + StdStringFromSizeT(limit) + ":" + StdStringFromSizeT(latency.histogram[bucket]);
+				limit *= 2;
+			}
+			report += "\n";
+		}
+	}
+	return report;
+}
+
+bool LatencyProfile::WriteTrace(const char *filename) const {
+	FILE *fp = FilePath(GUI::StringFromUTF8(filename)).Open(fileWrite);
+	if (!fp)
+		return false;
+	fputs("{\"traceEvents\":[\n", fp);
+	const char *separator = "";
+	// Each extension is shown as a thread with its name
+	for (size_t extension = 0; extension < extensions.size(); extension++) {
+		fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":%s}}",
+			separator, static_cast<unsigned int>(extension + 1), JSONString(ExtensionName(extension)).c_str());
+		separator = ",\n";
+	}
+	// Oldest first, starting after the most recently overwritten entry
+	for (size_t i = 0; i < trace.size(); i++) {
+		const TraceEvent &te = trace[(traceNext + i) % trace.size()];
+		fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"extension\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+			separator, eventNames[te.event], te.start * 1.0e6, te.duration * 1.0e6,
+			static_cast<unsigned int>(te.extension + 1));
+		separator = ",\n";
+	}
+	fputs("\n]}\n", fp);
+	fclose(fp);
+	return true;
+}
+
+// Handle the ExtensionLatencyReport and ExtensionLatencyTrace commands
+bool LatencyProfile::Command(const char *cmd) {
+	if (!host)
+		return false;
+	if (0 == strcmp(cmd, "ExtensionLatencyReport")) {
+		host->Trace(Report().c_str());
+		return true;
+	}
+	const char commandTrace[] = "ExtensionLatencyTrace ";
+	if (0 == strncmp(cmd, commandTrace, strlen(commandTrace))) {
+		const char *filename = cmd + strlen(commandTrace);
+		if (!WriteTrace(filename)) {
+			const std::string failure = std::string("> Could not write latency trace to ") + filename + "\n";
+			host->Trace(failure.c_str());
+		}
+		return true;
+	}
+	return false;
+}
+
+// Times one call to an extension from construction to destruction
+class LatencyTiming {
+	LatencyProfile &profile;
+	const Extension *pexp;
+	LatencyEvent event;
+	double start;
+public:
+	LatencyTiming(LatencyProfile &profile_, const Extension *pexp_, LatencyEvent event_) :
+		profile(profile_), pexp(pexp_), event(event_), start(profile_.Now()) {
+	}
+	// Deleted so LatencyTiming objects can not be copied.
+	LatencyTiming(const LatencyTiming &) = delete;
+	void operator=(const LatencyTiming &) = delete;
+	~LatencyTiming() {
+		profile.Record(pexp, event, start);
+	}
+};
+
+MultiplexExtension::MultiplexExtension(): host(nullptr), latency(std::make_unique<LatencyProfile>()) {}
 
 MultiplexExtension::~MultiplexExtension() {
 }
@@ -23,6 +267,7 @@ bool MultiplexExtension::RegisterExtension(Extension &ext_) {
 			return true;
 
 	extensions.push_back(&ext_);
+	latency->AddExtension(&ext_);
 
 	if (host)
 		ext_.Initialise(host);
@@ -45,6 +290,7 @@ bool MultiplexExtension::Initialise(ExtensionAPI *host_) {
 		Finalise(); // shouldn't happen.
 
 	host = host_;
+	latency->SetHost(host_);
 	for (Extension *pexp : extensions)
 		pexp->Initialise(host_);
 
@@ -62,13 +308,17 @@ bool MultiplexExtension::Finalise() {
 }
 
 bool MultiplexExtension::Clear() {
-	for (Extension *pexp : extensions)
+	latency->ReadBudget();
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventClear);
 		pexp->Clear();
+	}
 	return false;
 }
 
 bool MultiplexExtension::Load(const char *filename) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventLoad);
 		if (pexp->Load(filename)) {
 			return true;
 		}
@@ -77,25 +327,32 @@ bool MultiplexExtension::Load(const char *filename) {
 }
 
 bool MultiplexExtension::InitBuffer(int index) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventInitBuffer);
 		pexp->InitBuffer(index);
+	}
 	return false;
 }
 
 bool MultiplexExtension::ActivateBuffer(int index) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventActivateBuffer);
 		pexp->ActivateBuffer(index);
+	}
 	return false;
 }
 
 bool MultiplexExtension::RemoveBuffer(int index) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventRemoveBuffer);
 		pexp->RemoveBuffer(index);
+	}
 	return false;
 }
 
 bool MultiplexExtension::OnOpen(const char *filename) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventOpen);
 		if (pexp->OnOpen(filename)) {
 			return true;
 		}
@@ -105,6 +362,7 @@ bool MultiplexExtension::OnOpen(const char *filename) {
 
 bool MultiplexExtension::OnSwitchFile(const char *filename) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventSwitchFile);
 		if (pexp->OnSwitchFile(filename)) {
 			return true;
 		}
@@ -114,6 +372,7 @@ bool MultiplexExtension::OnSwitchFile(const char *filename) {
 
 bool MultiplexExtension::OnBeforeSave(const char *filename) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventBeforeSave);
 		if (pexp->OnBeforeSave(filename)) {
 			return true;
 		}
@@ -123,6 +382,7 @@ bool MultiplexExtension::OnBeforeSave(const char *filename) {
 
 bool MultiplexExtension::OnSave(const char *filename) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventSave);
 		if (pexp->OnSave(filename)) {
 			return true;
 		}
@@ -132,6 +392,7 @@ bool MultiplexExtension::OnSave(const char *filename) {
 
 bool MultiplexExtension::OnChar(char c) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventChar);
 		if (pexp->OnChar(c)) {
 			return true;
 		}
@@ -140,7 +401,10 @@ bool MultiplexExtension::OnChar(char c) {
 }
 
 bool MultiplexExtension::OnExecute(const char *cmd) {
+	if (latency->Command(cmd))
+		return true;
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventExecute);
 		if (pexp->OnExecute(cmd)) {
 			return true;
 		}
@@ -150,6 +414,7 @@ bool MultiplexExtension::OnExecute(const char *cmd) {
 
 bool MultiplexExtension::OnSavePointReached() {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventSavePointReached);
 		if (pexp->OnSavePointReached()) {
 			return true;
 		}
@@ -159,6 +424,7 @@ bool MultiplexExtension::OnSavePointReached() {
 
 bool MultiplexExtension::OnSavePointLeft() {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventSavePointLeft);
 		if (pexp->OnSavePointLeft()) {
 			return true;
 		}
@@ -168,6 +434,7 @@ bool MultiplexExtension::OnSavePointLeft() {
 
 bool MultiplexExtension::OnStyle(unsigned int p, int q, int r, StyleWriter *s) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventStyle);
 		if (pexp->OnStyle(p, q, r, s)) {
 			return true;
 		}
@@ -177,6 +444,7 @@ bool MultiplexExtension::OnStyle(unsigned int p, int q, int r, StyleWriter *s) {
 
 bool MultiplexExtension::OnDoubleClick() {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventDoubleClick);
 		if (pexp->OnDoubleClick()) {
 			return true;
 		}
@@ -186,6 +454,7 @@ bool MultiplexExtension::OnDoubleClick() {
 
 bool MultiplexExtension::OnUpdateUI() {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventUpdateUI);
 		if (pexp->OnUpdateUI()) {
 			return true;
 		}
@@ -193,8 +462,19 @@ bool MultiplexExtension::OnUpdateUI() {
 	return false;
 }
 
+bool MultiplexExtension::OnModified(const DocumentDelta *deltas, size_t count) {
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventModified);
+		if (pexp->OnModified(deltas, count)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 bool MultiplexExtension::OnMarginClick() {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventMarginClick);
 		if (pexp->OnMarginClick()) {
 			return true;
 		}
@@ -204,6 +484,7 @@ bool MultiplexExtension::OnMarginClick() {
 
 bool MultiplexExtension::OnMacro(const char *p, const char *q) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventMacro);
 		if (pexp->OnMacro(p, q)) {
 			return true;
 		}
@@ -213,6 +494,7 @@ bool MultiplexExtension::OnMacro(const char *p, const char *q) {
 
 bool MultiplexExtension::OnUserListSelection(int listType, const char *selection) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventUserListSelection);
 		if (pexp->OnUserListSelection(listType, selection)) {
 			return true;
 		}
@@ -221,13 +503,16 @@ bool MultiplexExtension::OnUserListSelection(int listType, const char *selection
 }
 
 bool MultiplexExtension::SendProperty(const char *prop) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventSendProperty);
 		pexp->SendProperty(prop);
+	}
 	return false;
 }
 
 bool MultiplexExtension::OnKey(int keyval, int modifiers) {
 	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventKey);
 		if (pexp->OnKey(keyval, modifiers)) {
 			return true;
 		}
@@ -236,20 +521,36 @@ bool MultiplexExtension::OnKey(int keyval, int modifiers) {
 }
 
 bool MultiplexExtension::OnDwellStart(int pos, const char *word) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventDwellStart);
 		pexp->OnDwellStart(pos, word);
+	}
 	return false;
 }
 
 bool MultiplexExtension::OnClose(const char *filename) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventClose);
 		pexp->OnClose(filename);
+	}
 	return false;
 }
 
 bool MultiplexExtension::OnUserStrip(int control, int change) {
-	for (Extension *pexp : extensions)
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventUserStrip);
 		pexp->OnUserStrip(control, change);
+	}
+	return false;
+}
+
+bool MultiplexExtension::OnWorkerResult(Worker *pWorker) {
+	for (Extension *pexp : extensions) {
+		const LatencyTiming timing(*latency, pexp, eventWorkerResult);
+		if (pexp->OnWorkerResult(pWorker)) {
+			return true;
+		}
+	}
 	return false;
 }
 
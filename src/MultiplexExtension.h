@@ -36,6 +36,10 @@
 // simplest thing...)  However, the option to "not" manage the lifecycle
 // is a valid one, since it often makes sense to implement extensions as
 // singletons.
+//
+// Each call to a contained extension is timed by a LatencyProfile.
+
+class LatencyProfile;
 
 class MultiplexExtension: public Extension {
 public:
@@ -67,6 +71,7 @@ public:
 	bool OnStyle(unsigned int, int, int, StyleWriter *) override;
 	bool OnDoubleClick() override;
 	bool OnUpdateUI() override;
+	bool OnModified(const DocumentDelta *deltas, size_t count) override;
 	bool OnMarginClick() override;
 	bool OnMacro(const char *, const char *) override;
 	bool OnUserListSelection(int, const char *) override;
@@ -77,11 +82,13 @@ public:
 	bool OnDwellStart(int, const char *) override;
 	bool OnClose(const char *) override;
 	bool OnUserStrip(int control, int change) override;
+	bool OnWorkerResult(Worker *pWorker) override;
 	bool NeedsOnClose() override;
 
 private:
 	std::vector<Extension *> extensions;
 	ExtensionAPI *host;
+	std::unique_ptr<LatencyProfile> latency;
 };
 
 #endif
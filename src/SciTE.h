@@ -159,6 +159,7 @@
 #define IDM_WRAP			414
 #define IDM_WRAPOUTPUT		415
 #define IDM_READONLY			416
+#define IDM_ALLFEATURES		417
 
 #define IDM_CLEAROUTPUT		420
 #define IDM_SWITCHPANE			421
@@ -23,6 +23,11 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
 #include "ILoader.h"
 #include "Scintilla.h"
 #include "SciLexer.h"
@@ -43,6 +48,7 @@
 #include "Cookie.h"
 #include "Worker.h"
 #include "FileWorker.h"
+#include "FileWatcher.h"
 #include "MatchMarker.h"
 #include "EditorConfig.h"
 #include "SciTEBase.h"
@@ -121,6 +127,8 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 	tabHideOne = false;
 	tabMultiLine = false;
 	sbNum = 1;
+	sbPending = false;
+	sbFieldsValid = 0;
 	visHeightTools = 0;
 	visHeightTab = 0;
 	visHeightStatus = 0;
@@ -142,6 +150,15 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 
 	allowMenuActions = true;
 	scrollOutput = 1;
+	outputMaxLines = 0;
+	outputMaxBytes = 0;
+	mutexOutputTrim.reset(Mutex::Create());
+	recoveryFailed = false;
+	outputTrimmed = 0;
+	outputRevision = 0;
+	outputTrimming = false;
+	undoRedoLazy = false;
+	modificationsDocument = 0;
 	returnOutputToCommand = true;
 
 	ptStartDrag.x = 0;
@@ -179,6 +196,7 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 
 	macrosEnabled = false;
 	recording = false;
+	macroPlaying = false;
 
 	propsEmbed.superPS = &propsPlatform;
 	propsBase.superPS = &propsEmbed;
@@ -195,6 +213,7 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 
 	timerMask = 0;
 	delayBeforeAutoSave = 0;
+	followFile = false;
 
 	editorConfig = IEditorConfig::Create();
 }
@@ -202,11 +221,19 @@ SciTEBase::SciTEBase(Extension *ext) : apis(true), pwFocussed(&wEditor), extende
 SciTEBase::~SciTEBase() {
 	if (extender)
 		extender->Finalise();
+#if defined(__linux__)
+	for (const int fd : sharedRanges)
+		close(fd);
+#endif
 	popup.Destroy();
 }
 
 void SciTEBase::Finalise() {
 	TimerEnd(timerAutoSave);
+	TimerEnd(timerFollow);
+	if (fileWatcher) {
+		fileWatcher->Cancel();
+	}
 }
 
 void SciTEBase::WorkerCommand(int cmd, Worker *pWorker) {
@@ -222,6 +249,13 @@ void SciTEBase::WorkerCommand(int cmd, Worker *pWorker) {
 	case WORK_FILEPROGRESS:
  		UpdateProgress(pWorker);
 		break;
+	case WORK_FILECHANGED:
+		FilesChanged(static_cast<FileWatcher *>(pWorker)->Changes());
+		break;
+	case WORK_EXTENSION:
+		if (extender)
+			extender->OnWorkerResult(pWorker);
+		break;
 	}
 }
 
@@ -405,6 +439,30 @@ bool SciTEBase::FindMatchingPreprocessorCondition(
 	int level = 0;
 	const int maxLines = wEditor.Call(SCI_GETLINECOUNT) - 1;
 
+	const BraceIndex &index = CurrentBuffer()->braceIndex;
+	if (index.Complete(wEditor.Call(SCI_GETLENGTH))) {
+		// Visit only the indexed conditionals instead of reading each line
+		const PositionIndex<BraceIndex::Conditional> &conditionals = index.conditionals;
+		const int positionLine = wEditor.Call(SCI_POSITIONFROMLINE, curLine);
+		ptrdiff_t i = conditionals.IndexAtOrAfter(positionLine);
+		if ((direction == 1) && (i < conditionals.Length()) && (conditionals.PositionAt(i) == positionLine))
+			i++;
+		if (direction == -1)
+			i--;
+		for (; i >= 0 && i < conditionals.Length() && !isInside; i += direction) {
+			const int status = conditionals.At(i).kind;
+			if ((direction == 1 && status == ppcStart) || (direction == -1 && status == ppcEnd)) {
+				level++;
+			} else if (level > 0 && ((direction == 1 && status == ppcEnd) || (direction == -1 && status == ppcStart))) {
+				level--;
+			} else if (level == 0 && (status == condEnd1 || status == condEnd2)) {
+				isInside = true;
+				curLine = wEditor.Call(SCI_LINEFROMPOSITION, conditionals.PositionAt(i));
+			}
+		}
+		return isInside;
+	}
+
 	while (curLine < maxLines && curLine > 0 && !isInside) {
 		curLine += direction;	// Increment or decrement
 		GetLine(line, sizeof(line), curLine);
@@ -485,6 +543,148 @@ static bool IsBrace(char ch) noexcept {
 	return ch == '[' || ch == ']' || ch == '(' || ch == ')' || ch == '{' || ch == '}';
 }
 
+static char BraceOpposite(char ch) noexcept {
+	switch (ch) {
+	case '(': return ')';
+	case ')': return '(';
+	case '[': return ']';
+	case ']': return '[';
+	case '{': return '}';
+	case '}': return '{';
+	default: return ch;
+	}
+}
+
+void BraceIndex::Clear() noexcept {
+	braces.Clear();
+	conditionals.Clear();
+	verifiedEnd = 0;
+	modifiedEnd = 0;
+	lexer = -1;
+}
+
+namespace {
+
+// Remove entries from deleted text and move the entries after a modification.
+template <typename T>
+void MoveEntries(PositionIndex<T> &entries, int position, int length) {
+	const ptrdiff_t first = entries.IndexAtOrAfter(position);
+	if (length < 0)
+		entries.Erase(first, entries.IndexAtOrAfter(position - length));
+	entries.Shift(first, length);
+}
+
+// Whether the entries found from @a found match the candidates in [@a candidate, @a candidateEnd).
+template <typename T, typename Same>
+bool SameEntries(typename std::vector<T>::const_iterator found, typename std::vector<T>::const_iterator foundEnd,
+	const PositionIndex<T> &entries, ptrdiff_t candidate, ptrdiff_t candidateEnd, Same same) {
+	if ((foundEnd - found) != (candidateEnd - candidate))
+		return false;
+	for (; found != foundEnd; ++found, ++candidate) {
+		if (!same(*found, entries.At(candidate)))
+			return false;
+	}
+	return true;
+}
+
+}
+
+void BraceIndex::Modified(int position, int length) {
+	MoveEntries(braces, position, length);
+	MoveEntries(conditionals, position, length);
+	if (modifiedEnd > position)
+		modifiedEnd = std::max(modifiedEnd + length, position);
+	modifiedEnd = std::max(modifiedEnd, position + std::max(length, 0));
+	verifiedEnd = std::min(verifiedEnd, position);
+}
+
+/**
+ * Styles from @a position onwards may have changed, such as after setting lexer properties.
+ * Entries there become candidates to be checked again.
+ */
+void BraceIndex::Restyled(int position, int lexer_) {
+	if (lexer != lexer_) {
+		Clear();
+		lexer = lexer_;
+	} else if (position < verifiedEnd) {
+		verifiedEnd = position;
+		modifiedEnd = std::max(modifiedEnd, position);
+	}
+}
+
+/**
+ * Replace the candidates from @a start to @a end with the entries found there.
+ * Once a range after the modified text holds the same braces as the candidates,
+ * the styles are taken to have settled and the remaining candidates are accepted.
+ */
+void BraceIndex::Replace(int start, int end, int length,
+	const std::vector<Brace> &bracesFound, const std::vector<Conditional> &conditionalsFound) {
+	bool settled = false;
+	if ((end > modifiedEnd) && (end < length)) {
+		const int startCompare = std::max(start, modifiedEnd);
+		const auto foundBrace = std::lower_bound(bracesFound.begin(), bracesFound.end(), startCompare,
+			[](const Brace &entry, int pos) noexcept { return entry.position < pos; });
+		const ptrdiff_t candidateBrace = braces.IndexAtOrAfter(startCompare);
+		const ptrdiff_t candidateBraceEnd = braces.IndexAtOrAfter(end);
+		const auto foundConditional = std::lower_bound(conditionalsFound.begin(), conditionalsFound.end(), startCompare,
+			[](const Conditional &entry, int pos) noexcept { return entry.position < pos; });
+		const ptrdiff_t candidateConditional = conditionals.IndexAtOrAfter(startCompare);
+		const ptrdiff_t candidateConditionalEnd = conditionals.IndexAtOrAfter(end);
+		settled = (foundBrace != bracesFound.end()) &&
+			SameEntries(foundBrace, bracesFound.end(), braces, candidateBrace, candidateBraceEnd,
+				[](const Brace &a, const Brace &b) noexcept {
+					return (a.position == b.position) && (a.style == b.style) && (a.ch == b.ch);
+				}) &&
+			SameEntries(foundConditional, conditionalsFound.end(), conditionals, candidateConditional, candidateConditionalEnd,
+				[](const Conditional &a, const Conditional &b) noexcept {
+					return (a.position == b.position) && (a.kind == b.kind);
+				});
+	}
+
+	const ptrdiff_t firstBrace = braces.IndexAtOrAfter(start);
+	braces.Erase(firstBrace, braces.IndexAtOrAfter(end));
+	braces.Insert(firstBrace, bracesFound);
+	const ptrdiff_t firstConditional = conditionals.IndexAtOrAfter(start);
+	conditionals.Erase(firstConditional, conditionals.IndexAtOrAfter(end));
+	conditionals.Insert(firstConditional, conditionalsFound);
+
+	if (settled || (end >= length)) {
+		verifiedEnd = length;
+		modifiedEnd = 0;
+	} else {
+		verifiedEnd = end;
+	}
+}
+
+/**
+ * Pair braces as SCI_BRACEMATCH does, counting only braces of the same kind and style.
+ * Only the indexed braces between the pair are visited, not the text.
+ * @return The position of the brace matching the brace at @a position or -1.
+ */
+int BraceIndex::MatchingBrace(int position) const {
+	ptrdiff_t i = braces.IndexAtOrAfter(position);
+	if ((i >= braces.Length()) || (braces.PositionAt(i) != position))
+		return -1;
+	const Brace brace = braces.At(i);
+	const bool opening = (brace.ch == '(') || (brace.ch == '[') || (brace.ch == '{');
+	const char chMatch = BraceOpposite(brace.ch);
+	const ptrdiff_t direction = opening ? 1 : -1;
+	int depth = 0;
+	for (i += direction; (i >= 0) && (i < braces.Length()); i += direction) {
+		const Brace other = braces.At(i);
+		if (other.style != brace.style)
+			continue;
+		if (other.ch == brace.ch) {
+			depth++;
+		} else if (other.ch == chMatch) {
+			if (depth == 0)
+				return other.position;
+			depth--;
+		}
+	}
+	return -1;
+}
+
 /**
  * Find if there is a brace next to the caret, checking before caret first, then
  * after caret. If brace found also find its matching brace.
@@ -547,6 +747,8 @@ bool SciTEBase::FindMatchingBracePosition(bool editor, int &braceAtCaret, int &b
 			const int lineStart = win.Call(SCI_LINEFROMPOSITION, braceAtCaret);
 			const int lineMaxSubord = win.Call(SCI_GETLASTCHILD, lineStart, -1);
 			braceOpposite = win.Call(SCI_GETLINEENDPOSITION, lineMaxSubord);
+		} else if (editor && CurrentBuffer()->braceIndex.Complete(lengthDoc)) {
+			braceOpposite = CurrentBuffer()->braceIndex.MatchingBrace(braceAtCaret);
 		} else {
 			braceOpposite = win.Call(SCI_BRACEMATCH, braceAtCaret, 0);
 		}
@@ -559,9 +761,74 @@ bool SciTEBase::FindMatchingBracePosition(bool editor, int &braceAtCaret, int &b
 	return isInside;
 }
 
+/**
+ * Index the braces and preprocessor conditionals of one part of the current document.
+ * Lines are styled first so braces in comments and strings are distinguished.
+ * @return @c true if there was indexing to do.
+ */
+bool SciTEBase::ContinueBraceIndex() {
+	BraceIndex &index = CurrentBuffer()->braceIndex;
+	const int lengthDoc = wEditor.Call(SCI_GETLENGTH);
+	if ((!bracesCheck && !preprocessorSymbol) || ((codePage != 0) && (codePage != SC_CP_UTF8)))
+		return false;	// In DBCS, trail bytes may look like braces
+	if (FeatureMode(SizeTiers::tfBraces) != SizeTiers::tmFull)
+		return false;	// Large documents match braces by searching when needed
+	if (index.lexer != lexLanguage)
+		index.Restyled(0, lexLanguage);
+	if (index.Complete(lengthDoc))
+		return false;
+
+	const int chunkSize = 100000;
+	const int start = wEditor.Call(SCI_POSITIONFROMLINE, wEditor.Call(SCI_LINEFROMPOSITION, index.verifiedEnd));
+	int end = lengthDoc;
+	if (start + chunkSize < lengthDoc) {
+		end = wEditor.Call(SCI_POSITIONFROMLINE, wEditor.Call(SCI_LINEFROMPOSITION, start + chunkSize) + 1);
+		if ((end < 0) || (end > lengthDoc))
+			end = lengthDoc;
+	}
+	wEditor.Call(SCI_COLOURISE, start, end);
+	const char *text = reinterpret_cast<const char *>(
+		wEditor.CallReturnPointer(SCI_GETRANGEPOINTER, start, end - start));
+
+	std::vector<BraceIndex::Brace> bracesFound;
+	std::vector<BraceIndex::Conditional> conditionalsFound;
+	int lineBegin = 0;
+	for (int i = 0; i <= end - start; i++) {
+		if ((i == end - start) || (text[i] == '\r') || (text[i] == '\n')) {
+			int first = lineBegin;
+			while ((first < i) && isspacechar(text[first]))
+				first++;
+			if (preprocessorSymbol && (first < i) && (text[first] == preprocessorSymbol)) {
+				char line[800];
+				const size_t lengthLine = std::min<size_t>(i - lineBegin, sizeof(line) - 1);
+				memcpy(line, text + lineBegin, lengthLine);
+				line[lengthLine] = '\0';
+				const int kind = IsLinePreprocessorCondition(line);
+				if (kind != ppcNone)
+					conditionalsFound.push_back({start + lineBegin, kind});
+			}
+			lineBegin = i + 1;
+		} else if (IsBrace(text[i])) {
+			bracesFound.push_back({start + i, wEditor.Call(SCI_GETSTYLEAT, start + i), text[i]});
+		}
+	}
+	index.Replace(start, end, lengthDoc, bracesFound, conditionalsFound);
+	return true;
+}
+
 void SciTEBase::BraceMatch(bool editor) {
 	if (!bracesCheck)
 		return;
+	if (editor) {
+		const SizeTiers::Mode mode = FeatureMode(SizeTiers::tfBraces);
+		if (mode == SizeTiers::tmOff) {
+			wEditor.Call(SCI_BRACEHIGHLIGHT, -1, -1);
+			return;
+		}
+		if ((mode == SizeTiers::tmFull) && !CurrentBuffer()->braceIndex.Complete(wEditor.Call(SCI_GETLENGTH)))
+			SetIdler(true);	// Continue indexing braces
+	}
+
 	int braceAtCaret = -1;
 	int braceOpposite = -1;
 	FindMatchingBracePosition(editor, braceAtCaret, braceOpposite, bracesSloppy);
@@ -734,38 +1001,62 @@ void SciTEBase::HighlightCurrentWord(bool highlight) {
 		return;
 	}
 	GUI::ScintillaWindow &wCurrent = wOutput.HasFocus() ? wOutput : wEditor;
-	// Remove old indicators if any exist.
-	wCurrent.Call(SCI_SETINDICATORCURRENT, indicatorHighlightCurrentWord);
-	const int lenDoc = wCurrent.Call(SCI_GETLENGTH);
-	wCurrent.Call(SCI_INDICATORCLEARRANGE, 0, lenDoc);
+	const sptr_t document = wCurrent.Call(SCI_GETDOCPOINTER);
+	const int revision = (&wCurrent == &wOutput) ? outputRevision : CurrentBuffer()->revision;
+	const bool sameDocument = (currentWordHighlight.window == &wCurrent) &&
+		(currentWordHighlight.document == document) && (currentWordHighlight.revision == revision);
+	std::string wordToFind;
+	int selectedStyle = -1;
+	if ((&wCurrent == &wEditor) && (FeatureMode(SizeTiers::tfHighlightWord) == SizeTiers::tmOff)) {
+		highlight = false;
+	}
+	if (highlight) {
+		// Get start & end selection.
+		int selStart = wCurrent.Call(SCI_GETSELECTIONSTART);
+		int selEnd = wCurrent.Call(SCI_GETSELECTIONEND);
+		const bool noUserSelection = selStart == selEnd;
+		std::string sWordToFind = RangeExtendAndGrab(wCurrent, selStart, selEnd,
+		        &SciTEBase::islexerwordcharforsel);
+		if (sWordToFind.length() == 0 || (sWordToFind.find_first_of("\n\r ") != std::string::npos)) {
+			highlight = false; // No highlight when no selection or multi-lines selection.
+		} else {
+			// Get style of the current word to highlight only word with same style.
+			if (currentWordHighlight.isOnlyWithSameStyle)
+				selectedStyle = wCurrent.Call(SCI_GETSTYLEAT, selStart);
+			// Manage word with DBCS.
+			wordToFind = EncodeString(sWordToFind);
+			if (sameDocument && (currentWordHighlight.style == selectedStyle) &&
+				(currentWordHighlight.word == wordToFind)) {
+				// Already highlighted, matchMarker extends the highlights as the view scrolls.
+				return;
+			}
+			if (noUserSelection && currentWordHighlight.statesOfDelay == currentWordHighlight.noDelay) {
+				// Manage delay before highlight when no user selection but there is word at the caret.
+				currentWordHighlight.statesOfDelay = currentWordHighlight.delay;
+				// Reset timer
+				currentWordHighlight.elapsedTimes.Duration(true);
+				highlight = false;
+			}
+		}
+	}
+	if (!sameDocument || !highlight) {
+		// Remove old indicators if any exist. Within an unchanged document, only the
+		// differences between the old and new matches are applied by matchMarker.
+		matchMarker.Stop();
+		ClearIndicator(&wCurrent, indicatorHighlightCurrentWord);
+		currentWordHighlight.window = nullptr;
+	}
 	if (!highlight)
 		return;
-	// Get start & end selection.
-	int selStart = wCurrent.Call(SCI_GETSELECTIONSTART);
-	int selEnd = wCurrent.Call(SCI_GETSELECTIONEND);
-	const bool noUserSelection = selStart == selEnd;
-	std::string sWordToFind = RangeExtendAndGrab(wCurrent, selStart, selEnd,
-	        &SciTEBase::islexerwordcharforsel);
-	if (sWordToFind.length() == 0 || (sWordToFind.find_first_of("\n\r ") != std::string::npos))
-		return; // No highlight when no selection or multi-lines selection.
-	if (noUserSelection && currentWordHighlight.statesOfDelay == currentWordHighlight.noDelay) {
-		// Manage delay before highlight when no user selection but there is word at the caret.
-		currentWordHighlight.statesOfDelay = currentWordHighlight.delay;
-		// Reset timer
-		currentWordHighlight.elapsedTimes.Duration(true);
-		return;
-	}
-	// Get style of the current word to highlight only word with same style.
-	int selectedStyle = wCurrent.Call(SCI_GETSTYLEAT, selStart);
-	if (!currentWordHighlight.isOnlyWithSameStyle)
-		selectedStyle = -1;
-
-	// Manage word with DBCS.
-	const std::string wordToFind = EncodeString(sWordToFind);
 
+	currentWordHighlight.window = &wCurrent;
+	currentWordHighlight.document = document;
+	currentWordHighlight.revision = revision;
+	currentWordHighlight.style = selectedStyle;
+	currentWordHighlight.word = wordToFind;
 	matchMarker.StartMatch(&wCurrent, wordToFind,
 		SCFIND_MATCHCASE | SCFIND_WHOLEWORD, selectedStyle,
-		indicatorHighlightCurrentWord, -1);
+		indicatorHighlightCurrentWord, -1, true);
 	SetIdler(true);
 }
 
@@ -1304,6 +1595,16 @@ void SciTEBase::UIHasFocus() {
 void SciTEBase::OutputAppendString(const char *s, int len) {
 	if (len == -1)
 		len = static_cast<int>(strlen(s));
+	if (outputMaxLines || outputMaxBytes) {
+		// Bounded output gathers text so that appending and trimming happen about once per frame
+		outputPending.append(s, len);
+		if (outputSinceFlush.Duration() > 1.0 / 60.0) {
+			OutputFlush();
+		} else {
+			SetIdler(true);
+		}
+		return;
+	}
 	wOutput.CallString(SCI_APPENDTEXT, len, s);
 	if (scrollOutput) {
 		const int line = wOutput.Call(SCI_GETLINECOUNT, 0, 0);
@@ -1316,6 +1617,9 @@ void SciTEBase::OutputAppendStringSynchronised(const char *s, int len) {
 	if (len == -1)
 		len = static_cast<int>(strlen(s));
 	wOutput.Send(SCI_APPENDTEXT, len, SptrFromString(s));
+	if (outputMaxLines || outputMaxBytes) {
+		OutputTrim();
+	}
 	if (scrollOutput) {
 		const sptr_t line = wOutput.Send(SCI_GETLINECOUNT);
 		const sptr_t lineStart = wOutput.Send(SCI_POSITIONFROMLINE, line);
@@ -1323,6 +1627,75 @@ void SciTEBase::OutputAppendStringSynchronised(const char *s, int len) {
 	}
 }
 
+void SciTEBase::OutputFlush() {
+	outputSinceFlush.Duration(true);
+	if (outputPending.empty())
+		return;
+	std::string text;
+	text.swap(outputPending);
+	wOutput.CallString(SCI_APPENDTEXT, text.length(), text.c_str());
+	OutputTrim();
+	if (scrollOutput) {
+		const int line = wOutput.Call(SCI_GETLINECOUNT, 0, 0);
+		const int lineStart = wOutput.Call(SCI_POSITIONFROMLINE, line);
+		wOutput.Call(SCI_GOTOPOS, lineStart);
+	}
+}
+
+/**
+ * Remove the oldest lines from the output pane when it is over output.max.lines or output.max.bytes.
+ * A quarter of the limit more than needed is removed so that trimming is infrequent.
+ * Uses Send as may be called from a command thread on Win32.
+ */
+void SciTEBase::OutputTrim() {
+	const sptr_t length = wOutput.Send(SCI_GETLENGTH);
+	const sptr_t lines = wOutput.Send(SCI_GETLINECOUNT);
+	sptr_t lineFirst = 0;
+	if (outputMaxLines && (lines > outputMaxLines)) {
+		lineFirst = lines - outputMaxLines * 3 / 4;
+	}
+	if (outputMaxBytes && (length > outputMaxBytes)) {
+		const sptr_t lineKeep = wOutput.Send(SCI_LINEFROMPOSITION, length - outputMaxBytes * 3 / 4) + 1;
+		lineFirst = std::max(lineFirst, lineKeep);
+	}
+	// Always keep the last line as it may be incomplete
+	lineFirst = std::min(lineFirst, lines - 1);
+	if (lineFirst <= 0)
+		return;
+	const sptr_t endTrim = wOutput.Send(SCI_POSITIONFROMLINE, lineFirst);
+	// Undo history would retain the removed text
+	wOutput.Send(SCI_SETUNDOCOLLECTION, 0);
+	{
+		Lock lock(mutexOutputTrim.get());
+		outputTrimming = true;
+	}
+	// Not locked while deleting as the main thread handles the modification notification
+	wOutput.Send(SCI_DELETERANGE, 0, endTrim);
+	{
+		Lock lock(mutexOutputTrim.get());
+		outputTrimming = false;
+		outputTrimmed += endTrim;
+	}
+	wOutput.Send(SCI_EMPTYUNDOBUFFER);
+	wOutput.Send(SCI_SETUNDOCOLLECTION, 1);
+}
+
+bool SciTEBase::OutputTrimming() const noexcept {
+	Lock lock(mutexOutputTrim.get());
+	return outputTrimming;
+}
+
+// Offsets count all text ever added to the output pane so remain valid when it is trimmed.
+sptr_t SciTEBase::OutputOffsetFromPosition(sptr_t position) const noexcept {
+	Lock lock(mutexOutputTrim.get());
+	return position + outputTrimmed;
+}
+
+sptr_t SciTEBase::OutputPositionFromOffset(sptr_t offset) const noexcept {
+	Lock lock(mutexOutputTrim.get());
+	return std::max<sptr_t>(offset - outputTrimmed, 0);
+}
+
 void SciTEBase::Execute() {
 	props.Set("CurrentMessage", "");
 	dirNameForExecute = FilePath();
@@ -1716,7 +2089,20 @@ bool SciTEBase::StartAutoCompleteWord(bool onlyOneWord) {
 	if (startword == current || allNumber)
 		return true;
 	const std::string root = line.substr(startword, current - startword);
-	const int doclen = LengthDocument();
+	const SizeTiers::Mode mode = FeatureMode(SizeTiers::tfWordCompletion);
+	if (mode == SizeTiers::tmOff) {
+		wEditor.Call(SCI_AUTOCCANCEL);
+		return true;
+	}
+	int searchStart = 0;
+	int doclen = LengthDocument();
+	if (mode != SizeTiers::tmFull) {
+		// Only words in the lines being viewed
+		const int lineDisplayTop = wEditor.Call(SCI_GETFIRSTVISIBLELINE);
+		searchStart = wEditor.Call(SCI_POSITIONFROMLINE, wEditor.Call(SCI_DOCLINEFROMVISIBLE, lineDisplayTop));
+		doclen = wEditor.Call(SCI_GETLINEENDPOSITION, wEditor.Call(SCI_DOCLINEFROMVISIBLE,
+			lineDisplayTop + wEditor.Call(SCI_LINESONSCREEN)));
+	}
 	const int flags = SCFIND_WORDSTART | (autoCompleteIgnoreCase ? 0 : SCFIND_MATCHCASE);
 	const int posCurrentWord = wEditor.Call(SCI_GETCURRENTPOS) - static_cast<int>(root.length());
 	unsigned int minWordLength = 0;
@@ -1727,11 +2113,11 @@ bool SciTEBase::StartAutoCompleteWord(bool onlyOneWord) {
 	std::string wordsNear;
 	wordsNear.append("\n");
 
-	wEditor.Call(SCI_SETTARGETRANGE, 0, doclen);
+	wEditor.Call(SCI_SETTARGETRANGE, searchStart, doclen);
 	wEditor.Call(SCI_SETSEARCHFLAGS, flags);
 	int posFind = wEditor.CallString(SCI_SEARCHINTARGET, root.length(), root.c_str());
 	TextReader acc(wEditor);
-	while (posFind >= 0 && posFind < doclen) {	// search all the document
+	while (posFind >= 0 && posFind < doclen) {	// search all the document or the lines in view
 		int wordEnd = posFind + static_cast<int>(root.length());
 		if (posFind != posCurrentWord) {
 			while (Contains(wordCharacters, acc.SafeGetCharAt(wordEnd)))
@@ -2283,22 +2669,136 @@ int SciTEBase::GetCurrentScrollPosition() {
 	return wEditor.Call(SCI_DOCLINEFROMVISIBLE, lineDisplayTop);
 }
 
+void StatusBarTemplate::Compile(const std::string &key_, const std::string &source_) {
+	key = key_;
+	source = source_;
+	segments.clear();
+	compiled = true;
+	size_t start = 0;
+	while (start < source.length()) {
+		const size_t varStart = source.find("$(", start);
+		if (varStart == std::string::npos) {
+			segments.push_back({source.substr(start), false, 0});
+			break;
+		}
+		const size_t varEnd = source.find(')', varStart + 2);
+		const size_t innerStart = source.find("$(", varStart + 2);
+		if ((varEnd == std::string::npos) || (innerStart < varEnd)) {
+			// Unterminated and nested variables are left to PropSetFile's expansion rules
+			segments.clear();
+			compiled = false;
+			return;
+		}
+		if (varStart > start) {
+			segments.push_back({source.substr(start, varStart - start), false, 0});
+		}
+		std::string name = source.substr(varStart + 2, varEnd - (varStart + 2));
+		const int dependencies = FieldDependencies(name);
+		segments.push_back({name, true, dependencies});
+		start = varEnd + 1;
+	}
+}
+
+int StatusBarTemplate::FieldDependencies(const std::string &name) {
+	static const std::map<std::string, int> fields = {
+		{"LineNumber", sdCaret},
+		{"ColumnNumber", sdCaret},
+		{"OverType", sdCaret},
+		{"SelLength", sdSelection},
+		{"SelHeight", sdSelection},
+		{"ReadOnly", sdDocument},
+		{"EOLMode", sdDocument},
+		{"BufferLength", sdDocument},
+		{"NbOfLines", sdDocument},
+		{"SizeTier", sdDocument},
+	};
+	std::map<std::string, int>::const_iterator it = fields.find(name);
+	return (it != fields.end()) ? it->second : 0;
+}
+
+int StatusBarState::Differences(const StatusBarState &other) const noexcept {
+	if ((document != other.document) || (revision != other.revision) || (length != other.length)) {
+		return StatusBarTemplate::sdAll;
+	}
+	int changed = 0;
+	if ((caret != other.caret) || (caretVirtual != other.caretVirtual) ||
+		(overType != other.overType) || (tabWidth != other.tabWidth)) {
+		changed |= StatusBarTemplate::sdCaret;
+	}
+	if ((caret != other.caret) || (anchor != other.anchor) ||
+		(caretVirtual != other.caretVirtual) || (anchorVirtual != other.anchorVirtual) ||
+		(selectionStart != other.selectionStart) || (selectionEnd != other.selectionEnd) ||
+		(selectionMode != other.selectionMode) || (tabWidth != other.tabWidth)) {
+		changed |= StatusBarTemplate::sdSelection;
+	}
+	if ((readOnly != other.readOnly) || (eolMode != other.eolMode) || (sizeTier != other.sizeTier)) {
+		changed |= StatusBarTemplate::sdDocument;
+	}
+	return changed;
+}
+
+StatusBarState SciTEBase::CurrentStatusBarState() {
+	StatusBarState state;
+	state.document = wEditor.CallReturnPointer(SCI_GETDOCPOINTER);
+	state.revision = CurrentBuffer()->revision;
+	state.length = LengthDocument();
+	state.caret = wEditor.Call(SCI_GETCURRENTPOS);
+	state.anchor = wEditor.Call(SCI_GETANCHOR);
+	const int mainSel = wEditor.Call(SCI_GETMAINSELECTION);
+	state.caretVirtual = wEditor.Call(SCI_GETSELECTIONNCARETVIRTUALSPACE, mainSel);
+	state.anchorVirtual = wEditor.Call(SCI_GETSELECTIONNANCHORVIRTUALSPACE, mainSel);
+	state.selectionStart = wEditor.Call(SCI_GETSELECTIONSTART);
+	state.selectionEnd = wEditor.Call(SCI_GETSELECTIONEND);
+	state.selectionMode = wEditor.Call(SCI_GETSELECTIONMODE);
+	state.overType = wEditor.Call(SCI_GETOVERTYPE);
+	state.tabWidth = wEditor.Call(SCI_GETTABWIDTH);
+	state.readOnly = CurrentBuffer()->isReadOnly;
+	state.eolMode = wEditor.Call(SCI_GETEOLMODE);
+	state.sizeTier = CurrentBuffer()->sizeTier * 2 + (CurrentBuffer()->featuresFull ? 1 : 0);
+	return state;
+}
+
 /**
- * Set up properties for ReadOnly, EOLMode, BufferLength, NbOfLines, SelLength, SelHeight.
+ * Set up properties for the groups of status bar fields in dependencies:
+ * LineNumber, ColumnNumber, OverType for the caret;
+ * SelLength, SelHeight for the selection;
+ * ReadOnly, EOLMode, BufferLength, NbOfLines, SizeTier for the document.
  */
 void SciTEBase::SetTextProperties(
-    PropSetFile &ps) {			///< Property set to update.
+    PropSetFile &ps,			///< Property set to update.
+    int dependencies) {		///< StatusBarTemplate::Dependency flags of fields to set.
 
-	std::string ro = GUI::UTF8FromString(localiser.Text("READ"));
-	ps.Set("ReadOnly", CurrentBuffer()->isReadOnly ? ro.c_str() : "");
+	if (dependencies & StatusBarTemplate::sdCaret) {
+		ps.Set("LineNumber", std::to_string(GetCurrentLineNumber() + 1));
+		ps.Set("ColumnNumber", std::to_string(GetCurrentColumnNumber() + 1));
+		ps.Set("OverType", wEditor.Call(SCI_GETOVERTYPE) ? "OVR" : "INS");
+	}
 
-	const int eolMode = wEditor.Call(SCI_GETEOLMODE);
-	ps.Set("EOLMode", eolMode == SC_EOL_CRLF ? "CR+LF" : (eolMode == SC_EOL_LF ? "LF" : "CR"));
+	if (dependencies & StatusBarTemplate::sdDocument) {
+		std::string ro = GUI::UTF8FromString(localiser.Text("READ"));
+		ps.Set("ReadOnly", CurrentBuffer()->isReadOnly ? ro.c_str() : "");
 
-	ps.Set("BufferLength", std::to_string(LengthDocument()));
+		const int eolMode = wEditor.Call(SCI_GETEOLMODE);
+		ps.Set("EOLMode", eolMode == SC_EOL_CRLF ? "CR+LF" : (eolMode == SC_EOL_LF ? "LF" : "CR"));
 
-	ps.Set("NbOfLines", std::to_string(wEditor.Call(SCI_GETLINECOUNT)));
+		ps.Set("BufferLength", std::to_string(LengthDocument()));
 
+		ps.Set("NbOfLines", std::to_string(wEditor.Call(SCI_GETLINECOUNT)));
+
+		// Name of the size tier with "+" when some features have been enabled fully
+		const int tier = CurrentBuffer()->sizeTier;
+		std::string sizeTier;
+		if ((tier >= 0) && (tier < static_cast<int>(sizeTiers.tiers.size()))) {
+			sizeTier = sizeTiers.tiers[tier].name;
+			if (CurrentBuffer()->featuresFull)
+				sizeTier += "+";
+		}
+		ps.Set("SizeTier", sizeTier);
+	}
+
+	if (!(dependencies & StatusBarTemplate::sdSelection)) {
+		return;
+	}
 	const Sci_CharacterRange crange = GetSelection();
 	const int selFirstLine = wEditor.Call(SCI_LINEFROMPOSITION, crange.cpMin);
 	const int selLastLine = wEditor.Call(SCI_LINEFROMPOSITION, crange.cpMax);
@@ -2327,25 +2827,81 @@ void SciTEBase::SetTextProperties(
 	ps.Set("SelHeight", std::to_string(selHeight));
 }
 
+/**
+ * Request the status bar be shown again. The text is produced when idle so that the
+ * several updates caused by one event are displayed once.
+ */
 void SciTEBase::UpdateStatusBar(bool bUpdateSlowData) {
 	if (sbVisible) {
 		if (bUpdateSlowData) {
 			SetFileProperties(propsStatus);
 		}
-		SetTextProperties(propsStatus);
-		propsStatus.Set("LineNumber", std::to_string(GetCurrentLineNumber() + 1));
-		propsStatus.Set("ColumnNumber", std::to_string(GetCurrentColumnNumber() + 1));
-		propsStatus.Set("OverType", wEditor.Call(SCI_GETOVERTYPE) ? "OVR" : "INS");
-
-		char sbKey[32];
-		sprintf(sbKey, "statusbar.text.%d", sbNum);
-		std::string msg = propsStatus.GetExpandedString(sbKey);
-		if (msg.size() && sbValue != msg) {	// To avoid flickering, update only if needed
-			SetStatusBarText(msg.c_str());
-			sbValue = msg;
+		if (!sbPending) {
+			sbPending = true;
+			SetIdler(true);
 		}
 	} else {
 		sbValue = "";
+		sbPending = false;
+	}
+}
+
+/**
+ * Produce the status bar text from its template, recomputing only the fields
+ * whose inputs have changed since the last time.
+ */
+void SciTEBase::RenderStatusBar() {
+	sbPending = false;
+	if (!sbVisible) {
+		return;
+	}
+
+	char sbKey[32];
+	sprintf(sbKey, "statusbar.text.%d", sbNum);
+	const std::string source = propsStatus.GetString(sbKey);
+	if (!sbTemplate.compiled || (sbTemplate.key != sbKey) || (sbTemplate.source != source)) {
+		sbTemplate.Compile(sbKey, source);
+	}
+
+	// Variables that are other properties may refer to any field
+	int dependencies = StatusBarTemplate::sdAll;
+	if (sbTemplate.compiled) {
+		dependencies = 0;
+		for (const StatusBarTemplate::Segment &segment : sbTemplate.segments) {
+			if (segment.variable) {
+				if (segment.dependencies) {
+					dependencies |= segment.dependencies;
+				} else if ((segment.text.find(' ') != std::string::npos) ||
+					(propsStatus.GetString(segment.text.c_str()).find("$(") != std::string::npos)) {
+					dependencies = StatusBarTemplate::sdAll;
+				}
+			}
+		}
+	}
+
+	const StatusBarState state = CurrentStatusBarState();
+	const int changed = state.Differences(sbState) | (StatusBarTemplate::sdAll & ~sbFieldsValid);
+	SetTextProperties(propsStatus, changed & dependencies);
+	sbFieldsValid = (sbFieldsValid & ~changed) | (changed & dependencies);
+	sbState = state;
+
+	std::string msg;
+	if (sbTemplate.compiled) {
+		for (const StatusBarTemplate::Segment &segment : sbTemplate.segments) {
+			if (!segment.variable) {
+				msg += segment.text;
+			} else if (segment.dependencies) {
+				msg += propsStatus.GetString(segment.text.c_str());
+			} else if (segment.text != sbKey) {
+				msg += propsStatus.Expand("$(" + segment.text + ")");
+			}
+		}
+	} else {
+		msg = propsStatus.GetExpandedString(sbKey);
+	}
+	if (msg.size() && sbValue != msg) {	// To avoid flickering, update only if needed
+		SetStatusBarText(msg.c_str());
+		sbValue = msg;
 	}
 }
 
@@ -2949,7 +3505,7 @@ void WindowSetFocus(GUI::ScintillaWindow &w) {
 }
 
 void SciTEBase::SetLineNumberWidth() {
-	if (lineNumbers) {
+	if (lineNumbers && (FeatureMode(SizeTiers::tfLineNumbers) != SizeTiers::tmOff)) {
 		int lineNumWidth = lineNumbersWidth;
 
 		if (lineNumbersExpand) {
@@ -3418,6 +3974,10 @@ void SciTEBase::MenuCommand(int cmdID, int source) {
 		SetBuffersMenu();
 		break;
 
+	case IDM_ALLFEATURES:
+		EnableFeature("");
+		break;
+
 	case IDM_VIEWTABBAR:
 		tabVisible = !tabVisible;
 		ShowTabBar();
@@ -3432,6 +3992,7 @@ void SciTEBase::MenuCommand(int cmdID, int source) {
 		break;
 
 	case IDM_CLEAROUTPUT:
+		outputPending.clear();
 		wOutput.Call(SCI_CLEARALL);
 		break;
 
@@ -3678,6 +4239,34 @@ static int LevelNumber(int level) noexcept {
 	return level & SC_FOLDLEVELNUMBERMASK;
 }
 
+/**
+ * The same as SCI_GETLASTCHILD but from fold levels already read, which start at line 0.
+ */
+static int LastChild(const std::vector<int> &levels, int lineParent, int level) {
+	const int maxLine = static_cast<int>(levels.size());
+	auto levelAt = [&levels, maxLine](int line) noexcept {
+		return (line < maxLine) ? levels[line] : SC_FOLDLEVELBASE;
+	};
+	if (level == -1)
+		level = LevelNumber(levelAt(lineParent));
+	int lineMaxSubord = lineParent;
+	while (lineMaxSubord < maxLine - 1) {
+		const int levelTry = levelAt(lineMaxSubord + 1);
+		if (!(levelTry & SC_FOLDLEVELWHITEFLAG) && (LevelNumber(levelTry) <= level))
+			break;
+		lineMaxSubord++;
+	}
+	if (lineMaxSubord > lineParent) {
+		if (level > LevelNumber(levelAt(lineMaxSubord + 1))) {
+			// Have chewed up some whitespace that belongs to a parent so seek back
+			if (levelAt(lineMaxSubord) & SC_FOLDLEVELWHITEFLAG) {
+				lineMaxSubord--;
+			}
+		}
+	}
+	return lineMaxSubord;
+}
+
 void SciTEBase::FoldChanged(int line, int levelNow, int levelPrev) {
 	// Unfold any regions where the new fold structure makes that fold wrong.
 	// Will only unfold and show lines and never fold or hide lines.
@@ -3734,46 +4323,98 @@ void SciTEBase::FoldChanged(int line, int levelNow, int levelPrev) {
 	}
 }
 
+/**
+ * Lex lines before @a lineEnd that have not yet been styled so their fold levels are known.
+ */
+void SciTEBase::EnsureFoldLevels(int lineEnd) {
+	const int endStyled = wEditor.Call(SCI_GETENDSTYLED);
+	const int positionEnd = (lineEnd < wEditor.Call(SCI_GETLINECOUNT)) ?
+		wEditor.Call(SCI_POSITIONFROMLINE, lineEnd) : wEditor.Call(SCI_GETLENGTH);
+	if (endStyled < positionEnd) {
+		wEditor.Call(SCI_COLOURISE, endStyled, positionEnd);
+	}
+}
+
+/**
+ * @return The fold levels of the lines from @a lineStart up to but not including @a lineEnd.
+ */
+std::vector<int> SciTEBase::FoldLevels(int lineStart, int lineEnd) {
+	EnsureFoldLevels(lineEnd);
+	std::vector<int> levels;
+	levels.reserve(lineEnd - lineStart);
+	for (int line = lineStart; line < lineEnd; line++) {
+		levels.push_back(wEditor.Call(SCI_GETFOLDLEVEL, line));
+	}
+	return levels;
+}
+
 void SciTEBase::ExpandFolds(int line, bool expand, int level) {
 	// Expand or contract line and all subordinates
 	// level is the fold level of line
 	const int lineMaxSubord = wEditor.Call(SCI_GETLASTCHILD, line, LevelNumber(level));
 	line++;
 	wEditor.Call(expand ? SCI_SHOWLINES : SCI_HIDELINES, line, lineMaxSubord);
-	while (line <= lineMaxSubord) {
-		const int levelLine = wEditor.Call(SCI_GETFOLDLEVEL, line);
-		if (levelLine & SC_FOLDLEVELHEADERFLAG) {
-			wEditor.Call(SCI_SETFOLDEXPANDED, line, expand ? 1 : 0);
+	if (expand) {
+		// Only folds that are contracted need to change
+		int lineContracted = wEditor.Call(SCI_CONTRACTEDFOLDNEXT, line);
+		while ((lineContracted >= 0) && (lineContracted <= lineMaxSubord)) {
+			wEditor.Call(SCI_SETFOLDEXPANDED, lineContracted, 1);
+			lineContracted = wEditor.Call(SCI_CONTRACTEDFOLDNEXT, lineContracted + 1);
+		}
+	} else if (line <= lineMaxSubord) {
+		const std::vector<int> levels = FoldLevels(line, lineMaxSubord + 1);
+		for (size_t i = 0; i < levels.size(); i++) {
+			if (levels[i] & SC_FOLDLEVELHEADERFLAG) {
+				wEditor.Call(SCI_SETFOLDEXPANDED, line + static_cast<int>(i), 0);
+			}
 		}
-		line++;
 	}
 }
 
 void SciTEBase::FoldAll() {
-	wEditor.Call(SCI_COLOURISE, 0, -1);
 	const int maxLine = wEditor.Call(SCI_GETLINECOUNT);
+	// Style only as far as the first fold header to decide whether to expand or contract
+	const int linesDiscover = 1000;
 	bool expanding = true;
-	for (int lineSeek = 0; lineSeek < maxLine; lineSeek++) {
+	bool discovered = false;
+	for (int lineSeek = 0; (lineSeek < maxLine) && !discovered; lineSeek++) {
+		if ((lineSeek % linesDiscover) == 0)
+			EnsureFoldLevels(lineSeek + linesDiscover);
 		if (wEditor.Call(SCI_GETFOLDLEVEL, lineSeek) & SC_FOLDLEVELHEADERFLAG) {
 			expanding = !wEditor.Call(SCI_GETFOLDEXPANDED, lineSeek);
-			break;
+			discovered = true;
 		}
 	}
-	for (int line = 0; line < maxLine; line++) {
-		const int level = wEditor.Call(SCI_GETFOLDLEVEL, line);
-		if ((level & SC_FOLDLEVELHEADERFLAG) &&
-		        (SC_FOLDLEVELBASE == LevelNumber(level))) {
-			const int lineMaxSubord = wEditor.Call(SCI_GETLASTCHILD, line, -1);
-			if (expanding) {
-				wEditor.Call(SCI_SETFOLDEXPANDED, line, 1);
-				ExpandFolds(line, true, level);
-				line = lineMaxSubord;
-			} else {
+	if (expanding) {
+		// Showing everything needs no fold levels and only contracted folds need to change
+		wEditor.Call(SCI_SHOWLINES, 0, maxLine - 1);
+		int lineContracted = wEditor.Call(SCI_CONTRACTEDFOLDNEXT, 0);
+		while (lineContracted >= 0) {
+			wEditor.Call(SCI_SETFOLDEXPANDED, lineContracted, 1);
+			lineContracted = wEditor.Call(SCI_CONTRACTEDFOLDNEXT, lineContracted + 1);
+		}
+	} else {
+		// Contract each top level fold then hide the merged ranges of subordinate lines
+		const std::vector<int> levels = FoldLevels(0, maxLine);
+		std::vector<LineRange> linesHide;
+		for (int line = 0; line < maxLine; line++) {
+			const int level = levels[line];
+			if ((level & SC_FOLDLEVELHEADERFLAG) &&
+			        (SC_FOLDLEVELBASE == LevelNumber(level))) {
 				wEditor.Call(SCI_SETFOLDEXPANDED, line, 0);
-				if (lineMaxSubord > line)
-					wEditor.Call(SCI_HIDELINES, line + 1, lineMaxSubord);
+				const int lineMaxSubord = LastChild(levels, line, -1);
+				if (lineMaxSubord > line) {
+					if (!linesHide.empty() && (linesHide.back().lineEnd >= line + 1)) {
+						linesHide.back().lineEnd = std::max(linesHide.back().lineEnd, lineMaxSubord + 1);
+					} else {
+						linesHide.emplace_back(line + 1, lineMaxSubord + 1);
+					}
+				}
 			}
 		}
+		for (const LineRange &range : linesHide) {
+			wEditor.Call(SCI_HIDELINES, range.lineStart, range.lineEnd - 1);
+		}
 	}
 }
 
@@ -3923,6 +4564,7 @@ void SciTEBase::Notify(SCNotification *notification) {
 			if (!handled) {
 				CurrentBuffer()->isDirty = false;
 			}
+			RemoveRecoveryFile(filePath);
 		}
 		CheckMenus();
 		SetWindowName();
@@ -3952,6 +4594,10 @@ void SciTEBase::Notify(SCNotification *notification) {
 		break;
 
 	case SCN_UPDATEUI:
+		if (macroPlaying) {
+			// Updated once the macro has finished
+			break;
+		}
 		if (extender)
 			handled = extender->OnUpdateUI();
 		if (!handled) {
@@ -3980,13 +4626,35 @@ void SciTEBase::Notify(SCNotification *notification) {
 				//	currentWordHighlight.statesOfDelay = currentWordHighlight.delayAlreadyElapsed;
 			}
 		}
+		if ((notification->updated & SC_UPDATE_V_SCROLL) &&
+			((currentWordHighlight.window != &wEditor) || (FeatureMode(SizeTiers::tfHighlightWord) != SizeTiers::tmVisible)) &&
+			matchMarker.ExtendToVisible()) {
+			// Highlight the current word in lines scrolled into view
+			SetIdler(true);
+		}
 		break;
 
 	case SCN_MODIFIED:
-		if ((notification->nmhdr.idFrom == IDM_SRCWIN) && 
-			(notification->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)))
-			CurrentBuffer()->DocumentModified();
-		if (notification->modificationType & SC_LASTSTEPINUNDOREDO) {
+		if (notification->modificationType & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)) {
+			if (notification->nmhdr.idFrom == IDM_SRCWIN) {
+				const int length = static_cast<int>(notification->length);
+				CurrentBuffer()->DocumentModified(static_cast<int>(notification->position),
+					(notification->modificationType & SC_MOD_INSERTTEXT) ? length : -length);
+				if (extender)
+					RecordModification(notification);
+			} else {
+				outputRevision++;
+				// Trimming and appending keep the diagnostics index valid but other changes do not
+				if ((notification->modificationType & SC_MOD_DELETETEXT) ? !OutputTrimming() :
+					(OutputOffsetFromPosition(notification->position) < diagnostics.offsetIndexed)) {
+					diagnostics.Clear();
+					ShowDiagnostics();
+				}
+			}
+		}
+		if (undoRedoLazy || macroPlaying) {
+			// Tool bar buttons are updated less accurately elsewhere or after the macro
+		} else if (notification->modificationType & SC_LASTSTEPINUNDOREDO) {
 			//when the user hits undo or redo, several normal insert/delete
 			//notifications may fire, but we will end up here in the end
 			EnableAMenuItem(IDM_UNDO, CallFocusedElseDefault(true, SCI_CANUNDO));
@@ -4003,7 +4671,8 @@ void SciTEBase::Notify(SCNotification *notification) {
 			}
 		}
 
-		if (notification->linesAdded && lineNumbers && lineNumbersExpand)
+		if (notification->linesAdded && lineNumbers && lineNumbersExpand && !macroPlaying &&
+			(FeatureMode(SizeTiers::tfLineNumbers) == SizeTiers::tmFull))
 			SetLineNumberWidth();
 
 		if (0 != (notification->modificationType & SC_MOD_CHANGEFOLD)) {
@@ -4106,6 +4775,8 @@ void SciTEBase::CheckMenus() {
 	CheckAMenuItem(IDM_WRAP, wrap);
 	CheckAMenuItem(IDM_WRAPOUTPUT, wrapOutput);
 	CheckAMenuItem(IDM_READONLY, CurrentBuffer()->isReadOnly);
+	EnableAMenuItem(IDM_ALLFEATURES, (CurrentBuffer()->sizeTier >= 0) &&
+		(CurrentBuffer()->featuresFull != (1 << SizeTiers::tfFeatures) - 1));
 	CheckAMenuItem(IDM_FULLSCREEN, fullScreen);
 	CheckAMenuItem(IDM_VIEWTOOLBAR, tbVisible);
 	CheckAMenuItem(IDM_VIEWTABBAR, tabVisible);
@@ -4219,27 +4890,77 @@ void SciTEBase::TimerEnd(int /* mask */) {
 
 void SciTEBase::OnTimer() {
 	if (delayBeforeAutoSave && (0 == dialogsOnScreen)) {
-		// First save the visible buffer to avoid any switching if not needed
-		if (CurrentBuffer()->NeedsSave(delayBeforeAutoSave)) {
-			Save(sfNone);
-		}
-		// Then look through the other buffers to save any that need to be saved
-		const int currentBuffer = buffers.Current();
+		// Buffers are written in the background so the visible document is never switched
 		for (int i = 0; i < buffers.length; i++) {
 			if (buffers.buffers[i].NeedsSave(delayBeforeAutoSave)) {
-				SetDocumentAt(i);
-				Save(sfNone);
+				AutoSaveBuffer(i);
 			}
 		}
-		SetDocumentAt(currentBuffer);
+	}
+	if (followFile && (0 == dialogsOnScreen)) {
+		CheckReload();
 	}
 }
 
+/**
+ * Add an editor insertion or deletion to the changes waiting for extensions.
+ * Typing, and deleting with Delete or Backspace, extend the previous change.
+ */
+void SciTEBase::RecordModification(const SCNotification *notification) {
+	const sptr_t doc = wEditor.CallReturnPointer(SCI_GETDOCPOINTER);
+	if (doc != modificationsDocument) {
+		// Changes to a document that has since been closed
+		modifications.clear();
+		modificationsDocument = doc;
+	}
+	const int length = static_cast<int>(notification->length);
+	const DocumentDelta delta = {
+		static_cast<int>(notification->position),
+		(notification->modificationType & SC_MOD_INSERTTEXT) ? length : -length,
+		static_cast<int>(notification->linesAdded)
+	};
+	if (modifications.empty()) {
+		SetIdler(true);
+	} else {
+		DocumentDelta &last = modifications.back();
+		if ((delta.length > 0) && (last.length > 0) && (delta.position == last.position + last.length)) {
+			last.length += delta.length;
+			last.linesAdded += delta.linesAdded;
+			return;
+		}
+		if ((delta.length < 0) && (last.length < 0) &&
+			((delta.position == last.position) || (delta.position - delta.length == last.position))) {
+			last.position = delta.position;
+			last.length += delta.length;
+			last.linesAdded += delta.linesAdded;
+			return;
+		}
+	}
+	modifications.push_back(delta);
+}
+
+void SciTEBase::DeliverModifications() {
+	if (modifications.empty())
+		return;
+	// Extensions may modify the document, adding to a new list
+	std::vector<DocumentDelta> deltas;
+	deltas.swap(modifications);
+	if (extender && (modificationsDocument == wEditor.CallReturnPointer(SCI_GETDOCPOINTER)))
+		extender->OnModified(deltas.data(), deltas.size());
+}
+
 void SciTEBase::SetIdler(bool on) {
 	needIdle = on;
 }
 
 void SciTEBase::OnIdle() {
+	if (!outputPending.empty()) {
+		OutputFlush();
+	}
+	if (sbPending) {
+		RenderStatusBar();
+	}
+	DeliverModifications();
 	if (!findMarker.Complete()) {
 		findMarker.Continue();
 		return;
@@ -4248,6 +4969,9 @@ void SciTEBase::OnIdle() {
 		matchMarker.Continue();
 		return;
 	}
+	if (ContinueBraceIndex()) {
+		return;
+	}
 	SetIdler(false);
 }
 
@@ -4285,8 +5009,13 @@ void SciTEBase::PerformOne(char *action) {
 		arg++;
 		if (isprefix(action, "askfilename:")) {
 			extender->OnMacro("filename", filePath.AsUTF8().c_str());
+		} else if (isprefix(action, "askmacro:")) {
+			// Escaped as a whole so the line ends between steps do not split the message
+			extender->OnMacro("macrotext", Slash(macroRecorded.ToText(), false).c_str());
 		} else if (isprefix(action, "askproperty:")) {
 			PropertyToDirector(arg);
+		} else if (isprefix(action, "askchanges:")) {
+			ChangesToDirector(arg);
 		} else if (isprefix(action, "close:")) {
 			Close();
 			WindowSetFocus(wEditor);
@@ -4298,6 +5027,8 @@ void SciTEBase::PerformOne(char *action) {
 				GUI::gui_string msg = LocaliseMessage("Invalid directory '^0'.", dirTarget.AsInternal());
 				WindowMessageBox(wSciTE, msg);
 			}
+		} else if (isprefix(action, "enablefeature:")) {
+			EnableFeature(arg);
 		} else if (isprefix(action, "enumproperties:")) {
 			EnumProperties(arg);
 		} else if (isprefix(action, "exportashtml:")) {
@@ -4332,11 +5063,19 @@ void SciTEBase::PerformOne(char *action) {
 			wEditor.CallString(SCI_REPLACESEL, 0, arg);
 		} else if (isprefix(action, "loadsession:")) {
 			if (*arg) {
-				LoadSessionFile(GUI::StringFromUTF8(arg).c_str());
-				RestoreSession();
+				if (LoadSessionFile(GUI::StringFromUTF8(arg).c_str()))
+					RestoreSession();
 			}
 		} else if (isprefix(action, "macrocommand:")) {
 			ExecuteMacroCommand(arg);
+		} else if (isprefix(action, "macroimport:")) {
+			if (!macroRecorded.FromText(arg)) {
+				Trace("Malformed macro text.\n");
+			}
+		} else if (isprefix(action, "macroplay:")) {
+			PlayMacro(macroRecorded, *arg ? atoi(arg) : 1, false);
+		} else if (isprefix(action, "macroplaylines:")) {
+			PlayMacro(macroRecorded, *arg ? atoi(arg) : 1, true);
 		} else if (isprefix(action, "macroenable:")) {
 			macrosEnabled = atoi(arg);
 			SetToolsMenu();
@@ -4350,6 +5089,12 @@ void SciTEBase::PerformOne(char *action) {
 			wOutput.CallString(SCI_REPLACESEL, 0, arg);
 		} else if (isprefix(action, "property:")) {
 			PropertyFromDirector(arg);
+		} else if (isprefix(action, "readrange:")) {
+			RangeToDirector(arg, false);
+		} else if (isprefix(action, "readrangeshared:")) {
+			RangeToDirector(arg, true);
+		} else if (isprefix(action, "releaseshared:")) {
+			ReleaseSharedRange(arg);
 		} else if (isprefix(action, "reloadproperties:")) {
 			ReloadProperties();
 		} else if (isprefix(action, "quit:")) {
@@ -4361,6 +5106,8 @@ void SciTEBase::PerformOne(char *action) {
 				replaceWhat = arg2;
 				ReplaceAll(false);
 			}
+		} else if (isprefix(action, "writerange:")) {
+			RangeFromDirector(arg, action + len);
 		} else if (isprefix(action, "saveas:")) {
 			if (*arg) {
 				SaveAs(GUI::StringFromUTF8(arg).c_str(), true);
@@ -4443,19 +5190,268 @@ void SciTEBase::PropertyToDirector(const char *arg) {
 	extender->OnMacro("macro:stringinfo", gotprop.c_str());
 }
 
+/**
+ * Parse "pane,start,length" as used by the range verbs where pane is editor or output
+ * and a negative length extends to the end of the document. The range is clamped to
+ * the document. Returns the remainder of @a arg or nullptr if it is not a range.
+ */
+const char *SciTEBase::DirectorRange(const char *arg, Pane &pane, int &start, int &length) {
+	if (isprefix(arg, "editor,")) {
+		pane = paneEditor;
+	} else if (isprefix(arg, "output,")) {
+		pane = paneOutput;
+	} else {
+		return nullptr;
+	}
+	char *end = nullptr;
+	start = static_cast<int>(strtol(arg + strlen("editor,"), &end, 10));
+	if (*end != ',')
+		return nullptr;
+	length = static_cast<int>(strtol(end + 1, &end, 10));
+	const int lengthDocument = static_cast<int>(Send(pane, SCI_GETLENGTH));
+	start = std::clamp(start, 0, lengthDocument);
+	if ((length < 0) || (length > lengthDocument - start))
+		length = lengthDocument - start;
+	return end;
+}
+
+/**
+ * Send text to the director as "range:start,length,revision,documentLength:text".
+ * At most director.chunk.size bytes are sent so large ranges are read by asking for
+ * each following chunk in turn. On Linux, a shared request instead writes the whole
+ * range to a memory file and sends "sharedrange:start,length,revision,documentLength:path"
+ * where path remains valid until released with "releaseshared:path".
+ */
+void SciTEBase::RangeToDirector(const char *arg, bool shared) {
+	Pane pane = paneEditor;
+	int start = 0;
+	int length = 0;
+	if (!extender || !DirectorRange(arg, pane, start, length))
+		return;
+	GUI::ScintillaWindow &win = (pane == paneEditor) ? wEditor : wOutput;
+	const std::string revisions = StdStringFromInteger(Revision(pane)) + "," +
+		StdStringFromInteger(win.Call(SCI_GETLENGTH));
+#if defined(__linux__)
+	if (shared) {
+		const int fd = memfd_create("SciTE range", MFD_CLOEXEC);
+		if (fd >= 0) {
+			const char *text = reinterpret_cast<const char *>(
+				win.CallReturnPointer(SCI_GETCHARACTERPOINTER)) + start;
+			int written = 0;
+			while (written < length) {
+				const ssize_t lenWrite = write(fd, text + written, length - written);
+				if (lenWrite <= 0)
+					break;
+				written += static_cast<int>(lenWrite);
+			}
+			if (written == length) {
+				// Only the newest few are kept in case directors never release them
+				constexpr size_t sharedRangesMaximum = 16;
+				if (sharedRanges.size() >= sharedRangesMaximum) {
+					close(sharedRanges.front());
+					sharedRanges.erase(sharedRanges.begin());
+				}
+				sharedRanges.push_back(fd);
+				const std::string reply = StdStringFromInteger(start) + "," + StdStringFromInteger(length) + "," +
+					revisions + ":/proc/" + StdStringFromInteger(getpid()) + "/fd/" + StdStringFromInteger(fd);
+				extender->OnMacro("sharedrange", reply.c_str());
+				return;
+			}
+			close(fd);
+		}
+	}
+#else
+	(void)shared;
+#endif
+	const int chunkSize = props.GetInt("director.chunk.size", 65536);
+	if ((chunkSize > 0) && (length > chunkSize))
+		length = chunkSize;
+	const std::string text = Range(pane, start, start + length);
+	const std::string reply = StdStringFromInteger(start) + "," + StdStringFromInteger(length) + "," +
+		revisions + ":" + Slash(text, false);
+	extender->OnMacro("range", reply.c_str());
+}
+
+/**
+ * Replace a range with text from "pane,start,length,revision:text". When revision is not
+ * negative and the pane has been modified since then, nothing is changed and
+ * "rangerejected:revision" is sent with the current revision. Otherwise
+ * "rangewritten:start,length,revision" acknowledges the change so directors can wait
+ * for each chunk to be written before sending more.
+ */
+void SciTEBase::RangeFromDirector(const char *arg, const char *argEnd) {
+	Pane pane = paneEditor;
+	int start = 0;
+	int length = 0;
+	const char *rest = DirectorRange(arg, pane, start, length);
+	if (!extender || !rest || (*rest != ','))
+		return;
+	char *end = nullptr;
+	const int revision = static_cast<int>(strtol(rest + 1, &end, 10));
+	if (*end != ':')
+		return;
+	const char *text = end + 1;
+	if ((revision >= 0) && (revision != Revision(pane))) {
+		extender->OnMacro("rangerejected", StdStringFromInteger(Revision(pane)).c_str());
+		return;
+	}
+	GUI::ScintillaWindow &win = (pane == paneEditor) ? wEditor : wOutput;
+	const int lengthText = static_cast<int>(argEnd - text);
+	win.Call(SCI_SETTARGETRANGE, start, start + length);
+	win.CallPointer(SCI_REPLACETARGET, lengthText, const_cast<char *>(text));
+	const std::string reply = StdStringFromInteger(start) + "," + StdStringFromInteger(lengthText) + "," +
+		StdStringFromInteger(Revision(pane));
+	extender->OnMacro("rangewritten", reply.c_str());
+}
+
+/**
+ * Send the modifications to the current buffer after a revision as
+ * "changes:revision,currentRevision:position,length;position,length;..." with
+ * negative lengths for deletions, or with "*" in place of the list when the
+ * changes are no longer known so the director should read the whole document.
+ */
+void SciTEBase::ChangesToDirector(const char *arg) {
+	if (!extender)
+		return;
+	const int since = atoi(arg);
+	const Buffer *buffer = CurrentBufferConst();
+	std::string reply = StdStringFromInteger(since) + "," + StdStringFromInteger(buffer->revision) + ":";
+	if ((since < buffer->revisionChangesFrom) || (since > buffer->revision)) {
+		reply += "*";
+	} else {
+		auto it = std::upper_bound(buffer->changes.begin(), buffer->changes.end(), since,
+			[](int revision, const RevisionChange &change) noexcept { return revision < change.revision; });
+		for (; it != buffer->changes.end(); ++it) {
+			reply += StdStringFromInteger(it->position);
+			reply += ",";
+			reply += StdStringFromInteger(it->length);
+			reply += ";";
+		}
+	}
+	extender->OnMacro("changes", reply.c_str());
+}
+
+void SciTEBase::ReleaseSharedRange(const char *arg) {
+#if defined(__linux__)
+	const char *lastSlash = strrchr(arg, '/');
+	const int fd = atoi(lastSlash ? lastSlash + 1 : arg);
+	auto it = std::find(sharedRanges.begin(), sharedRanges.end(), fd);
+	if (it != sharedRanges.end()) {
+		close(fd);
+		sharedRanges.erase(it);
+	}
+#else
+	(void)arg;
+#endif
+}
+
 /**
  * Menu/Toolbar command "Record".
  */
 void SciTEBase::StartRecordMacro() {
 	recording = true;
+	macroRecorded.Clear();
 	CheckMenus();
 	wEditor.Call(SCI_STARTRECORD);
 }
 
+void Macro::Clear() noexcept {
+	steps.clear();
+	pool.clear();
+}
+
+void Macro::Add(unsigned int message, uptr_t wParam, const char *text) {
+	if (text && (message == SCI_REPLACESEL) && !steps.empty() &&
+		(steps.back().message == SCI_REPLACESEL) && (steps.back().text >= 0)) {
+		// Typing records a replacement for each character: join them as they
+		// insert the same text. The previous text is always last in the pool.
+		pool.pop_back();
+		pool += text;
+		pool.push_back('\0');
+		return;
+	}
+	Step step = { message, wParam, -1 };
+	if (text) {
+		step.text = pool.length();
+		pool += text;
+		pool.push_back('\0');
+	}
+	steps.push_back(step);
+}
+
+void Macro::Play(GUI::ScintillaWindow &win) const {
+	const char *texts = pool.c_str();
+	for (const Step &step : steps) {
+		win.Call(step.message, step.wParam, (step.text >= 0) ? SptrFromString(texts + step.text) : 0);
+	}
+}
+
+/**
+ * Text form of a macro with a line for each step in the format sent by "macro:record"
+ * but with the text argument escaped.
+ */
+std::string Macro::ToText() const {
+	std::string text;
+	for (const Step &step : steps) {
+		text += StdStringFromInteger(step.message);
+		text += ";";
+		text += StdStringFromSizeT(static_cast<size_t>(step.wParam));
+		if (step.text >= 0) {
+			text += ";1;";
+			text += Slash(pool.c_str() + step.text, false);
+		} else {
+			text += ";0;";
+		}
+		text += "\n";
+	}
+	return text;
+}
+
+/**
+ * Replace the macro with the steps in text produced by ToText.
+ * Return false and leave the macro unchanged when the text is malformed.
+ */
+bool Macro::FromText(const char *text) {
+	Macro macro;
+	while (*text) {
+		const char *lineEnd = strchr(text, '\n');
+		if (!lineEnd) {
+			lineEnd = text + strlen(text);
+		}
+		const std::string line(text, lineEnd);
+		text = *lineEnd ? lineEnd + 1 : lineEnd;
+		if (line.empty() || (line == "\r")) {
+			continue;
+		}
+		char *end = nullptr;
+		const unsigned long message = strtoul(line.c_str(), &end, 10);
+		if (*end != ';') {
+			return false;
+		}
+		const unsigned long long wParam = strtoull(end + 1, &end, 10);
+		if ((end[0] != ';') || ((end[1] != '0') && (end[1] != '1')) || (end[2] != ';')) {
+			return false;
+		}
+		if (end[1] == '1') {
+			std::string argument = UnSlashString(end + 3);
+			if (!argument.empty() && (argument.back() == '\r')) {
+				argument.pop_back();
+			}
+			macro.Add(static_cast<unsigned int>(message), static_cast<uptr_t>(wParam), argument.c_str());
+		} else {
+			macro.Add(static_cast<unsigned int>(message), static_cast<uptr_t>(wParam), nullptr);
+		}
+	}
+	*this = std::move(macro);
+	return true;
+}
+
 /**
- * Received a SCN_MACRORECORD from Scintilla: send it to director.
+ * Received a SCN_MACRORECORD from Scintilla: keep it and send it to director.
  */
 bool SciTEBase::RecordMacroCommand(const SCNotification *notification) {
+	macroRecorded.Add(notification->message, static_cast<uptr_t>(notification->wParam),
+		reinterpret_cast<const char *>(notification->lParam));
 	if (extender) {
 		std::string sMessage = StdStringFromInteger(notification->message);
 		sMessage += ";";
@@ -4525,6 +5521,55 @@ void SciTEBase::StartPlayMacro() {
 		extender->OnMacro("macro:run", currentMacro.c_str());
 }
 
+/**
+ * Play a macro times over as a single undo action. With eachLine, the caret is placed at the
+ * start of each line of the selection in turn and the macro played there.
+ * Updates to menus and the display that would otherwise follow each step are made once at the end.
+ */
+void SciTEBase::PlayMacro(const Macro &macro, int times, bool eachLine) {
+	if (macro.Empty() || (times <= 0) || recording) {
+		// Playing while recording would add to macroRecorded as it is read
+		return;
+	}
+	macroPlaying = true;
+	wEditor.Call(SCI_BEGINUNDOACTION);
+	if (eachLine) {
+		const Sci_CharacterRange crange = GetSelection();
+		int line = wEditor.Call(SCI_LINEFROMPOSITION, crange.cpMin);
+		int lineLast = wEditor.Call(SCI_LINEFROMPOSITION, crange.cpMax);
+		if ((lineLast > line) && (crange.cpMax == wEditor.Call(SCI_POSITIONFROMLINE, lineLast))) {
+			// Selection ends at the start of a line which is not included
+			lineLast--;
+		}
+		while ((line <= lineLast) && (line < wEditor.Call(SCI_GETLINECOUNT))) {
+			const int linesBefore = wEditor.Call(SCI_GETLINECOUNT);
+			wEditor.Call(SCI_SETEMPTYSELECTION, wEditor.Call(SCI_POSITIONFROMLINE, line));
+			for (int i = 0; i < times; i++) {
+				macro.Play(wEditor);
+			}
+			// Follow lines inserted or removed by the macro so each original line is visited once
+			const int linesAdded = wEditor.Call(SCI_GETLINECOUNT) - linesBefore;
+			line += 1 + linesAdded;
+			lineLast += linesAdded;
+		}
+	} else {
+		for (int i = 0; i < times; i++) {
+			macro.Play(wEditor);
+		}
+	}
+	wEditor.Call(SCI_ENDUNDOACTION);
+	macroPlaying = false;
+
+	if (!undoRedoLazy) {
+		EnableAMenuItem(IDM_UNDO, CallFocusedElseDefault(true, SCI_CANUNDO));
+		EnableAMenuItem(IDM_REDO, CallFocusedElseDefault(true, SCI_CANREDO));
+	}
+	if (lineNumbers && lineNumbersExpand)
+		SetLineNumberWidth();
+	wEditor.Call(SCI_SCROLLCARET);
+	UpdateStatusBar(false);
+}
+
 /*
 SciTE received a macro command from director : execute it.
 If command needs answer (SCI_GETTEXTLENGTH ...) : give answer to director
@@ -4759,6 +5804,10 @@ void SciTEBase::Insert(Pane p, int pos, const char *s) {
 		wOutput.CallString(SCI_INSERTTEXT, pos, s);
 }
 
+int SciTEBase::Revision(Pane p) {
+	return (p == paneEditor) ? CurrentBuffer()->revision : outputRevision;
+}
+
 void SciTEBase::Trace(const char *s) {
 	ShowOutputOnMainThread();
 	OutputAppendStringSynchronised(s);
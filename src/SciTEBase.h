@@ -85,8 +85,256 @@ public:
 	std::vector<BufferState> buffers;
 };
 
+/// A buffer as last written to or read from a compact session file along with its encoding
+struct SessionRecord {
+	int position;
+	int scrollPosition;
+	bool current;
+	std::vector<int> bookmarks;
+	std::vector<int> foldState;
+	bool withBookmarks;
+	bool withFolds;
+	std::string encoded;	///< Payload of the record, reused while the buffer is unchanged
+};
+
+/// A recorded macro compiled to Scintilla messages with its text arguments held in one pool
+class Macro {
+public:
+	struct Step {
+		unsigned int message;
+		uptr_t wParam;
+		ptrdiff_t text;	///< Offset of the NUL terminated text argument in pool or -1 for none
+	};
+	std::vector<Step> steps;
+	std::string pool;
+	void Clear() noexcept;
+	bool Empty() const noexcept {
+		return steps.empty();
+	}
+	void Add(unsigned int message, uptr_t wParam, const char *text);
+	void Play(GUI::ScintillaWindow &win) const;
+	std::string ToText() const;
+	bool FromText(const char *text);
+};
+
+/// Status bar template split into literal text and variables so it is only parsed when it changes
+class StatusBarTemplate {
+public:
+	/// Groups of status bar fields that are recomputed together when their inputs change
+	enum Dependency { sdCaret=1, sdSelection=2, sdDocument=4, sdAll=7 };
+	struct Segment {
+		std::string text;	///< Literal text or the name of a variable
+		bool variable;
+		int dependencies;	///< Fields the variable is computed from
+	};
+	std::string key;
+	std::string source;
+	bool compiled;	///< false when the template has nested variables and must be expanded as a whole
+	std::vector<Segment> segments;
+	StatusBarTemplate() noexcept : compiled(false) {}
+	void Compile(const std::string &key_, const std::string &source_);
+	static int FieldDependencies(const std::string &name);
+};
+
+/// Editor state that status bar fields are computed from
+struct StatusBarState {
+	sptr_t document = 0;
+	int revision = -1;
+	int length = -1;
+	int caret = -1;
+	int anchor = -1;
+	int caretVirtual = -1;
+	int anchorVirtual = -1;
+	int selectionStart = -1;
+	int selectionEnd = -1;
+	int selectionMode = -1;
+	int overType = -1;
+	int tabWidth = -1;
+	int readOnly = -1;
+	int eolMode = -1;
+	int sizeTier = -2;
+	int Differences(const StatusBarState &other) const noexcept;
+};
+
 struct FileWorker;
 
+// A modification of a document as kept for directors asking for changes
+struct RevisionChange {
+	int revision;	///< Revision of the document after the change
+	int position;
+	int length;	///< Positive for insertion, negative for deletion
+};
+
+/**
+ * Entries with a position field kept in order of position, arranged like Scintilla's Partitioning.
+ * A gap at the last insertion or removal makes further changes near there cheap and
+ * moving the entries after a modification is deferred as a step applied lazily, so the
+ * cost of a modification depends on its distance from the previous one, not on the size.
+ */
+template <typename T>
+class PositionIndex {
+	std::vector<T> body;
+	ptrdiff_t part1Length = 0;	// Entries before the gap
+	ptrdiff_t gapLength = 0;
+	ptrdiff_t stepIndex = 0;	// Entries from here are yet to be moved by stepLength
+	int stepLength = 0;
+
+	T &Raw(ptrdiff_t index) noexcept {
+		return body[(index < part1Length) ? index : index + gapLength];
+	}
+	const T &Raw(ptrdiff_t index) const noexcept {
+		return body[(index < part1Length) ? index : index + gapLength];
+	}
+	void ApplyStep(ptrdiff_t indexUpTo) noexcept {
+		for (ptrdiff_t i = stepIndex; i < indexUpTo; i++)
+			Raw(i).position += stepLength;
+		stepIndex = indexUpTo;
+		if (stepIndex >= Length()) {
+			stepIndex = Length();
+			stepLength = 0;
+		}
+	}
+	void BackStep(ptrdiff_t indexDownTo) noexcept {
+		for (ptrdiff_t i = indexDownTo; i < stepIndex; i++)
+			Raw(i).position -= stepLength;
+		stepIndex = indexDownTo;
+	}
+	void GapTo(ptrdiff_t index) noexcept {
+		while (part1Length > index) {
+			part1Length--;
+			body[part1Length + gapLength] = body[part1Length];
+		}
+		while (part1Length < index) {
+			body[part1Length] = body[part1Length + gapLength];
+			part1Length++;
+		}
+	}
+public:
+	void Clear() noexcept {
+		body.clear();
+		part1Length = 0;
+		gapLength = 0;
+		stepIndex = 0;
+		stepLength = 0;
+	}
+	ptrdiff_t Length() const noexcept {
+		return static_cast<ptrdiff_t>(body.size()) - gapLength;
+	}
+	int PositionAt(ptrdiff_t index) const noexcept {
+		return Raw(index).position + ((index >= stepIndex) ? stepLength : 0);
+	}
+	T At(ptrdiff_t index) const noexcept {
+		T entry = Raw(index);
+		entry.position = PositionAt(index);
+		return entry;
+	}
+	/// Index of the first entry at or after position
+	ptrdiff_t IndexAtOrAfter(int position) const noexcept {
+		ptrdiff_t lower = 0;
+		ptrdiff_t upper = Length();
+		while (lower < upper) {
+			const ptrdiff_t middle = lower + (upper - lower) / 2;
+			if (PositionAt(middle) < position)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		return lower;
+	}
+	/// Move the entries from index onwards by delta
+	void Shift(ptrdiff_t index, int delta) noexcept {
+		if (stepLength == 0) {
+			stepIndex = index;
+		} else if (index >= stepIndex) {
+			ApplyStep(index);
+		} else if (index >= stepIndex - Length() / 10) {
+			BackStep(index);
+		} else {
+			ApplyStep(Length());
+			stepIndex = index;
+		}
+		stepLength += delta;
+	}
+	void Erase(ptrdiff_t first, ptrdiff_t last) {
+		if (first >= last)
+			return;
+		GapTo(first);
+		gapLength += last - first;
+		if (stepIndex >= last)
+			stepIndex -= last - first;
+		else if (stepIndex > first)
+			stepIndex = first;
+	}
+	/// Insert entries with absolute positions which must fit in order at index
+	void Insert(ptrdiff_t index, const std::vector<T> &entries) {
+		const ptrdiff_t count = static_cast<ptrdiff_t>(entries.size());
+		if (count == 0)
+			return;
+		if (gapLength < count) {
+			GapTo(Length());
+			const size_t growth = count + body.size() / 2 + 8;
+			body.resize(body.size() + growth);
+			gapLength += growth;
+		}
+		GapTo(index);
+		const int adjust = (index >= stepIndex) ? stepLength : 0;
+		for (const T &entry : entries) {
+			body[part1Length] = entry;
+			body[part1Length].position -= adjust;
+			part1Length++;
+		}
+		gapLength -= count;
+		if (index < stepIndex)
+			stepIndex += count;
+	}
+};
+
+/// Brackets and preprocessor conditionals of a document so matching can avoid searching the text
+class BraceIndex {
+public:
+	struct Brace {
+		int position;
+		int style;
+		char ch;
+	};
+	struct Conditional {
+		int position;	///< Start of the line
+		int kind;	///< A SciTEBase::PreProcKind
+	};
+	PositionIndex<Brace> braces;
+	PositionIndex<Conditional> conditionals;
+	int verifiedEnd;	///< Entries before this position are current, later entries are candidates
+	int modifiedEnd;	///< Candidates after this position have only been moved by modifications
+	int lexer;	///< Lexer that styled the indexed braces
+
+	BraceIndex() noexcept : verifiedEnd(0), modifiedEnd(0), lexer(-1) {}
+	void Clear() noexcept;
+	void Modified(int position, int length);
+	void Restyled(int position, int lexer_);
+	void Replace(int start, int end, int length,
+		const std::vector<Brace> &bracesFound, const std::vector<Conditional> &conditionalsFound);
+	bool Complete(int length) const noexcept {
+		return verifiedEnd >= length;
+	}
+	int MatchingBrace(int position) const;
+};
+
+/// How features whose cost grows with document size are reduced for larger documents
+class SizeTiers {
+public:
+	enum Feature { tfHighlightWord, tfBraces, tfWordCompletion, tfIndentDiscovery, tfFold, tfLineNumbers, tfFeatures };
+	enum Mode { tmInherit=-1, tmFull, tmLazy, tmVisible, tmOff };
+	struct Tier {
+		std::string name;
+		long long size;	///< Documents larger than this are in the tier
+		Mode modes[tfFeatures];
+	};
+	std::vector<Tier> tiers;	///< Ordered by increasing size
+	void Read(const PropSetFile &props);
+	int TierFromSize(long long size) const noexcept;
+	static int FeatureFromName(const char *name) noexcept;
+};
+
 class Buffer {
 public:
 	RecentFile file;
@@ -100,17 +348,30 @@ public:
 	time_t fileModTime;
 	time_t fileModLastAsk;
 	time_t documentModTime;
+	long long fileLength;	///< Length of file when last read or written
+	bool changedOnDisk;	///< Notified of a change to the file that has not yet been checked
+	int revision;	///< Incremented on each modification so completed saves can tell if they are stale
+	int revisionStoring;	///< Revision being written by pFileWorker
+	int revisionAutoSaved;	///< Revision last written by an automatic save
+	std::vector<RevisionChange> changes;	///< Recent modifications in order of revision
+	int revisionChangesFrom;	///< changes holds every modification after this revision
+	const char *documentBytes;	///< Text of a hidden document, valid until it is shown again
+	size_t documentLength;
 	enum { fmNone, fmTemporary, fmMarked, fmModified} findMarks;
 	std::string overrideExtension;	///< User has chosen to use a particular language
 	std::vector<int> foldState;
 	std::vector<int> bookmarks;
+	BraceIndex braceIndex;
+	int sizeTier;	///< Index into SizeTiers::tiers or -1 when all features are used fully
+	int featuresFull;	///< Bit for each SizeTiers::Feature enabled fully despite the size tier
 	FileWorker *pFileWorker;
 	PropSetFile props;
 	enum FutureDo { fdNone=0, fdFinishSave=1 } futureDo;
 	Buffer() :
 			file(), doc(0), isDirty(false), isReadOnly(false), failedSave(false), useMonoFont(false), lifeState(empty),
-			unicodeMode(uni8Bit), fileModTime(0), fileModLastAsk(0), documentModTime(0),
-			findMarks(fmNone), pFileWorker(nullptr), futureDo(fdNone) {}
+			unicodeMode(uni8Bit), fileModTime(0), fileModLastAsk(0), documentModTime(0), fileLength(0), changedOnDisk(false),
+			revision(0), revisionStoring(0), revisionAutoSaved(0), revisionChangesFrom(0), documentBytes(nullptr), documentLength(0),
+			findMarks(fmNone), sizeTier(-1), featuresFull(0), pFileWorker(nullptr), futureDo(fdNone) {}
 
 	~Buffer() = default;
 	void Init() {
@@ -124,10 +385,22 @@ public:
 		fileModTime = 0;
 		fileModLastAsk = 0;
 		documentModTime = 0;
+		fileLength = 0;
+		changedOnDisk = false;
+		revision = 0;
+		revisionStoring = 0;
+		revisionAutoSaved = 0;
+		changes.clear();
+		revisionChangesFrom = 0;
+		documentBytes = nullptr;
+		documentLength = 0;
 		findMarks = fmNone;
 		overrideExtension = "";
 		foldState.clear();
 		bookmarks.clear();
+		braceIndex.Clear();
+		sizeTier = -1;
+		featuresFull = 0;
 		pFileWorker = nullptr;
 		futureDo = fdNone;
 	}
@@ -136,12 +409,17 @@ public:
 		fileModTime = file.ModifiedTime();
 		fileModLastAsk = fileModTime;
 		documentModTime = fileModTime;
+		fileLength = file.GetFileLength();
+		changedOnDisk = false;
 		failedSave = false;
 	}
 
-	void DocumentModified();
+	void DocumentModified(int position, int length);
 	bool NeedsSave(int delayBeforeSave) const;
 
+	void DocumentHidden(const char *documentBytes_, size_t documentLength_) noexcept;
+	void DocumentShown() noexcept;
+
 	void CompleteLoading();
 	void CompleteStoring();
 	void AbandonAutomaticSave();
@@ -264,15 +542,63 @@ struct CurrentWordHighlight {
 	bool textHasChanged;
 	GUI::ElapsedTime elapsedTimes;
 	bool isOnlyWithSameStyle;
+	// What was last highlighted so unchanged requests can be skipped
+	GUI::ScintillaWindow *window;	///< nullptr when nothing is highlighted
+	sptr_t document;
+	int revision;
+	int style;
+	std::string word;
 
 	CurrentWordHighlight() {
 		statesOfDelay = noDelay;
 		isEnabled = false;
 		textHasChanged = false;
 		isOnlyWithSameStyle = false;
+		window = nullptr;
+		document = 0;
+		revision = 0;
+		style = -1;
 	}
 };
 
+/// A line in the output pane that GoMessage can visit
+struct DiagnosticMessage {
+	sptr_t offset;	///< Output offset of the start of the line
+	int block;	///< Number of commands started before this message
+	int style;
+	int sourceLine;	///< -1 when not decoded
+	int column;
+	char severity;	///< 0 for information, 1 for warning, 2 for error and 3 for fatal
+	std::string message;	///< Text shown as an annotation
+};
+
+/// The messages about source files with one name
+struct DiagnosticFile {
+	FilePath name;
+	std::vector<size_t> messages;	///< Indices into DiagnosticsIndex::messages
+	std::vector<int> linesAnnotated;	///< Lines annotated when last shown
+	explicit DiagnosticFile(const FilePath &name_) : name(name_) {}
+};
+
+/// Index of the messages in the output pane which is extended as output arrives
+struct DiagnosticsIndex {
+	std::vector<DiagnosticMessage> messages;	///< In order of offset
+	std::vector<DiagnosticFile> files;
+	std::vector<DiagnosticFile> filesStale;	///< Lines still annotated from cleared messages
+	sptr_t offsetIndexed;	///< Output offset up to which complete lines have been examined
+	int blocksIndexed;	///< Commands seen before offsetIndexed
+	int blocks;	///< Commands seen including the incomplete last line
+	int blockShown;	///< Block shown as annotations or -1
+	size_t current;	///< Message most recently visited
+
+	DiagnosticsIndex() noexcept : offsetIndexed(0), blocksIndexed(0), blocks(0), blockShown(-1), current(0) {}
+	void Clear();
+	void Trim(sptr_t offsetStart);
+	void RemoveIncomplete();
+	DiagnosticFile *Find(const FilePath &name);
+	DiagnosticFile *Add(const FilePath &name);
+};
+
 class Localization : public PropSetFile, public ILocalize {
 	std::string missing;
 public:
@@ -355,6 +681,7 @@ public:
 };
 
 class IEditorConfig;
+class FileWatcher;
 
 class SciTEBase : public ExtensionAPI, public Searcher, public WorkerListener {
 protected:
@@ -436,6 +763,10 @@ protected:
 	bool sbVisible;	///< @c true if status bar is visible.
 	std::string sbValue;	///< Status bar text.
 	int sbNum;	///< Number of the currently displayed status bar information.
+	bool sbPending;	///< Status bar is rendered when idle so many updates in one event display once.
+	StatusBarTemplate sbTemplate;
+	StatusBarState sbState;	///< State the status bar fields in propsStatus were computed from
+	int sbFieldsValid;	///< Dependency groups whose fields are up to date with sbState
 	int visHeightTools;
 	int visHeightTab;
 	int visHeightStatus;
@@ -460,8 +791,9 @@ protected:
 	bool quitting;
 
 	int timerMask;
-	enum { timerAutoSave=1 };
+	enum { timerAutoSave=1, timerFollow=2 };
 	int delayBeforeAutoSave;
+	bool followFile;
 
 	int heightOutput;
 	int heightOutputStartDrag;
@@ -515,11 +847,26 @@ protected:
 	bool allowMenuActions;
 	int scrollOutput;
 	bool returnOutputToCommand;
+	int outputMaxLines;	///< When non-zero, oldest output lines are removed to stay within limits
+	sptr_t outputMaxBytes;
+	std::unique_ptr<Mutex> mutexOutputTrim;	///< Guards outputTrimmed and outputTrimming as Win32 trims from its command thread
+	sptr_t outputTrimmed;	///< Total bytes removed from start of output pane
+	int outputRevision;	///< Incremented on each modification of the output pane
+	bool outputTrimming;	///< OutputTrim is removing old lines
+	DiagnosticsIndex diagnostics;
+	std::vector<int> sharedRanges;	///< Files holding text for directors until released
+	bool undoRedoLazy;
+	std::vector<DocumentDelta> modifications;	///< Editor changes not yet sent to extensions
+	sptr_t modificationsDocument;
+	std::string outputPending;	///< Text waiting to be added to a bounded output pane
+	GUI::ElapsedTime outputSinceFlush;
 	JobQueue jobQueue;
 
 	bool macrosEnabled;
 	std::string currentMacro;
 	bool recording;
+	Macro macroRecorded;	///< Commands of the last recording, replayed in bulk by the macroplay: and macroplaylines: director commands
+	bool macroPlaying;	///< Per step updates of menus and line number width are skipped
 
 	PropSetFile propsPlatform;
 	PropSetFile propsEmbed;
@@ -533,6 +880,12 @@ protected:
 	PropSetFile propsAbbrev;
 
 	PropSetFile propsSession;
+	std::map<std::string, std::vector<int>> sessionLines;	///< Bookmarks and folds read from a compact session
+	std::map<std::string, SessionRecord> sessionRecords;	///< Compact buffer records by path
+	FilePath sessionPathWritten;
+	std::string sessionWritten;	///< Contents of the session file last written to sessionPathWritten
+	FilePath sessionPathNewer;	///< Session written by a newer version which must not be overwritten
+	bool recoveryFailed;	///< A recovery file could not be written and this was reported
 
 	FilePath pathAbbreviations;
 
@@ -540,7 +893,11 @@ protected:
 
 	PropSetFile propsStatus;
 
+	SizeTiers sizeTiers;
+
 	std::unique_ptr<IEditorConfig> editorConfig;
+	std::unique_ptr<FileWatcher> fileWatcher;
+	FilePathSet filesWatched;
 
 	enum { bufferMax = IDM_IMPORT - IDM_BUFFER };
 	BufferList buffers;
@@ -552,6 +909,7 @@ protected:
 	bool IsBufferAvailable() const;
 	bool CanMakeRoom(bool maySaveIfDirty = true);
 	void SetDocumentAt(int index, bool updateStack = true);
+	void HideCurrentDocument();
 	Buffer *CurrentBuffer() {
 		return buffers.CurrentBuffer();
 	}
@@ -595,6 +953,7 @@ protected:
 	bool FindMatchingPreprocessorCondition(int &curLine, int direction, int condEnd1, int condEnd2);
 	bool FindMatchingPreprocCondPosition(bool isForward, int &mppcAtCaret, int &mppcMatch);
 	bool FindMatchingBracePosition(bool editor, int &braceAtCaret, int &braceOpposite, bool sloppy);
+	bool ContinueBraceIndex();
 	void BraceMatch(bool editor);
 
 	virtual void WarnUser(int warnID) = 0;
@@ -607,10 +966,13 @@ protected:
 	void CreateBuffers();
 	void InitialiseBuffers();
 	FilePath UserFilePath(const GUI::gui_char *name);
-	void LoadSessionFile(const GUI::gui_char *sessionName);
+	bool LoadSessionFile(const GUI::gui_char *sessionName);
 	void RestoreRecentMenu();
 	void RestoreFromSession(const Session &session);
 	void RestoreSession();
+	std::vector<int> SessionLines(const std::string &key) const;
+	enum class SessionFormat { text, compact, newer };
+	SessionFormat ReadCompactSession(const std::string &data);
 	void SaveSessionFile(const GUI::gui_char *sessionName);
 	virtual void GetWindowPosition(int *left, int *top, int *width, int *height, int *maximize) = 0;
 	void SetIndentSettings();
@@ -662,6 +1024,9 @@ protected:
 	SaveResult SaveIfUnsureForBuilt();
 	bool SaveIfNotOpen(const FilePath &destFile, bool fixCase);
 	void AbandonAutomaticSave();
+	FilePath RecoveryPath(const FilePath &path);
+	void RemoveRecoveryFile(const FilePath &path);
+	void AutoSaveBuffer(int index);
 	bool Save(SaveFlags sf = sfProgressVisible);
 	void SaveAs(const GUI::gui_char *file, bool fixCase);
 	virtual void SaveACopy() = 0;
@@ -772,8 +1137,16 @@ protected:
 	virtual void FindReplace(bool replace) = 0;
 	void OutputAppendString(const char *s, int len = -1);
 	virtual void OutputAppendStringSynchronised(const char *s, int len = -1);
+	void OutputFlush();
+	void OutputTrim();
+	bool OutputTrimming() const noexcept;
+	sptr_t OutputOffsetFromPosition(sptr_t position) const noexcept;
+	sptr_t OutputPositionFromOffset(sptr_t offset) const noexcept;
 	virtual void Execute();
 	virtual void StopExecute() = 0;
+	void IndexDiagnostics();
+	int NextDiagnosticLine(int line, int dir);
+	void ShowDiagnostics();
 	void ShowMessages(int line);
 	void GoMessage(int dir);
 	virtual bool StartCallTip();
@@ -802,9 +1175,11 @@ protected:
 	void AutomaticIndentation(char ch);
 	void CharAdded(int utf32);
 	void CharAddedOutput(int ch);
-	void SetTextProperties(PropSetFile &ps);
+	StatusBarState CurrentStatusBarState();
+	void SetTextProperties(PropSetFile &ps, int dependencies);
 	virtual void SetFileProperties(PropSetFile &ps) = 0;
 	void UpdateStatusBar(bool bUpdateSlowData) override;
+	void RenderStatusBar();
 	int GetLineLength(int line);
 	int GetCurrentLineNumber();
 	int GetCurrentColumnNumber();
@@ -823,6 +1198,8 @@ protected:
 	void SetLineNumberWidth();
 	void MenuCommand(int cmdID, int source = 0);
 	void FoldChanged(int line, int levelNow, int levelPrev);
+	void EnsureFoldLevels(int lineEnd);
+	std::vector<int> FoldLevels(int lineStart, int lineEnd);
 	void ExpandFolds(int line, bool expand, int level);
 	void FoldAll();
 	void ToggleFoldRecursive(int line, int level);
@@ -833,6 +1210,8 @@ protected:
 	void NewLineInOutput();
 	virtual void SetStatusBarText(const char *s) = 0;
 	virtual void Notify(SCNotification *notification);
+	void RecordModification(const SCNotification *notification);
+	void DeliverModifications();
 	virtual void ShowToolBar() = 0;
 	virtual void ShowTabBar() = 0;
 	virtual void ShowStatusBar() = 0;
@@ -905,6 +1284,8 @@ protected:
 	void ReadAPI(const std::string &fileNameForExtension);
 	std::string FindLanguageProperty(const char *pattern, const char *defaultValue = "");
 	virtual void ReadProperties();
+	SizeTiers::Mode FeatureMode(SizeTiers::Feature feature);
+	void EnableFeature(const char *name);
 	std::string StyleString(const char *lang, int style) const;
 	StyleDefinition StyleDefinitionFor(int style);
 	void SetOneStyle(GUI::ScintillaWindow &win, int style, const StyleDefinition &sd);
@@ -913,7 +1294,10 @@ protected:
 	static void SetOneIndicator(GUI::ScintillaWindow &win, int indicator, const IndicatorDefinition &ind);
 	void ReloadProperties();
 
+	bool ReloadAppended();
 	void CheckReload();
+	void WatchFiles();
+	void FilesChanged(const FilePathSet &files);
 	void Activate(bool activeApp);
 	GUI::Rectangle GetClientRectangle();
 	void Redraw();
@@ -932,6 +1316,7 @@ protected:
 	void StartRecordMacro();
 	void StopRecordMacro();
 	void StartPlayMacro();
+	void PlayMacro(const Macro &macro, int times, bool eachLine);
 	bool RecordMacroCommand(const SCNotification *notification);
 	void ExecuteMacroCommand(const char *command);
 	void AskMacroList();
@@ -953,11 +1338,17 @@ protected:
 	void SendOneProperty(const char *kind, const char *key, const char *val);
 	void PropertyFromDirector(const char *arg);
 	void PropertyToDirector(const char *arg);
+	const char *DirectorRange(const char *arg, Pane &pane, int &start, int &length);
+	void RangeToDirector(const char *arg, bool shared);
+	void RangeFromDirector(const char *arg, const char *argEnd);
+	void ChangesToDirector(const char *arg);
+	void ReleaseSharedRange(const char *arg);
 	// ExtensionAPI
 	sptr_t Send(Pane p, unsigned int msg, uptr_t wParam = 0, sptr_t lParam = 0) override;
 	std::string Range(Pane p, int start, int end) override;
 	void Remove(Pane p, int start, int end) override;
 	void Insert(Pane p, int pos, const char *s) override;
+	int Revision(Pane p) override;
 	void Trace(const char *s) override;
 	std::string Property(const char *key) override;
 	void SetProperty(const char *key, const char *val) override;
@@ -992,7 +1383,7 @@ public:
 
 	GUI::WindowID GetID() const noexcept { return wSciTE.GetID(); }
 
-	virtual bool PerformOnNewThread(Worker *pWorker) = 0;
+	bool PerformOnNewThread(Worker *pWorker) override = 0;
 	// WorkerListener
 	void PostOnMainThread(int cmd, Worker *pWorker) override = 0;
 	virtual void WorkerCommand(int cmd, Worker *pWorker);
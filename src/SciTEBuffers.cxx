@@ -44,17 +44,47 @@
 
 const GUI::gui_char defaultSessionFileName[] = GUI_TEXT("SciTE.session");
 
-void Buffer::DocumentModified() {
+// Number of changes kept for directors asking what changed since a revision
+constexpr size_t changesKept = 10000;
+
+void Buffer::DocumentModified(int position, int length) {
 	documentModTime = time(nullptr);
+	braceIndex.Modified(position, length);
+	revision++;
+	changes.push_back({revision, position, length});
+	if (changes.size() >= changesKept * 2) {
+		const size_t removed = changes.size() - changesKept;
+		revisionChangesFrom = changes[removed - 1].revision;
+		changes.erase(changes.begin(), changes.begin() + removed);
+	}
 }
 
 bool Buffer::NeedsSave(int delayBeforeSave) const {
 	const time_t now = time(nullptr);
-	return now && documentModTime && isDirty && !pFileWorker && (now-documentModTime > delayBeforeSave) && !file.IsUntitled() && !failedSave;
+	return now && documentModTime && isDirty && !pFileWorker && (now-documentModTime > delayBeforeSave) &&
+		(revision != revisionAutoSaved) && !file.IsUntitled() && !failedSave;
+}
+
+// A document that is not attached to the editor can not be modified, so a pointer
+// to its text retrieved as it is hidden remains valid until it is shown again.
+void Buffer::DocumentHidden(const char *documentBytes_, size_t documentLength_) noexcept {
+	documentBytes = documentBytes_;
+	documentLength = documentLength_;
+}
+
+void Buffer::DocumentShown() noexcept {
+	documentBytes = nullptr;
+	documentLength = 0;
 }
 
 void Buffer::CompleteLoading() {
 	lifeState = open;
+	// Text loaded in the background did not send modification notifications
+	braceIndex.Clear();
+	// so changes recorded before, like clearing the document, do not lead to the loaded text
+	revision++;
+	changes.clear();
+	revisionChangesFrom = revision;
 	if (pFileWorker && pFileWorker->IsLoading()) {
 		delete pFileWorker;
 		pFileWorker = nullptr;
@@ -62,11 +92,19 @@ void Buffer::CompleteLoading() {
 }
 
 void Buffer::CompleteStoring() {
+	bool storedFile = true;
 	if (pFileWorker && !pFileWorker->IsLoading()) {
+		// Copies and recovery files do not change the state of the buffer's file
+		storedFile = pFileWorker->path.SameNameAs(file);
+		if (!pFileWorker->err && !pFileWorker->Cancelling())
+			revisionAutoSaved = revisionStoring;
+		else
+			documentModTime = time(nullptr);	// Automatic save tries again after another delay
 		delete pFileWorker;
 		pFileWorker = nullptr;
 	}
-	SetTimeFromFile();
+	if (storedFile)
+		SetTimeFromFile();
 }
 
 void Buffer::AbandonAutomaticSave() {
@@ -369,6 +407,7 @@ void SciTEBase::SwitchDocumentAt(int index, sptr_t pdoc) {
 	}
 	const sptr_t pdocOld = buffers.buffers[index].doc;
 	buffers.buffers[index].doc = pdoc;
+	buffers.buffers[index].DocumentShown();
 	if (pdocOld) {
 		wEditor.Call(SCI_RELEASEDOCUMENT, 0, pdocOld);
 	}
@@ -388,6 +427,7 @@ void SciTEBase::SetDocumentAt(int index, bool updateStack) {
 		return;
 	}
 	UpdateBuffersCurrent();
+	HideCurrentDocument();
 
 	buffers.SetCurrent(index);
 	if (updateStack) {
@@ -406,6 +446,12 @@ void SciTEBase::SetDocumentAt(int index, bool updateStack) {
 	propsDiscovered = bufferNext.props;
 	propsDiscovered.superPS = &propsLocal;
 	wEditor.Call(SCI_SETDOCPOINTER, 0, GetDocumentAt(buffers.Current()));
+	CurrentBuffer()->DocumentShown();
+	if (bufferNext.pFileWorker && !bufferNext.pFileWorker->IsLoading() &&
+		!static_cast<const FileStorer *>(bufferNext.pFileWorker)->CopiedDocument()) {
+		// Automatic save is still writing the text so prevent modification until done
+		wEditor.Call(SCI_SETREADONLY, 1);
+	}
 	const bool restoreBookmarks = bufferNext.lifeState == Buffer::readAll;
 	PerformDeferredTasks();
 	if (bufferNext.lifeState == Buffer::readAll) {
@@ -414,6 +460,8 @@ void SciTEBase::SetDocumentAt(int index, bool updateStack) {
 			extender->OnOpen(filePath.AsUTF8().c_str());
 	}
 	RestoreState(bufferNext, restoreBookmarks);
+	if (props.GetInt("error.inline"))
+		ShowDiagnostics();
 
 	TabSelect(index);
 
@@ -436,6 +484,17 @@ void SciTEBase::SetDocumentAt(int index, bool updateStack) {
 	}
 }
 
+void SciTEBase::HideCurrentDocument() {
+	DeliverModifications();
+	Buffer *pBuffer = CurrentBuffer();
+	if (delayBeforeAutoSave && pBuffer->isDirty && !pBuffer->pFileWorker) {
+		// Retain the text so it can be saved automatically without switching back to it
+		const size_t lengthDoc = LengthDocument();
+		pBuffer->DocumentHidden(reinterpret_cast<const char *>(
+			wEditor.CallReturnPointer(SCI_GETCHARACTERPOINTER)), lengthDoc);
+	}
+}
+
 void SciTEBase::UpdateBuffersCurrent() {
 	const int currentbuf = buffers.Current();
 
@@ -547,7 +606,12 @@ static std::string IndexPropKey(const char *bufPrefix, int bufIndex, const char
 	return pKey;
 }
 
-void SciTEBase::LoadSessionFile(const GUI::gui_char *sessionName) {
+/**
+ * Read a session file into propsSession.
+ * Return false when the file was written by a newer version that can not be read.
+ * That file is then not overwritten when sessions are saved.
+ */
+bool SciTEBase::LoadSessionFile(const GUI::gui_char *sessionName) {
 	FilePath sessionPathName;
 	if (sessionName[0] == '\0') {
 		sessionPathName = UserFilePath(defaultSessionFileName);
@@ -556,11 +620,21 @@ void SciTEBase::LoadSessionFile(const GUI::gui_char *sessionName) {
 	}
 
 	propsSession.Clear();
-	propsSession.Read(sessionPathName, sessionPathName.Directory(), filter, nullptr, 0);
+	sessionLines.clear();
+	const SessionFormat format = ReadCompactSession(sessionPathName.Read());
+	if (format == SessionFormat::newer) {
+		sessionPathNewer = sessionPathName;
+		return false;
+	}
+	if (format == SessionFormat::text) {
+		// Text session files are properties files
+		propsSession.Read(sessionPathName, sessionPathName.Directory(), filter, nullptr, 0);
+	}
 
 	FilePath sessionFilePath = FilePath(sessionPathName).AbsolutePath();
 	// Add/update SessionPath environment variable
 	props.Set("SessionPath", sessionFilePath.AsUTF8().c_str());
+	return true;
 }
 
 void SciTEBase::RestoreRecentMenu() {
@@ -609,6 +683,168 @@ std::string StringFromLines(const std::vector<int> &lines) {
 	return result;
 }
 
+// Compact session files start with a signature and a format version followed by records.
+// Each record is a kind, a payload length and the payload. Numbers are stored as
+// varints, 7 bits to a byte with the high bit set on all but the last byte.
+// Line lists are a count followed by the zigzag encoded difference from the previous line.
+
+const char sessionSignature[] = "\x89SciTE session\r\n";
+constexpr unsigned int sessionVersion = 2;
+
+enum SessionRecordKind { srProperty = 1, srBuffer = 2 };
+enum SessionBufferFlags { sbCurrent = 1, sbBookmarks = 2, sbFolds = 4 };
+
+void AppendVarint(std::string &s, unsigned int value) {
+	while (value >= 0x80) {
+		s.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	s.push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(const std::string &s, size_t &pos, unsigned int &value) noexcept {
+	value = 0;
+	for (int shift = 0; (shift < 32) && (pos < s.length()); shift += 7) {
+		const unsigned char byte = s[pos++];
+		value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+constexpr unsigned int ZigZag(int value) noexcept {
+	return (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+}
+
+constexpr int UnZigZag(unsigned int value) noexcept {
+	return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+}
+
+void AppendString(std::string &s, const std::string &value) {
+	AppendVarint(s, static_cast<unsigned int>(value.length()));
+	s.append(value);
+}
+
+bool ReadString(const std::string &s, size_t &pos, std::string &value) {
+	unsigned int length = 0;
+	if (!ReadVarint(s, pos, length) || (length > s.length() - pos))
+		return false;
+	value = s.substr(pos, length);
+	pos += length;
+	return true;
+}
+
+void AppendLines(std::string &s, const std::vector<int> &lines) {
+	AppendVarint(s, static_cast<unsigned int>(lines.size()));
+	int linePrevious = -1;
+	for (const int line : lines) {
+		AppendVarint(s, ZigZag(line - linePrevious));
+		linePrevious = line;
+	}
+}
+
+bool ReadLines(const std::string &s, size_t &pos, std::vector<int> &lines) {
+	unsigned int count = 0;
+	if (!ReadVarint(s, pos, count) || (count > s.length() - pos))
+		return false;
+	lines.clear();
+	lines.reserve(count);
+	int line = -1;
+	for (unsigned int i = 0; i < count; i++) {
+		unsigned int delta = 0;
+		if (!ReadVarint(s, pos, delta))
+			return false;
+		line += UnZigZag(delta);
+		lines.push_back(line);
+	}
+	return true;
+}
+
+void AppendRecord(std::string &s, SessionRecordKind kind, const std::string &payload) {
+	AppendVarint(s, kind);
+	AppendString(s, payload);
+}
+
+std::string EncodeBufferRecord(const std::string &path, const SessionRecord &record) {
+	std::string payload;
+	AppendString(payload, path);
+	AppendVarint(payload, (record.current ? sbCurrent : 0) |
+		(record.withBookmarks ? sbBookmarks : 0) | (record.withFolds ? sbFolds : 0));
+	AppendVarint(payload, ZigZag(record.position));
+	AppendVarint(payload, ZigZag(record.scrollPosition));
+	if (record.withBookmarks)
+		AppendLines(payload, record.bookmarks);
+	if (record.withFolds)
+		AppendLines(payload, record.foldState);
+	return payload;
+}
+
+}
+
+/**
+ * Read a compact session into propsSession, sessionLines and sessionRecords.
+ * @return @c false if @a data is not a compact session so should be read as text.
+ */
+SciTEBase::SessionFormat SciTEBase::ReadCompactSession(const std::string &data) {
+	const size_t lengthSignature = sizeof(sessionSignature) - 1;
+	if (data.compare(0, lengthSignature, sessionSignature) != 0)
+		return SessionFormat::text;
+	size_t pos = lengthSignature;
+	unsigned int version = 0;
+	if (!ReadVarint(data, pos, version) || (version > sessionVersion))
+		return SessionFormat::newer;	// Not readable but not text either
+	int bufferIndex = 0;
+	unsigned int kind = 0;
+	std::string payload;
+	while ((pos < data.length()) && ReadVarint(data, pos, kind) && ReadString(data, pos, payload)) {
+		size_t posPayload = 0;
+		if (kind == srProperty) {
+			std::string key;
+			if (ReadString(payload, posPayload, key))
+				propsSession.Set(key, payload.substr(posPayload));
+		} else if (kind == srBuffer) {
+			std::string path;
+			unsigned int flags = 0;
+			unsigned int position = 0;
+			unsigned int scroll = 0;
+			SessionRecord record;
+			if (ReadString(payload, posPayload, path) && ReadVarint(payload, posPayload, flags) &&
+				ReadVarint(payload, posPayload, position) && ReadVarint(payload, posPayload, scroll) &&
+				(!(flags & sbBookmarks) || ReadLines(payload, posPayload, record.bookmarks)) &&
+				(!(flags & sbFolds) || ReadLines(payload, posPayload, record.foldState))) {
+				record.position = UnZigZag(position);
+				record.scrollPosition = UnZigZag(scroll);
+				record.current = (flags & sbCurrent) != 0;
+				record.withBookmarks = (flags & sbBookmarks) != 0;
+				record.withFolds = (flags & sbFolds) != 0;
+				propsSession.Set(IndexPropKey("buffer", bufferIndex, "path"), path);
+				propsSession.Set(IndexPropKey("buffer", bufferIndex, "position"), std::to_string(record.position + 1));
+				propsSession.Set(IndexPropKey("buffer", bufferIndex, "scroll"), std::to_string(record.scrollPosition));
+				if (record.current)
+					propsSession.Set(IndexPropKey("buffer", bufferIndex, "current"), "1");
+				if (flags & sbBookmarks)
+					sessionLines[IndexPropKey("buffer", bufferIndex, "bookmarks")] = record.bookmarks;
+				if (flags & sbFolds)
+					sessionLines[IndexPropKey("buffer", bufferIndex, "folds")] = record.foldState;
+				// Saving again can reuse the record if the buffer is unchanged
+				record.encoded = payload;
+				sessionRecords[path] = record;
+				bufferIndex++;
+			}
+		}
+	}
+	return SessionFormat::compact;
+}
+
+/**
+ * @return The lines stored for @a key in either a compact or a text session.
+ */
+std::vector<int> SciTEBase::SessionLines(const std::string &key) const {
+	std::map<std::string, std::vector<int>>::const_iterator it = sessionLines.find(key);
+	if (it != sessionLines.end())
+		return it->second;
+	return LinesFromString(propsSession.GetString(key.c_str()));
 }
 
 void SciTEBase::RestoreFromSession(const Session &session) {
@@ -668,15 +904,13 @@ void SciTEBase::RestoreSession() {
 
 		if (props.GetInt("session.bookmarks")) {
 			propKey = IndexPropKey("buffer", i, "bookmarks");
-			propStr = propsSession.GetString(propKey.c_str());
-			bufferState.bookmarks = LinesFromString(propStr);
+			bufferState.bookmarks = SessionLines(propKey);
 		}
 
 		if (props.GetInt("fold") && !props.GetInt("fold.on.open") &&
 			props.GetInt("session.folds")) {
 			propKey = IndexPropKey("buffer", i, "folds");
-			propStr = propsSession.GetString(propKey.c_str());
-			bufferState.foldState = LinesFromString(propStr);
+			bufferState.foldState = SessionLines(propKey);
 		}
 
 		session.buffers.push_back(bufferState);
@@ -694,108 +928,160 @@ void SciTEBase::SaveSessionFile(const GUI::gui_char *sessionName) {
 	} else {
 		sessionPathName.Set(sessionName);
 	}
-	FILE *sessionFile = sessionPathName.Open(fileWrite);
-	if (!sessionFile)
+	if (sessionPathNewer.IsSet() && sessionPathName.SameNameAs(sessionPathNewer))
 		return;
+	const bool compact = props.GetInt("session.format", 1) >= 2;
 
-	fprintf(sessionFile, "# SciTE session file\n");
+	// Settings are in groups which are separated by blank lines in text session files
+	typedef std::vector<std::pair<std::string, std::string>> SessionGroup;
+	std::vector<SessionGroup> groups;
 
 	if (defaultSession && props.GetInt("save.position")) {
 		int top, left, width, height, maximize;
 		GetWindowPosition(&left, &top, &width, &height, &maximize);
 
-		fprintf(sessionFile, "\n");
-		fprintf(sessionFile, "position.left=%d\n", left);
-		fprintf(sessionFile, "position.top=%d\n", top);
-		fprintf(sessionFile, "position.width=%d\n", width);
-		fprintf(sessionFile, "position.height=%d\n", height);
-		fprintf(sessionFile, "position.maximize=%d\n", maximize);
+		groups.push_back({
+			{"position.left", std::to_string(left)},
+			{"position.top", std::to_string(top)},
+			{"position.width", std::to_string(width)},
+			{"position.height", std::to_string(height)},
+			{"position.maximize", std::to_string(maximize)},
+		});
 	}
 
 	if (defaultSession && props.GetInt("save.recent")) {
-		std::string propKey;
+		SessionGroup group;
 		int j = 0;
 
-		fprintf(sessionFile, "\n");
-
 		// Save recent files list
 		for (int i = fileStackMax - 1; i >= 0; i--) {
 			if (recentFileStack[i].IsSet()) {
-				propKey = IndexPropKey("mru", j++, "path");
-				fprintf(sessionFile, "%s=%s\n", propKey.c_str(), recentFileStack[i].AsUTF8().c_str());
+				group.emplace_back(IndexPropKey("mru", j++, "path"), recentFileStack[i].AsUTF8());
 			}
 		}
+		groups.push_back(group);
 	}
 
 	if (defaultSession && props.GetInt("save.find")) {
-		std::string propKey;
-		std::vector<std::string>::iterator it;
 		std::vector<std::string> mem = memFinds.AsVector();
 		if (!mem.empty()) {
-			fprintf(sessionFile, "\n");
-			it = mem.begin();
-			for (int i = 0; it != mem.end(); i++, ++it) {
-				propKey = IndexPropKey("search", i, "findwhat");
-				fprintf(sessionFile, "%s=%s\n", propKey.c_str(), (*it).c_str());
+			SessionGroup group;
+			for (size_t i = 0; i < mem.size(); i++) {
+				group.emplace_back(IndexPropKey("search", static_cast<int>(i), "findwhat"), mem[i]);
 			}
+			groups.push_back(group);
 		}
 
 		mem = memReplaces.AsVector();
 		if (!mem.empty()) {
-			fprintf(sessionFile, "\n");
-			mem = memReplaces.AsVector();
-			it = mem.begin();
-			for (int i = 0; it != mem.end(); i++, ++it) {
-				propKey = IndexPropKey("search", i, "replacewith");
-				fprintf(sessionFile, "%s=%s\n", propKey.c_str(), (*it).c_str());
+			SessionGroup group;
+			for (size_t i = 0; i < mem.size(); i++) {
+				group.emplace_back(IndexPropKey("search", static_cast<int>(i), "replacewith"), mem[i]);
+			}
+			groups.push_back(group);
+		}
+	}
+
+	std::string contents;
+	if (compact) {
+		contents = sessionSignature;
+		AppendVarint(contents, sessionVersion);
+		for (const SessionGroup &group : groups) {
+			for (const std::pair<std::string, std::string> &setting : group) {
+				std::string payload;
+				AppendString(payload, setting.first);
+				payload.append(setting.second);
+				AppendRecord(contents, srProperty, payload);
+			}
+		}
+	} else {
+		contents = "# SciTE session file\n";
+		for (const SessionGroup &group : groups) {
+			contents += "\n";
+			for (const std::pair<std::string, std::string> &setting : group) {
+				contents += setting.first + "=" + setting.second + "\n";
 			}
 		}
 	}
 
 	if (props.GetInt("buffers") && (!defaultSession || props.GetInt("save.session"))) {
+		const bool withBookmarks = props.GetInt("session.bookmarks") != 0;
+		const bool withFolds = props.GetInt("fold") && props.GetInt("session.folds");
+		const std::vector<int> noLines;
+		std::map<std::string, SessionRecord> recordsSaved;
 		const int curr = buffers.Current();
 		for (int i = 0; i < buffers.lengthVisible; i++) {
 			const Buffer &buff = buffers.buffers[i];
 			if (buff.file.IsSet() && !buff.file.IsUntitled()) {
-				std::string propKey = IndexPropKey("buffer", i, "path");
-				fprintf(sessionFile, "\n%s=%s\n", propKey.c_str(), buff.file.AsUTF8().c_str());
-
-				const int pos = buff.file.selection.position + 1;
-				const std::string sPos = std::to_string(pos);
-				propKey = IndexPropKey("buffer", i, "position");
-				fprintf(sessionFile, "%s=%s\n", propKey.c_str(), sPos.c_str());
+				const std::string path = buff.file.AsUTF8();
+				const std::vector<int> &bookmarks = withBookmarks ? buff.bookmarks : noLines;
+				const std::vector<int> &foldState = withFolds ? buff.foldState : noLines;
+				if (compact) {
+					// Only buffers that changed since the session was last read or written are encoded
+					SessionRecord &record = sessionRecords[path];
+					if (record.encoded.empty() ||
+						(record.position != buff.file.selection.position) ||
+						(record.scrollPosition != buff.file.scrollPosition) ||
+						(record.current != (i == curr)) ||
+						(record.withBookmarks != withBookmarks) || (record.withFolds != withFolds) ||
+						(record.bookmarks != bookmarks) || (record.foldState != foldState)) {
+						record.position = buff.file.selection.position;
+						record.scrollPosition = buff.file.scrollPosition;
+						record.current = i == curr;
+						record.withBookmarks = withBookmarks;
+						record.withFolds = withFolds;
+						record.bookmarks = bookmarks;
+						record.foldState = foldState;
+						record.encoded = EncodeBufferRecord(path, record);
+					}
+					AppendRecord(contents, srBuffer, record.encoded);
+					recordsSaved[path] = std::move(record);
+					continue;
+				}
 
-				const int scroll = buff.file.scrollPosition;
-				const std::string sScroll = std::to_string(scroll);
-				propKey = IndexPropKey("buffer", i, "scroll");
-				fprintf(sessionFile, "%s=%s\n", propKey.c_str(), sScroll.c_str());
+				contents += "\n" + IndexPropKey("buffer", i, "path") + "=" + path + "\n";
+				contents += IndexPropKey("buffer", i, "position") + "=" +
+					std::to_string(buff.file.selection.position + 1) + "\n";
+				contents += IndexPropKey("buffer", i, "scroll") + "=" +
+					std::to_string(buff.file.scrollPosition) + "\n";
 
 				if (i == curr) {
-					propKey = IndexPropKey("buffer", i, "current");
-					fprintf(sessionFile, "%s=1\n", propKey.c_str());
+					contents += IndexPropKey("buffer", i, "current") + "=1\n";
 				}
 
-				if (props.GetInt("session.bookmarks")) {
-					const std::string bmString = StringFromLines(buff.bookmarks);
-					if (bmString.length()) {
-						propKey = IndexPropKey("buffer", i, "bookmarks");
-						fprintf(sessionFile, "%s=%s\n", propKey.c_str(), bmString.c_str());
-					}
+				const std::string bmString = StringFromLines(bookmarks);
+				if (bmString.length()) {
+					contents += IndexPropKey("buffer", i, "bookmarks") + "=" + bmString + "\n";
 				}
 
-				if (props.GetInt("fold") && props.GetInt("session.folds")) {
-					const std::string foldsString = StringFromLines(buff.foldState);
-					if (foldsString.length()) {
-						propKey = IndexPropKey("buffer", i, "folds");
-						fprintf(sessionFile, "%s=%s\n", propKey.c_str(), foldsString.c_str());
-					}
+				const std::string foldsString = StringFromLines(foldState);
+				if (foldsString.length()) {
+					contents += IndexPropKey("buffer", i, "folds") + "=" + foldsString + "\n";
 				}
 			}
 		}
+		if (compact) {
+			// Forget buffers that are no longer open
+			sessionRecords = std::move(recordsSaved);
+		}
 	}
 
-	if (fclose(sessionFile) != 0) {
-		FailedSaveMessageBox(sessionPathName);
+	if ((contents != sessionWritten) || !(sessionPathName == sessionPathWritten) || !sessionPathName.Exists()) {
+		// Write to a temporary file that then replaces the session file so that
+		// a failure part way through does not lose the previous session.
+		const FilePath sessionPathTemporary(GUI::gui_string(sessionPathName.AsInternal()) + GUI_TEXT(".new"));
+		FILE *sessionFile = sessionPathTemporary.Open(fileWrite);
+		if (!sessionFile)
+			return;
+		bool written = fwrite(contents.data(), 1, contents.length(), sessionFile) == contents.length();
+		written = (fclose(sessionFile) == 0) && written;
+		if (written && sessionPathTemporary.Rename(sessionPathName)) {
+			sessionPathWritten = sessionPathName;
+			sessionWritten = contents;
+		} else {
+			sessionPathTemporary.Remove();
+			FailedSaveMessageBox(sessionPathName);
+		}
 	}
 
 	FilePath sessionFilePath = FilePath(sessionPathName).AbsolutePath();
@@ -863,6 +1149,7 @@ void SciTEBase::New() {
 		if (buffers.size() == buffers.length) {
 			Close(false, false, true);
 		}
+		HideCurrentDocument();
 		buffers.SetCurrent(buffers.Add());
 	}
 
@@ -898,7 +1185,7 @@ void SciTEBase::RestoreState(const Buffer &buffer, bool restoreBookmarks) {
 	}
 
 	// check to see whether there is saved fold state, restore
-	if (!buffer.foldState.empty()) {
+	if (!buffer.foldState.empty() && (FeatureMode(SizeTiers::tfFold) == SizeTiers::tmFull)) {
 		wEditor.Call(SCI_COLOURISE, 0, -1);
 		for (const int fold : buffer.foldState) {
 			wEditor.Call(SCI_TOGGLEFOLD, fold);
@@ -919,8 +1206,10 @@ void SciTEBase::Close(bool updateUI, bool loadingSession, bool makingRoomForNew)
 	}
 
 	if (extender) {
+		DeliverModifications();
 		extender->OnClose(filePath.AsUTF8().c_str());
 	}
+	RemoveRecoveryFile(filePath);
 
 	if (buffers.size() == 1) {
 		// With no buffer list, Close means close from MRU
@@ -965,6 +1254,7 @@ void SciTEBase::Close(bool updateUI, bool loadingSession, bool makingRoomForNew)
 		propsDiscovered = bufferNext.props;
 		propsDiscovered.superPS = &propsLocal;
 		wEditor.Call(SCI_SETDOCPOINTER, 0, GetDocumentAt(buffers.Current()));
+		CurrentBuffer()->DocumentShown();
 		PerformDeferredTasks();
 		if (bufferNext.lifeState == Buffer::readAll) {
 			//restoreBookmarks = true;
@@ -1870,212 +2160,388 @@ static void Chomp(std::string &s, char ch) {
 		s.erase(0, posCh + 1);
 }
 
-void SciTEBase::ShowMessages(int line) {
-	wEditor.Call(SCI_ANNOTATIONSETSTYLEOFFSET, diagnosticStyleStart);
-	wEditor.Call(SCI_ANNOTATIONSETVISIBLE, ANNOTATION_BOXED);
-	wEditor.Call(SCI_ANNOTATIONCLEARALL);
+static bool IsMessageStyle(int style) noexcept {
+	return style != SCE_ERR_DEFAULT &&
+		style != SCE_ERR_CMD &&
+		style != SCE_ERR_DIFF_ADDITION &&
+		style != SCE_ERR_DIFF_CHANGED &&
+		style != SCE_ERR_DIFF_DELETION;
+}
+
+// Forget all messages. Annotated lines are remembered so they can be cleared when their file is shown.
+void DiagnosticsIndex::Clear() {
+	messages.clear();
+	for (DiagnosticFile &file : files) {
+		if (file.linesAnnotated.empty())
+			continue;
+		auto itStale = std::find_if(filesStale.begin(), filesStale.end(),
+			[&file](const DiagnosticFile &stale) { return stale.name.SameNameAs(file.name); });
+		if (itStale == filesStale.end()) {
+			filesStale.emplace_back(file.name);
+			itStale = filesStale.end() - 1;
+		}
+		itStale->linesAnnotated.insert(itStale->linesAnnotated.end(),
+			file.linesAnnotated.begin(), file.linesAnnotated.end());
+	}
+	files.clear();
+	offsetIndexed = 0;
+	blocksIndexed = 0;
+	blocks = 0;
+	blockShown = -1;
+	current = 0;
+}
+
+// Forget messages trimmed from the start of the output pane.
+void DiagnosticsIndex::Trim(sptr_t offsetStart) {
+	const auto itKeep = std::lower_bound(messages.begin(), messages.end(), offsetStart,
+		[](const DiagnosticMessage &dm, sptr_t offset) noexcept { return dm.offset < offset; });
+	const size_t removed = itKeep - messages.begin();
+	messages.erase(messages.begin(), itKeep);
+	current = (current > removed) ? current - removed : 0;
+	for (DiagnosticFile &file : files) {
+		std::vector<size_t> kept;
+		for (const size_t message : file.messages) {
+			if (message >= removed)
+				kept.push_back(message - removed);
+		}
+		file.messages.swap(kept);
+	}
+}
+
+// Forget messages from the incomplete last line as more text may have been appended to it.
+void DiagnosticsIndex::RemoveIncomplete() {
+	while (!messages.empty() && (messages.back().offset >= offsetIndexed)) {
+		messages.pop_back();
+	}
+	for (DiagnosticFile &file : files) {
+		while (!file.messages.empty() && (file.messages.back() >= messages.size())) {
+			file.messages.pop_back();
+		}
+	}
+	blocks = blocksIndexed;
+}
+
+DiagnosticFile *DiagnosticsIndex::Find(const FilePath &name) {
+	for (DiagnosticFile &file : files) {
+		if (file.name.SameNameAs(name))
+			return &file;
+	}
+	return nullptr;
+}
+
+DiagnosticFile *DiagnosticsIndex::Add(const FilePath &name) {
+	DiagnosticFile *file = Find(name);
+	if (!file) {
+		files.emplace_back(name);
+		file = &files.back();
+	}
+	return file;
+}
+
+/**
+ * Decode the lines added to the output pane since the last call, adding
+ * message lines to the index and to the list for the file they refer to.
+ * A last line without a line end is indexed but examined again next time.
+ */
+void SciTEBase::IndexDiagnostics() {
+	diagnostics.RemoveIncomplete();
+	const sptr_t offsetTrimmed = OutputOffsetFromPosition(0);
+	if (!diagnostics.messages.empty() && (diagnostics.messages.front().offset < offsetTrimmed))
+		diagnostics.Trim(offsetTrimmed);
+	const int startIndex = static_cast<int>(OutputPositionFromOffset(diagnostics.offsetIndexed));
+	const int lineLast = wOutput.Call(SCI_GETLINECOUNT) - 1;
+	const int endIndex = wOutput.Call(SCI_POSITIONFROMLINE, lineLast);
+	const int endText = wOutput.Call(SCI_GETLENGTH);
+	if (endText <= startIndex)
+		return;
+	wOutput.Call(SCI_COLOURISE, startIndex, endText);
 	TextReader acc(wOutput);
-	while ((line > 0) && (acc.StyleAt(acc.LineStart(line-1)) != SCE_ERR_CMD))
-		line--;
-	const int maxLine = wOutput.Call(SCI_GETLINECOUNT);
-	while ((line < maxLine) && (acc.StyleAt(acc.LineStart(line)) != SCE_ERR_CMD)) {
+	for (int line = wOutput.Call(SCI_LINEFROMPOSITION, startIndex); line <= lineLast; line++) {
 		const int startPosLine = wOutput.Call(SCI_POSITIONFROMLINE, line, 0);
+		if (line == lineLast) {
+			if (startPosLine == endText)
+				break;
+			diagnostics.blocksIndexed = diagnostics.blocks;
+		}
+		int style = acc.StyleAt(startPosLine);
+		if (style == SCE_ERR_CMD) {
+			diagnostics.blocks++;
+			continue;
+		}
+		if (!IsMessageStyle(style))
+			continue;
 		const int lineEnd = wOutput.Call(SCI_GETLINEENDPOSITION, line, 0);
 		std::string message = GetRangeString(wOutput, startPosLine, lineEnd);
-		std::string source;
-		int column;
-		int style = acc.StyleAt(startPosLine);
 		if ((style == SCE_ERR_ESCSEQ) || (style == SCE_ERR_ESCSEQ_UNKNOWN) || (style >= SCE_ERR_ES_BLACK)) {
 			// GCC message with ANSI escape sequences
 			RemoveEscSeq(message);
 			style = SCE_ERR_GCC;
 		}
-		const int sourceLine = DecodeMessage(message.c_str(), source, style, column);
+		DiagnosticMessage dm;
+		dm.offset = OutputOffsetFromPosition(startPosLine);
+		dm.block = diagnostics.blocks;
+		dm.style = style;
+		std::string source;
+		dm.sourceLine = DecodeMessage(message.c_str(), source, style, dm.column);
 		Chomp(message, ':');
 		if (style == SCE_ERR_GCC) {
 			Chomp(message, ':');
 		}
-		GUI::gui_string sourceString = GUI::StringFromUTF8(source);
-		FilePath sourcePath = FilePath(sourceString).NormalizePath();
-		if (filePath.Name().SameNameAs(sourcePath.Name())) {
-			if (style == SCE_ERR_GCC) {
-				const char *sColon = strchr(message.c_str(), ':');
-				if (sColon) {
-					std::string editLine = GetLine(wEditor, sourceLine);
-					if (editLine == (sColon+1)) {
-						line++;
-						continue;
-					}
+		dm.severity = 0;
+		if (message.find("warning") != std::string::npos)
+			dm.severity = 1;
+		if (message.find("error") != std::string::npos)
+			dm.severity = 2;
+		if (message.find("fatal") != std::string::npos)
+			dm.severity = 3;
+		dm.message = message;
+		diagnostics.messages.push_back(dm);
+		if (dm.sourceLine >= 0) {
+			const FilePath sourcePath = FilePath(GUI::StringFromUTF8(source)).NormalizePath();
+			diagnostics.Add(sourcePath.Name())->messages.push_back(diagnostics.messages.size() - 1);
+		}
+	}
+	diagnostics.offsetIndexed = OutputOffsetFromPosition(endIndex);
+	if (endIndex == endText)
+		diagnostics.blocksIndexed = diagnostics.blocks;
+}
+
+/**
+ * Find the output line of the next message in direction dir from line, wrapping
+ * around the ends. Returns -1 if there is no other message.
+ */
+int SciTEBase::NextDiagnosticLine(int line, int dir) {
+	IndexDiagnostics();
+	const std::vector<DiagnosticMessage> &messages = diagnostics.messages;
+	if (messages.empty())
+		return -1;
+	const sptr_t offsetLine = OutputOffsetFromPosition(wOutput.Call(SCI_POSITIONFROMLINE, line, 0));
+	const size_t count = messages.size();
+	size_t next;
+	if ((diagnostics.current < count) && (messages[diagnostics.current].offset == offsetLine)) {
+		// Usually stepping from the last message visited
+		next = (dir > 0) ? (diagnostics.current + 1) % count : (diagnostics.current + count - 1) % count;
+	} else if (dir > 0) {
+		next = std::upper_bound(messages.begin(), messages.end(), offsetLine,
+			[](sptr_t offset, const DiagnosticMessage &dm) noexcept { return offset < dm.offset; }) - messages.begin();
+		if (next == count)
+			next = 0;
+	} else {
+		const size_t before = std::lower_bound(messages.begin(), messages.end(), offsetLine,
+			[](const DiagnosticMessage &dm, sptr_t offset) noexcept { return dm.offset < offset; }) - messages.begin();
+		next = (before == 0) ? count - 1 : before - 1;
+	}
+	if (messages[next].offset == offsetLine)
+		return -1;
+	diagnostics.current = next;
+	return wOutput.Call(SCI_LINEFROMPOSITION, OutputPositionFromOffset(messages[next].offset));
+}
+
+/**
+ * Show the messages about the current file from the chosen command as annotations.
+ * Only lines whose annotations differ from those wanted are changed.
+ */
+void SciTEBase::ShowDiagnostics() {
+	// Clear annotations left from messages that are no longer in the index
+	const auto itStale = std::find_if(diagnostics.filesStale.begin(), diagnostics.filesStale.end(),
+		[this](const DiagnosticFile &stale) { return stale.name.SameNameAs(filePath.Name()); });
+	if (itStale != diagnostics.filesStale.end()) {
+		for (const int line : itStale->linesAnnotated) {
+			wEditor.CallString(SCI_ANNOTATIONSETTEXT, line, nullptr);
+		}
+		diagnostics.filesStale.erase(itStale);
+	}
+	if (diagnostics.blockShown < 0)
+		return;
+	DiagnosticFile *file = diagnostics.Find(filePath.Name());
+	if (!file)
+		return;
+	wEditor.Call(SCI_ANNOTATIONSETSTYLEOFFSET, diagnosticStyleStart);
+	wEditor.Call(SCI_ANNOTATIONSETVISIBLE, ANNOTATION_BOXED);
+	std::map<int, std::pair<std::string, std::string>> annotations;
+	for (const size_t index : file->messages) {
+		const DiagnosticMessage &dm = diagnostics.messages[index];
+		if (dm.block != diagnostics.blockShown)
+			continue;
+		if (dm.style == SCE_ERR_GCC) {
+			const char *sColon = strchr(dm.message.c_str(), ':');
+			if (sColon) {
+				std::string editLine = GetLine(wEditor, dm.sourceLine);
+				if (editLine == (sColon+1)) {
+					continue;
 				}
 			}
-			const int lenCurrent = wEditor.CallString(SCI_ANNOTATIONGETTEXT, sourceLine, nullptr);
-			std::string msgCurrent(lenCurrent, '\0');
-			std::string stylesCurrent(lenCurrent, '\0');
-			if (lenCurrent) {
-				wEditor.CallString(SCI_ANNOTATIONGETTEXT, sourceLine, &msgCurrent[0]);
-				wEditor.CallString(SCI_ANNOTATIONGETSTYLES, sourceLine, &stylesCurrent[0]);
-				msgCurrent += "\n";
-				stylesCurrent += '\0';
-			}
-			if (msgCurrent.find(message.c_str()) == std::string::npos) {
-				// Only append unique messages
-				msgCurrent += message.c_str();
-				char msgStyle = 0;
-				if (message.find("warning") != std::string::npos)
-					msgStyle = 1;
-				if (message.find("error") != std::string::npos)
-					msgStyle = 2;
-				if (message.find("fatal") != std::string::npos)
-					msgStyle = 3;
-				stylesCurrent += std::string(message.length(), msgStyle);
-				wEditor.CallString(SCI_ANNOTATIONSETTEXT, sourceLine, msgCurrent.c_str());
-				wEditor.CallString(SCI_ANNOTATIONSETSTYLES, sourceLine, stylesCurrent.c_str());
+		}
+		std::pair<std::string, std::string> &annotation = annotations[dm.sourceLine];
+		if (annotation.first.find(dm.message) == std::string::npos) {
+			// Only append unique messages
+			if (!annotation.first.empty()) {
+				annotation.first += "\n";
+				annotation.second += '\0';
 			}
+			annotation.first += dm.message;
+			annotation.second += std::string(dm.message.length(), dm.severity);
+		}
+	}
+	for (const int line : file->linesAnnotated) {
+		if ((annotations.count(line) == 0) && wEditor.CallString(SCI_ANNOTATIONGETTEXT, line, nullptr)) {
+			wEditor.CallString(SCI_ANNOTATIONSETTEXT, line, nullptr);
 		}
-		line++;
+	}
+	file->linesAnnotated.clear();
+	for (const std::pair<const int, std::pair<std::string, std::string>> &annotation : annotations) {
+		const int line = annotation.first;
+		const std::string &text = annotation.second.first;
+		const std::string &styles = annotation.second.second;
+		const int lenCurrent = wEditor.CallString(SCI_ANNOTATIONGETTEXT, line, nullptr);
+		std::string textCurrent(lenCurrent, '\0');
+		std::string stylesCurrent(lenCurrent, '\0');
+		if (lenCurrent) {
+			wEditor.CallString(SCI_ANNOTATIONGETTEXT, line, &textCurrent[0]);
+			wEditor.CallString(SCI_ANNOTATIONGETSTYLES, line, &stylesCurrent[0]);
+		}
+		if ((textCurrent != text) || (stylesCurrent != styles)) {
+			wEditor.CallString(SCI_ANNOTATIONSETTEXT, line, text.c_str());
+			wEditor.CallString(SCI_ANNOTATIONSETSTYLES, line, styles.c_str());
+		}
+		file->linesAnnotated.push_back(line);
 	}
 }
 
+void SciTEBase::ShowMessages(int line) {
+	IndexDiagnostics();
+	const sptr_t offsetLine = OutputOffsetFromPosition(wOutput.Call(SCI_POSITIONFROMLINE, line, 0));
+	const std::vector<DiagnosticMessage> &messages = diagnostics.messages;
+	const auto it = std::upper_bound(messages.begin(), messages.end(), offsetLine,
+		[](sptr_t offset, const DiagnosticMessage &dm) noexcept { return offset < dm.offset; });
+	diagnostics.blockShown = (it == messages.begin()) ? -1 : (it - 1)->block;
+	ShowDiagnostics();
+}
+
 void SciTEBase::GoMessage(int dir) {
+	OutputFlush();
 	const int selStart = wOutput.Call(SCI_GETSELECTIONSTART);
 	const int curLine = wOutput.Call(SCI_LINEFROMPOSITION, selStart);
-	const int maxLine = wOutput.Call(SCI_GETLINECOUNT);
-	int lookLine = curLine + dir;
+	const int lookLine = (dir == 0) ? curLine : NextDiagnosticLine(curLine, dir);
 	if (lookLine < 0)
-		lookLine = maxLine - 1;
-	else if (lookLine >= maxLine)
-		lookLine = 0;
+		return;
 	TextReader acc(wOutput);
-	while ((dir == 0) || (lookLine != curLine)) {
-		const int startPosLine = wOutput.Call(SCI_POSITIONFROMLINE, lookLine, 0);
-		const int lineLength = wOutput.Call(SCI_LINELENGTH, lookLine, 0);
-		int style = acc.StyleAt(startPosLine);
-		if (style != SCE_ERR_DEFAULT &&
-		        style != SCE_ERR_CMD &&
-		        style != SCE_ERR_DIFF_ADDITION &&
-		        style != SCE_ERR_DIFF_CHANGED &&
-		        style != SCE_ERR_DIFF_DELETION) {
-			wOutput.Call(SCI_MARKERDELETEALL, static_cast<uptr_t>(-1));
-			wOutput.Call(SCI_MARKERDEFINE, 0, SC_MARK_SMALLRECT);
-			wOutput.Call(SCI_MARKERSETFORE, 0, ColourOfProperty(props,
-			        "error.marker.fore", ColourRGB(0x7f, 0, 0)));
-			wOutput.Call(SCI_MARKERSETBACK, 0, ColourOfProperty(props,
-			        "error.marker.back", ColourRGB(0xff, 0xff, 0)));
-			wOutput.Call(SCI_MARKERADD, lookLine, 0);
-			wOutput.Call(SCI_SETSEL, startPosLine, startPosLine);
-			std::string message = GetRangeString(wOutput, startPosLine, startPosLine + lineLength);
-			if ((style == SCE_ERR_ESCSEQ) || (style == SCE_ERR_ESCSEQ_UNKNOWN) || (style >= SCE_ERR_ES_BLACK)) {
-				// GCC message with ANSI escape sequences
-				RemoveEscSeq(message);
-				style = SCE_ERR_GCC;
-			}
-			std::string source;
-			int column;
-			long sourceLine = DecodeMessage(message.c_str(), source, style, column);
-			if (sourceLine >= 0) {
-				GUI::gui_string sourceString = GUI::StringFromUTF8(source);
-				FilePath sourcePath = FilePath(sourceString).NormalizePath();
-				if (!filePath.Name().SameNameAs(sourcePath)) {
-					FilePath messagePath;
-					bool bExists = false;
-					if (Exists(dirNameAtExecute.AsInternal(), sourceString.c_str(), &messagePath)) {
-						bExists = true;
-					} else if (Exists(dirNameForExecute.AsInternal(), sourceString.c_str(), &messagePath)) {
-						bExists = true;
-					} else if (Exists(filePath.Directory().AsInternal(), sourceString.c_str(), &messagePath)) {
-						bExists = true;
-					} else if (Exists(nullptr, sourceString.c_str(), &messagePath)) {
+	const int startPosLine = wOutput.Call(SCI_POSITIONFROMLINE, lookLine, 0);
+	const int lineLength = wOutput.Call(SCI_LINELENGTH, lookLine, 0);
+	int style = acc.StyleAt(startPosLine);
+	if (!IsMessageStyle(style))
+		return;
+	wOutput.Call(SCI_MARKERDELETEALL, static_cast<uptr_t>(-1));
+	wOutput.Call(SCI_MARKERDEFINE, 0, SC_MARK_SMALLRECT);
+	wOutput.Call(SCI_MARKERSETFORE, 0, ColourOfProperty(props,
+	        "error.marker.fore", ColourRGB(0x7f, 0, 0)));
+	wOutput.Call(SCI_MARKERSETBACK, 0, ColourOfProperty(props,
+	        "error.marker.back", ColourRGB(0xff, 0xff, 0)));
+	wOutput.Call(SCI_MARKERADD, lookLine, 0);
+	wOutput.Call(SCI_SETSEL, startPosLine, startPosLine);
+	std::string message = GetRangeString(wOutput, startPosLine, startPosLine + lineLength);
+	if ((style == SCE_ERR_ESCSEQ) || (style == SCE_ERR_ESCSEQ_UNKNOWN) || (style >= SCE_ERR_ES_BLACK)) {
+		// GCC message with ANSI escape sequences
+		RemoveEscSeq(message);
+		style = SCE_ERR_GCC;
+	}
+	std::string source;
+	int column;
+	long sourceLine = DecodeMessage(message.c_str(), source, style, column);
+	if (sourceLine >= 0) {
+		GUI::gui_string sourceString = GUI::StringFromUTF8(source);
+		FilePath sourcePath = FilePath(sourceString).NormalizePath();
+		if (!filePath.Name().SameNameAs(sourcePath)) {
+			FilePath messagePath;
+			bool bExists = false;
+			if (Exists(dirNameAtExecute.AsInternal(), sourceString.c_str(), &messagePath)) {
+				bExists = true;
+			} else if (Exists(dirNameForExecute.AsInternal(), sourceString.c_str(), &messagePath)) {
+				bExists = true;
+			} else if (Exists(filePath.Directory().AsInternal(), sourceString.c_str(), &messagePath)) {
+				bExists = true;
+			} else if (Exists(nullptr, sourceString.c_str(), &messagePath)) {
+				bExists = true;
+			} else {
+				// Look through buffers for name match
+				for (int i = buffers.lengthVisible - 1; i >= 0; i--) {
+					if (sourcePath.Name().SameNameAs(buffers.buffers[i].file.Name())) {
+						messagePath = buffers.buffers[i].file;
 						bExists = true;
-					} else {
-						// Look through buffers for name match
-						for (int i = buffers.lengthVisible - 1; i >= 0; i--) {
-							if (sourcePath.Name().SameNameAs(buffers.buffers[i].file.Name())) {
-								messagePath = buffers.buffers[i].file;
-								bExists = true;
-							}
-						}
-					}
-					if (bExists) {
-						if (!Open(messagePath, ofSynchronous)) {
-							return;
-						}
-						CheckReload();
-					}
-				}
-
-				// If ctag then get line number after search tag or use ctag line number
-				if (style == SCE_ERR_CTAG) {
-					//without following focus GetCTag wouldn't work correct
-					WindowSetFocus(wOutput);
-					std::string cTag = GetCTag();
-					if (cTag.length() != 0) {
-						if (atoi(cTag.c_str()) > 0) {
-							//if tag is linenumber, get line
-							sourceLine = atoi(cTag.c_str()) - 1;
-						} else {
-							findWhat = cTag;
-							FindNext(false);
-							//get linenumber for marker from found position
-							sourceLine = wEditor.Call(SCI_LINEFROMPOSITION, wEditor.Call(SCI_GETCURRENTPOS));
-						}
 					}
 				}
-
-				else if (style == SCE_ERR_DIFF_MESSAGE) {
-					const bool isAdd = message.find("+++ ") == 0;
-					const int atLine = lookLine + (isAdd ? 1 : 2); // lines are in this order: ---, +++, @@
-					std::string atMessage = GetLine(wOutput, atLine);
-					if (StartsWith(atMessage, "@@ -")) {
-						size_t atPos = 4; // deleted position starts right after "@@ -"
-						if (isAdd) {
-							const size_t linePlace = atMessage.find(" +", 7);
-							if (linePlace != std::string::npos)
-								atPos = linePlace + 2; // skip "@@ -1,1" and then " +"
-						}
-						sourceLine = atol(atMessage.c_str() + atPos) - 1;
-					}
+			}
+			if (bExists) {
+				if (!Open(messagePath, ofSynchronous)) {
+					return;
 				}
+				CheckReload();
+			}
+		}
 
-				if (props.GetInt("error.inline")) {
-					ShowMessages(lookLine);
+		// If ctag then get line number after search tag or use ctag line number
+		if (style == SCE_ERR_CTAG) {
+			//without following focus GetCTag wouldn't work correct
+			WindowSetFocus(wOutput);
+			std::string cTag = GetCTag();
+			if (cTag.length() != 0) {
+				if (atoi(cTag.c_str()) > 0) {
+					//if tag is linenumber, get line
+					sourceLine = atoi(cTag.c_str()) - 1;
+				} else {
+					findWhat = cTag;
+					FindNext(false);
+					//get linenumber for marker from found position
+					sourceLine = wEditor.Call(SCI_LINEFROMPOSITION, wEditor.Call(SCI_GETCURRENTPOS));
 				}
+			}
+		}
 
-				wEditor.Call(SCI_MARKERDELETEALL, 0);
-				wEditor.Call(SCI_MARKERDEFINE, 0, SC_MARK_CIRCLE);
-				wEditor.Call(SCI_MARKERSETFORE, 0, ColourOfProperty(props,
-				        "error.marker.fore", ColourRGB(0x7f, 0, 0)));
-				wEditor.Call(SCI_MARKERSETBACK, 0, ColourOfProperty(props,
-				        "error.marker.back", ColourRGB(0xff, 0xff, 0)));
-				wEditor.Call(SCI_MARKERADD, sourceLine, 0);
-				int startSourceLine = wEditor.Call(SCI_POSITIONFROMLINE, sourceLine, 0);
-				const int endSourceline = wEditor.Call(SCI_POSITIONFROMLINE, sourceLine + 1, 0);
-				if (column >= 0) {
-					// Get the position in line according to current tab setting
-					startSourceLine = wEditor.Call(SCI_FINDCOLUMN, sourceLine, column);
+		else if (style == SCE_ERR_DIFF_MESSAGE) {
+			const bool isAdd = message.find("+++ ") == 0;
+			const int atLine = lookLine + (isAdd ? 1 : 2); // lines are in this order: ---, +++, @@
+			std::string atMessage = GetLine(wOutput, atLine);
+			if (StartsWith(atMessage, "@@ -")) {
+				size_t atPos = 4; // deleted position starts right after "@@ -"
+				if (isAdd) {
+					const size_t linePlace = atMessage.find(" +", 7);
+					if (linePlace != std::string::npos)
+						atPos = linePlace + 2; // skip "@@ -1,1" and then " +"
 				}
-				EnsureRangeVisible(wEditor, startSourceLine, startSourceLine);
-				if (props.GetInt("error.select.line") == 1) {
-					//select whole source source line from column with error
-					SetSelection(endSourceline, startSourceLine);
-				} else {
-					//simply move cursor to line, don't do any selection
-					SetSelection(startSourceLine, startSourceLine);
-				}
-				std::replace(message.begin(), message.end(), '\t', ' ');
-				::Remove(message, std::string("\n"));
-				props.Set("CurrentMessage", message.c_str());
-				UpdateStatusBar(false);
-				WindowSetFocus(wEditor);
+				sourceLine = atol(atMessage.c_str() + atPos) - 1;
 			}
-			return;
 		}
-		lookLine += dir;
-		if (lookLine < 0)
-			lookLine = maxLine - 1;
-		else if (lookLine >= maxLine)
-			lookLine = 0;
-		if (dir == 0)
-			return;
+
+		if (props.GetInt("error.inline")) {
+			ShowMessages(lookLine);
+		}
+
+		wEditor.Call(SCI_MARKERDELETEALL, 0);
+		wEditor.Call(SCI_MARKERDEFINE, 0, SC_MARK_CIRCLE);
+		wEditor.Call(SCI_MARKERSETFORE, 0, ColourOfProperty(props,
+		        "error.marker.fore", ColourRGB(0x7f, 0, 0)));
+		wEditor.Call(SCI_MARKERSETBACK, 0, ColourOfProperty(props,
+		        "error.marker.back", ColourRGB(0xff, 0xff, 0)));
+		wEditor.Call(SCI_MARKERADD, sourceLine, 0);
+		int startSourceLine = wEditor.Call(SCI_POSITIONFROMLINE, sourceLine, 0);
+		const int endSourceline = wEditor.Call(SCI_POSITIONFROMLINE, sourceLine + 1, 0);
+		if (column >= 0) {
+			// Get the position in line according to current tab setting
+			startSourceLine = wEditor.Call(SCI_FINDCOLUMN, sourceLine, column);
+		}
+		EnsureRangeVisible(wEditor, startSourceLine, startSourceLine);
+		if (props.GetInt("error.select.line") == 1) {
+			//select whole source source line from column with error
+			SetSelection(endSourceline, startSourceLine);
+		} else {
+			//simply move cursor to line, don't do any selection
+			SetSelection(startSourceLine, startSourceLine);
+		}
+		std::replace(message.begin(), message.end(), '\t', ' ');
+		::Remove(message, std::string("\n"));
+		props.Set("CurrentMessage", message.c_str());
+		UpdateStatusBar(false);
+		WindowSetFocus(wEditor);
 	}
 }
 
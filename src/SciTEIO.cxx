@@ -10,6 +10,7 @@
 // Older versions of GNU stdint.h require this definition to be able to see INT32_MAX
 #define __STDC_LIMIT_MACROS
 #include <cstdint>
+#include <cassert>
 #include <cstring>
 #include <cstdio>
 #include <ctime>
@@ -42,7 +43,9 @@
 #include "Cookie.h"
 #include "Worker.h"
 #include "FileWorker.h"
+#include "FileWatcher.h"
 #include "MatchMarker.h"
+#include "EditorConfig.h"
 #include "SciTEBase.h"
 #include "Utf8_16.h"
 
@@ -190,7 +193,13 @@ std::string SciTEBase::DiscoverLanguage() {
 }
 
 void SciTEBase::DiscoverIndentSetting() {
-	const int lengthDoc = std::min(LengthDocument(), 1000000);
+	int lengthDoc = std::min(LengthDocument(), 1000000);
+	if (FeatureMode(SizeTiers::tfIndentDiscovery) != SizeTiers::tmFull) {
+		// Only the lines shown when the file is opened
+		const int lineLimit = wEditor.Call(SCI_LINESONSCREEN) + 1;
+		if (lineLimit < wEditor.Call(SCI_GETLINECOUNT))
+			lengthDoc = std::min(lengthDoc, wEditor.Call(SCI_POSITIONFROMLINE, lineLimit));
+	}
 	TextReader acc(wEditor);
 	bool newline = true;
 	int indent = 0; // current line indentation
@@ -242,6 +251,20 @@ void SciTEBase::DiscoverIndentSetting() {
 	}
 }
 
+// Examine the start of a file for NUL bytes outside UTF-16 text.
+static bool AppearsBinary(const FilePath &path) {
+	FILE *fp = path.Open(fileRead);
+	if (!fp)
+		return false;
+	std::vector<char> data(blockSize);
+	const size_t lenFile = fread(&data[0], 1, data.size(), fp);
+	fclose(fp);
+	Utf8_16_Read convert;
+	convert.setDetect(true);
+	convert.convert(&data[0], lenFile);
+	return convert.getContent() == Utf8_16::cBinary;
+}
+
 void SciTEBase::OpenCurrentFile(long long fileSize, bool suppressMessage, bool asynchronous) {
 	if (CurrentBuffer()->pFileWorker) {
 		// Already performing an asynchronous load or save so do not restart load
@@ -294,13 +317,16 @@ void SciTEBase::OpenCurrentFile(long long fileSize, bool suppressMessage, bool a
 			wEditor.Call(SCI_SETSTATUS, 0);
 			return;
 		}
-		CurrentBuffer()->pFileWorker = new FileLoader(this, pdocLoad, filePath, static_cast<size_t>(fileSize), fp);
-		CurrentBuffer()->pFileWorker->sleepTime = props.GetInt("asynchronous.sleep");
+		FileLoader *pFileLoader = new FileLoader(this, pdocLoad, filePath, static_cast<size_t>(fileSize), fp);
+		pFileLoader->sleepTime = props.GetInt("asynchronous.sleep");
+		pFileLoader->detectEncoding = props.GetInt("encoding.detect") != 0;
+		CurrentBuffer()->pFileWorker = pFileLoader;
 		PerformOnNewThread(CurrentBuffer()->pFileWorker);
 	} else {
 		wEditor.Call(SCI_ALLOCATE, static_cast<uptr_t>(fileSize) + 1000);
 
 		Utf8_16_Read convert;
+		convert.setDetect(props.GetInt("encoding.detect") != 0);
 		std::vector<char> data(blockSize);
 		size_t lenFile = fread(&data[0], 1, data.size(), fp);
 		const UniMode umCodingCookie = CodingCookieValue(&data[0], lenFile);
@@ -327,6 +353,10 @@ void SciTEBase::OpenCurrentFile(long long fileSize, bool suppressMessage, bool a
 		if (CurrentBuffer()->unicodeMode == uni8Bit) {
 			CurrentBuffer()->unicodeMode = umCodingCookie;
 		}
+		// Valid UTF-8 without a BOM is treated like UTF-8 with a cookie
+		if ((CurrentBuffer()->unicodeMode == uni8Bit) && (convert.getContent() == Utf8_16::cUtf8)) {
+			CurrentBuffer()->unicodeMode = uniCookie;
+		}
 
 		CompleteOpen(ocSynchronous);
 	}
@@ -402,7 +432,7 @@ void SciTEBase::CompleteOpen(OpenCompletion oc) {
 
 	DiscoverEOLSetting();
 
-	if (props.GetInt("indent.auto")) {
+	if (props.GetInt("indent.auto") && (FeatureMode(SizeTiers::tfIndentDiscovery) != SizeTiers::tmOff)) {
 		DiscoverIndentSetting();
 	}
 
@@ -410,10 +440,12 @@ void SciTEBase::CompleteOpen(OpenCompletion oc) {
 		wEditor.Call(SCI_SETUNDOCOLLECTION, 1);
 	}
 	wEditor.Call(SCI_SETSAVEPOINT);
-	if (props.GetInt("fold.on.open") > 0) {
+	if ((props.GetInt("fold.on.open") > 0) && (FeatureMode(SizeTiers::tfFold) == SizeTiers::tmFull)) {
 		FoldAll();
 	}
 	wEditor.Call(SCI_GOTOPOS, 0);
+	if (props.GetInt("error.inline"))
+		ShowDiagnostics();
 
 	CurrentBuffer()->CompleteLoading();
 
@@ -430,6 +462,9 @@ void SciTEBase::TextWritten(FileWorker *pFileWorker) {
 
 	// May not be found if save cancelled or buffer closed
 	if (iBuffer >= 0) {
+		// Only a write of the unmodified document to its own file makes the buffer clean
+		const bool storedDocument = pathSaved.SameNameAs(buffers.buffers[iBuffer].file) &&
+			(buffers.buffers[iBuffer].revision == buffers.buffers[iBuffer].revisionStoring);
 		// Complete and release
 		buffers.buffers[iBuffer].CompleteStoring();
 		if (errSaved || cancelledSaved) {
@@ -446,12 +481,12 @@ void SciTEBase::TextWritten(FileWorker *pFileWorker) {
 			}
 			if (iBuffer == buffers.Current()) {
 				wEditor.Call(SCI_SETREADONLY, CurrentBuffer()->isReadOnly);
-				if (pathSaved.SameNameAs(CurrentBuffer()->file)) {
+				if (storedDocument) {
 					wEditor.Call(SCI_SETSAVEPOINT);
 				}
-				if (extender)
+				if (extender && pathSaved.SameNameAs(CurrentBuffer()->file))
 					extender->OnSave(buffers.buffers[iBuffer].file.AsUTF8().c_str());
-			} else {
+			} else if (storedDocument) {
 				buffers.buffers[iBuffer].isDirty = false;
 				buffers.buffers[iBuffer].failedSave = false;
 				// Need to make writable and set save point when next receive focus.
@@ -558,6 +593,15 @@ bool SciTEBase::Open(const FilePath &file, OpenFlags of) {
 				return false;
 			}
 		}
+		if (props.GetInt("check.if.binary") && props.GetInt("encoding.detect") &&
+			!(of & ofQuiet) && AppearsBinary(absPath)) {
+			const GUI::gui_string msg = LocaliseMessage("File '^0' appears to be a binary file.\n"
+			        "Do you still want to open it?", absPath.AsInternal());
+			const MessageBoxChoice answer = WindowMessageBox(wSciTE, msg, mbsYesNo | mbsIconWarning);
+			if (answer != mbYes) {
+				return false;
+			}
+		}
 	}
 
 	if (buffers.size() == buffers.length) {
@@ -586,6 +630,7 @@ bool SciTEBase::Open(const FilePath &file, OpenFlags of) {
 	}
 	CurrentBuffer()->props = propsDiscovered;
 	CurrentBuffer()->overrideExtension = "";
+	CurrentBuffer()->fileLength = fileSize;	// Choose the size tier before loading
 	ReadProperties();
 	SetIndentSettings();
 	SetEol();
@@ -757,11 +802,105 @@ void SciTEBase::Revert() {
 	}
 }
 
+// Seek from the start of a file to a position which may be beyond the range of long,
+// which is only 32 bits on Windows.
+static bool SeekFile(FILE *fp, long long position) noexcept {
+#ifdef WIN32
+	return _fseeki64(fp, position, SEEK_SET) == 0;
+#else
+	return fseeko(fp, static_cast<off_t>(position), SEEK_SET) == 0;
+#endif
+}
+
+// When a file has grown and still ends with the text that was at its end, as happens
+// with logs, only the new text is read and appended to the document.
+// Returns false when the whole file has to be reloaded.
+bool SciTEBase::ReloadAppended() {
+	Buffer *pBuffer = CurrentBuffer();
+	if (pBuffer->isDirty || pBuffer->pFileWorker || (pBuffer->lifeState != Buffer::open)) {
+		return false;
+	}
+	// Only possible where the document holds the bytes of the file
+	long long lengthBOM = 0;
+	if (pBuffer->unicodeMode == uniUTF8) {
+		lengthBOM = 3;
+	} else if ((pBuffer->unicodeMode != uni8Bit) && (pBuffer->unicodeMode != uniCookie)) {
+		return false;
+	}
+	const long long lengthOld = pBuffer->fileLength;
+	const long long lengthNew = filePath.GetFileLength();
+	const int lengthDoc = LengthDocument();
+	if ((lengthOld <= lengthBOM) || (lengthNew <= lengthOld) ||
+		(lengthNew > INTPTR_MAX) || (lengthDoc + lengthBOM != lengthOld)) {
+		return false;
+	}
+	FILE *fp = filePath.Open(fileRead);
+	if (!fp) {
+		return false;
+	}
+
+	// Compare the end of the document with the same range of the file
+	const int lengthTail = std::min(lengthDoc, 4096);
+	std::string tailFile(lengthTail, '\0');
+	const bool sameTail = SeekFile(fp, lengthOld - lengthTail) &&
+		(fread(&tailFile[0], 1, lengthTail, fp) == static_cast<size_t>(lengthTail)) &&
+		(tailFile == GetRangeString(wEditor, lengthDoc - lengthTail, lengthDoc));
+	if (!sameTail) {
+		fclose(fp);
+		return false;
+	}
+
+	// Follow the end of the file if the caret is there
+	const bool atEnd = (wEditor.Call(SCI_GETCURRENTPOS) == lengthDoc) && wEditor.Call(SCI_GETSELECTIONEMPTY);
+	const bool preserveUndo = props.GetInt("reload.preserves.undo") != 0;
+	wEditor.Call(SCI_SETREADONLY, 0);
+	if (preserveUndo) {
+		wEditor.Call(SCI_BEGINUNDOACTION);
+	} else {
+		wEditor.Call(SCI_SETUNDOCOLLECTION, 0);
+	}
+	std::vector<char> data(blockSize);
+	long long lengthRead = 0;
+	size_t lenFile = fread(&data[0], 1, data.size(), fp);
+	while (lenFile > 0) {
+		wEditor.CallString(SCI_APPENDTEXT, lenFile, &data[0]);
+		lengthRead += lenFile;
+		lenFile = fread(&data[0], 1, data.size(), fp);
+	}
+	fclose(fp);
+	if (preserveUndo) {
+		wEditor.Call(SCI_ENDUNDOACTION);
+	} else {
+		wEditor.Call(SCI_EMPTYUNDOBUFFER);
+		wEditor.Call(SCI_SETUNDOCOLLECTION, 1);
+	}
+	wEditor.Call(SCI_SETSAVEPOINT);
+	wEditor.Call(SCI_SETREADONLY, pBuffer->isReadOnly);
+
+	pBuffer->SetTimeFromFile();
+	// Any text added since reading will be seen as a change of length
+	pBuffer->fileLength = lengthOld + lengthRead;
+	if (atEnd) {
+		wEditor.Call(SCI_GOTOPOS, LengthDocument());
+	}
+	return true;
+}
+
 void SciTEBase::CheckReload() {
-	if (props.GetInt("load.on.activate")) {
+	if (props.GetInt("load.on.activate") || followFile) {
+		if (fileWatcher && !CurrentBuffer()->changedOnDisk && fileWatcher->Watching(filePath)) {
+			// Not notified of any change so avoid examining the file
+			return;
+		}
+		CurrentBuffer()->changedOnDisk = false;
 		// Make a copy of fullPath as otherwise it gets aliased in Open
 		const time_t newModTime = filePath.ModifiedTime();
-		if ((newModTime != 0) && (newModTime != CurrentBuffer()->fileModTime)) {
+		const bool appendable = followFile || props.GetInt("reload.appended");
+		if ((newModTime != 0) && ((newModTime != CurrentBuffer()->fileModTime) ||
+			(appendable && (filePath.GetFileLength() != CurrentBuffer()->fileLength)))) {
+			if (appendable && ReloadAppended()) {
+				return;
+			}
 			RecentFile rf = GetFilePosition();
 			const OpenFlags of = props.GetInt("reload.preserves.undo") ? ofPreserveUndo : ofNone;
 			if (CurrentBuffer()->isDirty || props.GetInt("are.you.sure.on.reload") != 0) {
@@ -803,6 +942,54 @@ void SciTEBase::CheckReload() {
 	}
 }
 
+/**
+ * Watch the open files, imported properties files, and .editorconfig files for changes
+ * made by other programs.
+ */
+void SciTEBase::WatchFiles() {
+	FilePathSet files;
+	if (props.GetInt("load.watch", 1)) {
+		for (int i = 0; i < buffers.length; i++) {
+			files.push_back(buffers.buffers[i].file);
+		}
+		files.insert(files.end(), importFiles.begin(), importFiles.end());
+		const FilePathSet configFiles = editorConfig->ConfigFiles();
+		files.insert(files.end(), configFiles.begin(), configFiles.end());
+	}
+	if (files == filesWatched) {
+		return;
+	}
+	filesWatched = files;
+	if (!fileWatcher && !filesWatched.empty()) {
+		fileWatcher = FileWatcher::Create(this);
+	}
+	if (fileWatcher) {
+		fileWatcher->Watch(filesWatched);
+	}
+}
+
+void SciTEBase::FilesChanged(const FilePathSet &files) {
+	const FilePathSet configFiles = editorConfig->ConfigFiles();
+	bool propertiesChanged = false;
+	for (const FilePath &file : files) {
+		if ((std::find(importFiles.begin(), importFiles.end(), file) != importFiles.end()) ||
+			(std::find(configFiles.begin(), configFiles.end(), file) != configFiles.end())) {
+			propertiesChanged = true;
+		}
+		const int index = buffers.GetDocumentByName(file);
+		if (index >= 0) {
+			// Other buffers are checked when they are switched to
+			buffers.buffers[index].changedOnDisk = true;
+		}
+	}
+	if (propertiesChanged) {
+		ReloadProperties();
+	}
+	if (CurrentBuffer()->changedOnDisk && (0 == dialogsOnScreen)) {
+		CheckReload();
+	}
+}
+
 void SciTEBase::Activate(bool activeApp) {
 	if (activeApp) {
 		CheckReload();
@@ -1090,6 +1277,7 @@ bool SciTEBase::SaveBuffer(const FilePath &saveName, SaveFlags sf) {
 				const char *documentBytes = reinterpret_cast<const char *>(wEditor.CallReturnPointer(SCI_GETCHARACTERPOINTER));
 				CurrentBuffer()->pFileWorker = new FileStorer(this, documentBytes, saveName, lengthDoc, fp, CurrentBuffer()->unicodeMode, (sf & sfProgressVisible));
 				CurrentBuffer()->pFileWorker->sleepTime = props.GetInt("asynchronous.sleep");
+				CurrentBuffer()->revisionStoring = CurrentBuffer()->revision;
 				if (PerformOnNewThread(CurrentBuffer()->pFileWorker)) {
 					retVal = true;
 				} else {
@@ -1258,6 +1446,97 @@ void SciTEBase::AbandonAutomaticSave() {
 	CurrentBuffer()->AbandonAutomaticSave();
 }
 
+// Recovery files are named after the whole path of the file so files with the
+// same name in different directories do not collide.
+FilePath SciTEBase::RecoveryPath(const FilePath &path) {
+	const std::string recoveryDirectory = props.GetExpandedString("save.recovery");
+	if (recoveryDirectory.empty() || path.IsUntitled()) {
+		return FilePath();
+	}
+	GUI::gui_string name = path.AbsolutePath().AsInternal();
+	for (GUI::gui_char &ch : name) {
+		if ((ch == pathSepChar) || (ch == '/') || (ch == ':')) {
+			ch = '%';
+		}
+	}
+	name += GUI_TEXT(".recover");
+	return FilePath(FilePath(GUI::StringFromUTF8(recoveryDirectory)), FilePath(name));
+}
+
+void SciTEBase::RemoveRecoveryFile(const FilePath &path) {
+	const FilePath recoveryPath = RecoveryPath(path);
+	if (recoveryPath.IsSet()) {
+		recoveryPath.Remove();
+	}
+}
+
+// Write the text of a buffer from a background thread without switching to it.
+// The current document is copied so typing can continue while it is written and
+// hidden documents are written from the text retained when they were hidden.
+// When save.recovery is set, the text goes to the recovery directory and the
+// buffer remains modified.
+void SciTEBase::AutoSaveBuffer(int index) {
+	Buffer &buffer = buffers.buffers[index];
+	const bool isCurrent = index == buffers.Current();
+	if (!isCurrent && !buffer.documentBytes) {
+		// Hidden before automatic save was turned on so wait until shown
+		return;
+	}
+
+	FilePath pathSave = RecoveryPath(buffer.file);
+	const bool recovery = pathSave.IsSet();
+	if (!recovery) {
+		pathSave = buffer.file;
+		if (props.GetInt("save.check.modified.time")) {
+			const time_t newModTime = pathSave.ModifiedTime();
+			if ((newModTime != 0) && (buffer.fileModTime != 0) && (newModTime != buffer.fileModTime)) {
+				// Modified outside SciTE so leave for the user to decide when saving explicitly
+				return;
+			}
+		}
+	}
+
+	FILE *fp = pathSave.Open(fileWrite);
+	if (!fp && recovery && !pathSave.Directory().Exists()) {
+		// First recovery file in a new profile
+		pathSave.Directory().MakeDirectory();
+		fp = pathSave.Open(fileWrite);
+	}
+	if (!fp) {
+		if (recovery) {
+			// Try again after another delay, reporting only the first failure
+			buffer.documentModTime = time(nullptr);
+			if (!recoveryFailed) {
+				recoveryFailed = true;
+				Trace(("> Could not write recovery file " + pathSave.AsUTF8() + "\n").c_str());
+			}
+		} else {
+			buffer.failedSave = true;
+		}
+		return;
+	}
+
+	const char *documentBytes = buffer.documentBytes;
+	size_t lengthDoc = buffer.documentLength;
+	if (isCurrent) {
+		lengthDoc = LengthDocument();
+		documentBytes = reinterpret_cast<const char *>(wEditor.CallReturnPointer(SCI_GETCHARACTERPOINTER));
+	}
+	FileStorer *pFileStorer = new FileStorer(this, documentBytes, pathSave, lengthDoc, fp, buffer.unicodeMode, false);
+	if (isCurrent) {
+		pFileStorer->CopyDocument();
+	}
+	pFileStorer->sleepTime = props.GetInt("asynchronous.sleep");
+	buffer.pFileWorker = pFileStorer;
+	buffer.revisionStoring = buffer.revision;
+	if (!PerformOnNewThread(pFileStorer)) {
+		fclose(fp);
+		buffer.pFileWorker = nullptr;
+		delete pFileStorer;
+		buffer.failedSave = true;
+	}
+}
+
 bool SciTEBase::IsStdinBlocked() {
 	return false; /* always default to blocked */
 }
@@ -645,10 +645,110 @@ std::string SciTEBase::GetFileNameProperty(const char *name) {
 	}
 }
 
+namespace {
+
+const char *featureNames[SizeTiers::tfFeatures] = {
+	"highlight.current.word", "braces", "autocomplete.word", "indent.auto", "fold", "line.numbers"
+};
+
+const char *modeNames[] = { "full", "lazy", "visible", "off" };
+
+}
+
+/**
+ * Read the tiers named by size.tiers. Each tier is entered when a document is larger
+ * than size.tier.<name> and size.tier.<name>.features is a list of feature:mode.
+ * Features not listed keep the mode of the next smaller tier.
+ */
+void SizeTiers::Read(const PropSetFile &props) {
+	tiers.clear();
+	const std::string names = props.GetExpandedString("size.tiers");
+	for (const std::string &name : StringSplit(names, ' ')) {
+		const std::string key = "size.tier." + name;
+		Tier tier = { name, props.GetLongLong(key.c_str()), {} };
+		if (name.empty() || (tier.size <= 0))
+			continue;
+		std::fill(std::begin(tier.modes), std::end(tier.modes), tmInherit);
+		const std::string features = props.GetExpandedString((key + ".features").c_str());
+		for (const std::string &featureMode : StringSplit(features, ' ')) {
+			const size_t colon = featureMode.find(':');
+			if (colon == std::string::npos)
+				continue;
+			const int feature = FeatureFromName(featureMode.substr(0, colon).c_str());
+			const std::string mode = featureMode.substr(colon + 1);
+			for (size_t m = 0; (feature >= 0) && (m < std::size(modeNames)); m++) {
+				if (mode == modeNames[m])
+					tier.modes[feature] = static_cast<Mode>(m);
+			}
+		}
+		tiers.push_back(tier);
+	}
+	std::stable_sort(tiers.begin(), tiers.end(), [](const Tier &a, const Tier &b) noexcept {
+		return a.size < b.size;
+	});
+	for (size_t t = 0; t < tiers.size(); t++) {
+		for (int feature = 0; feature < tfFeatures; feature++) {
+			if (tiers[t].modes[feature] == tmInherit)
+				tiers[t].modes[feature] = (t > 0) ? tiers[t - 1].modes[feature] : tmFull;
+		}
+	}
+}
+
+int SizeTiers::TierFromSize(long long size) const noexcept {
+	int tier = -1;
+	for (size_t t = 0; (t < tiers.size()) && (size > tiers[t].size); t++) {
+		tier = static_cast<int>(t);
+	}
+	return tier;
+}
+
+int SizeTiers::FeatureFromName(const char *name) noexcept {
+	for (int feature = 0; feature < tfFeatures; feature++) {
+		if (0 == strcmp(name, featureNames[feature]))
+			return feature;
+	}
+	return -1;
+}
+
+/**
+ * How much of a feature to use for the current buffer given its size tier.
+ */
+SizeTiers::Mode SciTEBase::FeatureMode(SizeTiers::Feature feature) {
+	const Buffer *buffer = CurrentBufferConst();
+	if ((buffer->sizeTier < 0) || (buffer->sizeTier >= static_cast<int>(sizeTiers.tiers.size())) ||
+		(buffer->featuresFull & (1 << feature))) {
+		return SizeTiers::tmFull;
+	}
+	return sizeTiers.tiers[buffer->sizeTier].modes[feature];
+}
+
+/**
+ * Use a feature, or all features when name is empty or "all", fully for the current buffer
+ * regardless of its size tier.
+ */
+void SciTEBase::EnableFeature(const char *name) {
+	int features = (1 << SizeTiers::tfFeatures) - 1;
+	if (*name && strcmp(name, "all")) {
+		const int feature = SizeTiers::FeatureFromName(name);
+		if (feature < 0)
+			return;
+		features = 1 << feature;
+	}
+	CurrentBuffer()->featuresFull |= features;
+	ReadProperties();
+	SetIdler(true);
+	UpdateStatusBar(false);
+	CheckMenus();
+}
+
 void SciTEBase::ReadProperties() {
 	if (extender)
 		extender->Clear();
 
+	sizeTiers.Read(props);
+	CurrentBuffer()->sizeTier = sizeTiers.TierFromSize(
+		std::max<long long>(CurrentBuffer()->fileLength, LengthDocument()));
+
 	const std::string fileNameForExtension = ExtensionFileName();
 
 	std::string modulePath = props.GetNewExpandString("lexerpath.",
@@ -741,6 +841,9 @@ void SciTEBase::ReadProperties() {
 	for (size_t i=0; propertiesToForward[i]; i++) {
 		ForwardPropertyToEditor(propertiesToForward[i]);
 	}
+	if (FeatureMode(SizeTiers::tfFold) == SizeTiers::tmOff) {
+		wEditor.CallString(SCI_SETPROPERTY, UptrFromString("fold"), "0");
+	}
 
 	if (apisFileNames != props.GetNewExpandString("api.", fileNameForExtension.c_str())) {
 		apis.Clear();
@@ -1144,6 +1247,11 @@ void SciTEBase::ReadProperties() {
 
 
 	scrollOutput = props.GetInt("output.scroll", 1);
+	outputMaxLines = props.GetInt("output.max.lines");
+	outputMaxBytes = props.GetInt("output.max.bytes");
+	if (!outputMaxLines && !outputMaxBytes) {
+		OutputFlush();
+	}
 
 	tabHideOne = props.GetInt("tabbar.hide.one");
 
@@ -1154,13 +1262,14 @@ void SciTEBase::ReadProperties() {
 	// To put the folder markers in the line number region
 	//wEditor.Call(SCI_SETMARGINMASKN, 0, SC_MASK_FOLDERS);
 
-	wEditor.Call(SCI_SETMODEVENTMASK, SC_MOD_CHANGEFOLD);
+	// Insert/delete notifications (also fired by undo and redo) maintain the
+	// buffer's revision so are always needed.
+	wEditor.Call(SCI_SETMODEVENTMASK, SC_MOD_CHANGEFOLD | SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT);
 
-	if (0==props.GetInt("undo.redo.lazy")) {
-		// Trap for insert/delete notifications (also fired by undo
-		// and redo) so that the buttons can be enabled if needed.
-		wEditor.Call(SCI_SETMODEVENTMASK, SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT
-			| SC_LASTSTEPINUNDOREDO | wEditor.Call(SCI_GETMODEVENTMASK, 0));
+	undoRedoLazy = props.GetInt("undo.redo.lazy") != 0;
+	if (!undoRedoLazy) {
+		// Trap for undo and redo so that the buttons can be enabled if needed.
+		wEditor.Call(SCI_SETMODEVENTMASK, SC_LASTSTEPINUNDOREDO | wEditor.Call(SCI_GETMODEVENTMASK, 0));
 
 		//SC_LASTSTEPINUNDOREDO is probably not needed in the mask; it
 		//doesn't seem to fire as an event of its own; just modifies the
@@ -1173,7 +1282,8 @@ void SciTEBase::ReadProperties() {
 	foldMarginWidth = props.GetInt("fold.margin.width");
 	if (foldMarginWidth == 0)
 		foldMarginWidth = foldMarginWidthDefault;
-	wEditor.Call(SCI_SETMARGINWIDTHN, 2, foldMargin ? foldMarginWidth : 0);
+	const bool foldOff = FeatureMode(SizeTiers::tfFold) == SizeTiers::tmOff;
+	wEditor.Call(SCI_SETMARGINWIDTHN, 2, (foldMargin && !foldOff) ? foldMarginWidth : 0);
 
 	wEditor.Call(SCI_SETMARGINMASKN, 2, SC_MASK_FOLDERS);
 	wEditor.Call(SCI_SETMARGINSENSITIVEN, 2, 1);
@@ -1327,7 +1437,9 @@ void SciTEBase::ReadProperties() {
 	wEditor.Call(SCI_SETENDATLASTLINE, props.GetInt("end.at.last.line", 1));
 	wEditor.Call(SCI_SETCARETSTICKY, props.GetInt("caret.sticky", 0));
 
-	// Clear all previous indicators.
+	// Clear all previous indicators and forget the range they covered.
+	matchMarker.Stop();
+	currentWordHighlight.window = nullptr;
 	wEditor.Call(SCI_SETINDICATORCURRENT, indicatorHighlightCurrentWord);
 	wEditor.Call(SCI_INDICATORCLEARRANGE, 0, wEditor.Call(SCI_GETLENGTH));
 	wOutput.Call(SCI_SETINDICATORCURRENT, indicatorHighlightCurrentWord);
@@ -1424,6 +1536,19 @@ void SciTEBase::ReadProperties() {
 		TimerEnd(timerAutoSave);
 	}
 
+	followFile = props.GetInt("load.follow") != 0;
+	if (followFile) {
+		TimerStart(timerFollow);
+	} else {
+		TimerEnd(timerFollow);
+	}
+
+	WatchFiles();
+
+	// Lexer properties may have restyled the document
+	CurrentBuffer()->braceIndex.Restyled(wEditor.Call(SCI_GETENDSTYLED), lexLanguage);
+	SetIdler(true);
+
 	firstPropertiesRead = false;
 	needReadProperties = false;
 }
@@ -1595,6 +1720,7 @@ GUI::gui_string SciTEBase::LocaliseMessage(const char *s, const GUI::gui_char *p
 
 void SciTEBase::ReadLocalization() {
 	localiser.Clear();
+	sbFieldsValid = 0;
 	GUI::gui_string title = GUI_TEXT("locale.properties");
 	const std::string localeProps = props.GetExpandedString("locale.properties");
 	if (localeProps.length()) {
@@ -5,6 +5,8 @@
 // Copyright 1998-2010 by Neil Hodgson <neilh@scintilla.org>
 // The License.txt file describes the conditions under which this software may be distributed.
 
+#include <cstring>
+
 #include <string>
 
 #include "Scintilla.h"
@@ -104,9 +106,9 @@ void StyleWriter::ColourTo(unsigned int pos, int chAttr) {
 			// Too big for buffer so send directly
 			sw.Call(SCI_SETSTYLING, pos - startSeg + 1, chAttr);
 		} else {
-			for (unsigned int i = startSeg; i <= pos; i++) {
-				styleBuf[validLen++] = static_cast<char>(chAttr);
-			}
+			const int lenRun = pos - startSeg + 1;
+			memset(styleBuf + validLen, chAttr, lenRun);
+			validLen += lenRun;
 		}
 	}
 	startSeg = pos+1;
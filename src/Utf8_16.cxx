@@ -12,6 +12,14 @@
 #include <cstring>
 #include <cstdio>
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define UTF8_16_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
 #include "Utf8_16.h"
 
 const Utf8_16::utf8 Utf8_16::k_Boms[][3] = {
@@ -27,6 +35,444 @@ enum { SURROGATE_TRAIL_FIRST = 0xDC00 };
 enum { SURROGATE_TRAIL_LAST = 0xDFFF };
 enum { SURROGATE_FIRST_VALUE = 0x10000 };
 
+namespace {
+
+typedef Utf8_16::ubyte ubyte;
+
+bool IsLeadSurrogate(unsigned int value) noexcept {
+	return (value >= SURROGATE_LEAD_FIRST) && (value <= SURROGATE_LEAD_LAST);
+}
+
+template <bool bigEndian>
+unsigned int ReadUnit(const ubyte *pRead) noexcept {
+	if (bigEndian)
+		return (pRead[0] << 8) | pRead[1];
+	else
+		return pRead[0] | (pRead[1] << 8);
+}
+
+template <bool bigEndian>
+void WriteUnit(ubyte *&pOut, unsigned int value) noexcept {
+	if (bigEndian) {
+		*pOut++ = static_cast<ubyte>(value >> 8);
+		*pOut++ = static_cast<ubyte>(value & 0xFF);
+	} else {
+		*pOut++ = static_cast<ubyte>(value & 0xFF);
+		*pOut++ = static_cast<ubyte>(value >> 8);
+	}
+}
+
+// Decode one character from UTF-16 and write it as UTF-8.
+// A lead surrogate is combined with the following unit, whatever that is, unless it is
+// the last unit in which case it is written by itself.
+template <bool bigEndian>
+void UTF8FromUTF16Character(const ubyte *&pRead, const ubyte *pEnd, ubyte *&pOut) noexcept {
+	unsigned int value = ReadUnit<bigEndian>(pRead);
+	pRead += 2;
+	if (IsLeadSurrogate(value) && (pRead < pEnd)) {
+		value = (((value & 0x3ff) << 10) | (ReadUnit<bigEndian>(pRead) & 0x3ff)) + SURROGATE_FIRST_VALUE;
+		pRead += 2;
+	}
+	if (value < 0x80) {
+		*pOut++ = static_cast<ubyte>(value);
+	} else if (value < 0x800) {
+		*pOut++ = static_cast<ubyte>(0xC0 | value >> 6);
+		*pOut++ = static_cast<ubyte>(0x80 | (value & 0x3F));
+	} else if (value < SURROGATE_FIRST_VALUE) {
+		*pOut++ = static_cast<ubyte>(0xE0 | value >> 12);
+		*pOut++ = static_cast<ubyte>(0x80 | ((value >> 6) & 0x3F));
+		*pOut++ = static_cast<ubyte>(0x80 | (value & 0x3F));
+	} else {
+		*pOut++ = static_cast<ubyte>(0xF0 | value >> 18);
+		*pOut++ = static_cast<ubyte>(0x80 | ((value >> 12) & 0x3F));
+		*pOut++ = static_cast<ubyte>(0x80 | ((value >> 6) & 0x3F));
+		*pOut++ = static_cast<ubyte>(0x80 | (value & 0x3F));
+	}
+}
+
+// Decode one character from UTF-8 and write it as UTF-16.
+// Trail bytes are not checked, a trail byte without a lead byte is written as its value
+// and an incomplete character at the end is dropped.
+template <bool bigEndian>
+void UTF16FromUTF8Character(const ubyte *&pRead, const ubyte *pEnd, ubyte *&pOut) noexcept {
+	const ubyte lead = *pRead++;
+	unsigned int value;
+	int trailBytes;
+	if ((lead & 0xF0) == 0xF0) {
+		value = lead & 0x7;
+		trailBytes = 3;
+	} else if ((lead & 0xE0) == 0xE0) {
+		value = lead & 0x1F;
+		trailBytes = 2;
+	} else if ((lead & 0xC0) == 0xC0) {
+		value = lead & 0x3F;
+		trailBytes = 1;
+	} else {
+		WriteUnit<bigEndian>(pOut, lead);
+		return;
+	}
+	if (pEnd - pRead < trailBytes) {
+		pRead = pEnd;
+		return;
+	}
+	for (int trail = 0; trail < trailBytes; trail++) {
+		value = (value << 6) | (*pRead++ & 0x3F);
+	}
+	if (value >= SURROGATE_FIRST_VALUE) {
+		value -= SURROGATE_FIRST_VALUE;
+		WriteUnit<bigEndian>(pOut, ((value >> 10) + SURROGATE_LEAD_FIRST) & 0xFFFF);
+		WriteUnit<bigEndian>(pOut, (value & 0x3ff) + SURROGATE_TRAIL_FIRST);
+	} else {
+		WriteUnit<bigEndian>(pOut, value);
+	}
+}
+
+template <bool bigEndian>
+ubyte *UTF8FromUTF16Scalar(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut) noexcept {
+	while (pRead < pEnd) {
+		UTF8FromUTF16Character<bigEndian>(pRead, pEnd, pOut);
+	}
+	return pOut;
+}
+
+template <bool bigEndian>
+ubyte *UTF16FromUTF8Scalar(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut) noexcept {
+	while (pRead < pEnd) {
+		UTF16FromUTF8Character<bigEndian>(pRead, pEnd, pOut);
+	}
+	return pOut;
+}
+
+#if defined(UTF8_16_SIMD)
+
+// The vector versions copy blocks of ASCII text directly and leave everything else,
+// including surrogates, to the scalar code so results are identical.
+// SSE2 is always available on x64 while AVX2 is used when the processor supports it.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+bool HasAVX2() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7)
+		return false;
+	__cpuid(info, 1);
+	const bool osSavesAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+		((_xgetbv(0) & 6) == 6);
+	__cpuidex(info, 7, 0);
+	return osSavesAVX && (info[1] & (1 << 5));
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+const bool useAVX2 = HasAVX2();
+
+template <bool bigEndian>
+ubyte *UTF8FromUTF16SSE2(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut) noexcept {
+	// Big endian units are loaded with their bytes swapped
+	const __m128i nonASCII = _mm_set1_epi16(bigEndian ? static_cast<short>(0x80FF) : static_cast<short>(0xFF80));
+	const __m128i zero = _mm_setzero_si128();
+	while (pEnd - pRead >= 32) {
+		__m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pRead));
+		__m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pRead + 16));
+		const __m128i high = _mm_and_si128(_mm_or_si128(first, second), nonASCII);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, zero)) == 0xFFFF) {
+			if (bigEndian) {
+				first = _mm_srli_epi16(first, 8);
+				second = _mm_srli_epi16(second, 8);
+			}
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut), _mm_packus_epi16(first, second));
+			pRead += 32;
+			pOut += 16;
+		} else {
+			const ubyte *pBlockEnd = pRead + 32;
+			while (pRead < pBlockEnd) {
+				UTF8FromUTF16Character<bigEndian>(pRead, pEnd, pOut);
+			}
+		}
+	}
+	return UTF8FromUTF16Scalar<bigEndian>(pRead, pEnd, pOut);
+}
+
+template <bool bigEndian>
+TARGET_AVX2 ubyte *UTF8FromUTF16AVX2(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut) noexcept {
+	const __m256i nonASCII = _mm256_set1_epi16(bigEndian ? static_cast<short>(0x80FF) : static_cast<short>(0xFF80));
+	while (pEnd - pRead >= 64) {
+		__m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pRead));
+		__m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pRead + 32));
+		if (_mm256_testz_si256(_mm256_or_si256(first, second), nonASCII)) {
+			if (bigEndian) {
+				first = _mm256_srli_epi16(first, 8);
+				second = _mm256_srli_epi16(second, 8);
+			}
+			// Packing works within each 128 bit lane so reorder the 64 bit quarters
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(pOut), packed);
+			pRead += 64;
+			pOut += 32;
+		} else {
+			const ubyte *pBlockEnd = pRead + 64;
+			while (pRead < pBlockEnd) {
+				UTF8FromUTF16Character<bigEndian>(pRead, pEnd, pOut);
+			}
+		}
+	}
+	return UTF8FromUTF16SSE2<bigEndian>(pRead, pEnd, pOut);
+}
+
+template <bool bigEndian>
+ubyte *UTF16FromUTF8SSE2(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut) noexcept {
+	const __m128i zero = _mm_setzero_si128();
+	while (pEnd - pRead >= 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pRead));
+		if (_mm_movemask_epi8(bytes) == 0) {
+			const __m128i first = bigEndian ? _mm_unpacklo_epi8(zero, bytes) : _mm_unpacklo_epi8(bytes, zero);
+			const __m128i second = bigEndian ? _mm_unpackhi_epi8(zero, bytes) : _mm_unpackhi_epi8(bytes, zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut), first);
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + 16), second);
+			pRead += 16;
+			pOut += 32;
+		} else {
+			const ubyte *pBlockEnd = pRead + 16;
+			while (pRead < pBlockEnd) {
+				UTF16FromUTF8Character<bigEndian>(pRead, pEnd, pOut);
+			}
+		}
+	}
+	return UTF16FromUTF8Scalar<bigEndian>(pRead, pEnd, pOut);
+}
+
+template <bool bigEndian>
+TARGET_AVX2 ubyte *UTF16FromUTF8AVX2(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut) noexcept {
+	while (pEnd - pRead >= 32) {
+		const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pRead));
+		if (_mm256_movemask_epi8(bytes) == 0) {
+			__m256i first = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes));
+			__m256i second = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1));
+			if (bigEndian) {
+				first = _mm256_slli_epi16(first, 8);
+				second = _mm256_slli_epi16(second, 8);
+			}
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(pOut), first);
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(pOut + 32), second);
+			pRead += 32;
+			pOut += 64;
+		} else {
+			const ubyte *pBlockEnd = pRead + 32;
+			while (pRead < pBlockEnd) {
+				UTF16FromUTF8Character<bigEndian>(pRead, pEnd, pOut);
+			}
+		}
+	}
+	return UTF16FromUTF8SSE2<bigEndian>(pRead, pEnd, pOut);
+}
+
+const ubyte *SkipPlainASCIISSE2(const ubyte *pRead, const ubyte *pEnd) noexcept {
+	const __m128i zero = _mm_setzero_si128();
+	while (pEnd - pRead >= 16) {
+		const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pRead));
+		if (_mm_movemask_epi8(_mm_or_si128(bytes, _mm_cmpeq_epi8(bytes, zero))) != 0)
+			break;
+		pRead += 16;
+	}
+	return pRead;
+}
+
+TARGET_AVX2 const ubyte *SkipPlainASCIIAVX2(const ubyte *pRead, const ubyte *pEnd) noexcept {
+	const __m256i zero = _mm256_setzero_si256();
+	while (pEnd - pRead >= 32) {
+		const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pRead));
+		if (_mm256_movemask_epi8(_mm256_or_si256(bytes, _mm256_cmpeq_epi8(bytes, zero))) != 0)
+			break;
+		pRead += 32;
+	}
+	return SkipPlainASCIISSE2(pRead, pEnd);
+}
+
+#endif
+
+// Convert the UTF-16 from pRead to pEnd, which must be a whole number of units, to UTF-8.
+// Returns the end of the output.
+ubyte *UTF8FromUTF16(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut, bool bigEndian) noexcept {
+#if defined(UTF8_16_SIMD)
+	if (useAVX2) {
+		return bigEndian ? UTF8FromUTF16AVX2<true>(pRead, pEnd, pOut) :
+			UTF8FromUTF16AVX2<false>(pRead, pEnd, pOut);
+	}
+	return bigEndian ? UTF8FromUTF16SSE2<true>(pRead, pEnd, pOut) :
+		UTF8FromUTF16SSE2<false>(pRead, pEnd, pOut);
+#else
+	return bigEndian ? UTF8FromUTF16Scalar<true>(pRead, pEnd, pOut) :
+		UTF8FromUTF16Scalar<false>(pRead, pEnd, pOut);
+#endif
+}
+
+// Convert the UTF-8 from pRead to pEnd to UTF-16. Returns the end of the output.
+ubyte *UTF16FromUTF8(const ubyte *pRead, const ubyte *pEnd, ubyte *pOut, bool bigEndian) noexcept {
+#if defined(UTF8_16_SIMD)
+	if (useAVX2) {
+		return bigEndian ? UTF16FromUTF8AVX2<true>(pRead, pEnd, pOut) :
+			UTF16FromUTF8AVX2<false>(pRead, pEnd, pOut);
+	}
+	return bigEndian ? UTF16FromUTF8SSE2<true>(pRead, pEnd, pOut) :
+		UTF16FromUTF8SSE2<false>(pRead, pEnd, pOut);
+#else
+	return bigEndian ? UTF16FromUTF8Scalar<true>(pRead, pEnd, pOut) :
+		UTF16FromUTF8Scalar<false>(pRead, pEnd, pOut);
+#endif
+}
+
+// Returns the first byte from pRead that is NUL or not ASCII or pEnd.
+const ubyte *SkipPlainASCII(const ubyte *pRead, const ubyte *pEnd) noexcept {
+	if ((pRead < pEnd) && ((*pRead == 0) || (*pRead >= 0x80)))
+		return pRead;
+#if defined(UTF8_16_SIMD)
+	pRead = useAVX2 ? SkipPlainASCIIAVX2(pRead, pEnd) : SkipPlainASCIISSE2(pRead, pEnd);
+#endif
+	while ((pRead < pEnd) && (*pRead > 0) && (*pRead < 0x80)) {
+		pRead++;
+	}
+	return pRead;
+}
+
+}
+
+// ==================================================================
+
+Utf8_16_Detect::Utf8_16_Detect() {
+	m_bNonAscii = false;
+	m_bInvalid = false;
+	m_bNul = false;
+	m_nTrail = 0;
+	m_trailLow = 0x80;
+	m_trailHigh = 0xBF;
+}
+
+Utf8_16::encodingType Utf8_16_Detect::detectUtf16(const ubyte* pBuf, size_t nLen) {
+	// Text mostly in the ASCII range has a NUL in one byte of most units and rarely in the other
+	const size_t nUnits = nLen / 2;
+	size_t nulFirst = 0;
+	size_t nulSecond = 0;
+	size_t nulBoth = 0;
+	for (size_t unit = 0; unit < nUnits; unit++) {
+		const bool first = pBuf[unit * 2] == 0;
+		const bool second = pBuf[unit * 2 + 1] == 0;
+		if (first && second)
+			nulBoth++;
+		else if (first)
+			nulFirst++;
+		else if (second)
+			nulSecond++;
+	}
+	if ((nUnits < 2) || (nulBoth * 16 >= nUnits))
+		return eUnknown;
+	if ((nulSecond * 2 >= nUnits) && (nulFirst * 16 < nUnits))
+		return eUtf16LittleEndian;
+	if ((nulFirst * 2 >= nUnits) && (nulSecond * 16 < nUnits))
+		return eUtf16BigEndian;
+	return eUnknown;
+}
+
+void Utf8_16_Detect::examine(const ubyte* pBuf, size_t nLen) {
+	const ubyte *pRead = pBuf;
+	const ubyte *pEnd = pBuf + nLen;
+	while (pRead < pEnd) {
+		if (m_bInvalid) {
+			// Only a NUL can change the result now
+			if (!m_bNul && memchr(pRead, 0, pEnd - pRead))
+				m_bNul = true;
+			return;
+		}
+		if (m_nTrail == 0) {
+			pRead = SkipPlainASCII(pRead, pEnd);
+			// Check whole characters here, leaving errors and any split by the block end to examineByte
+			while ((pEnd - pRead >= 4) && (*pRead >= 0xC2)) {
+				const ubyte lead = pRead[0];
+				if (lead <= 0xDF) {
+					if ((pRead[1] & 0xC0) != 0x80)
+						break;
+					pRead += 2;
+				} else if (lead <= 0xEF) {
+					const ubyte low = (lead == 0xE0) ? 0xA0 : 0x80;
+					const ubyte high = (lead == 0xED) ? 0x9F : 0xBF;
+					if ((pRead[1] < low) || (pRead[1] > high) || ((pRead[2] & 0xC0) != 0x80))
+						break;
+					pRead += 3;
+				} else {
+					break;
+				}
+				m_bNonAscii = true;
+				pRead = SkipPlainASCII(pRead, pEnd);
+			}
+			if (pRead == pEnd)
+				return;
+		}
+		examineByte(*pRead++);
+	}
+}
+
+// Validate UTF-8 strictly, rejecting overlong forms, surrogates and values over 0x10FFFF
+void Utf8_16_Detect::examineByte(ubyte ch) {
+	if (m_nTrail) {
+		if ((ch >= m_trailLow) && (ch <= m_trailHigh)) {
+			m_nTrail--;
+			m_trailLow = 0x80;
+			m_trailHigh = 0xBF;
+			return;
+		}
+		m_bInvalid = true;
+		m_nTrail = 0;
+	}
+	if (ch < 0x80) {
+		if (ch == 0)
+			m_bNul = true;
+		return;
+	}
+	m_bNonAscii = true;
+	m_trailLow = 0x80;
+	m_trailHigh = 0xBF;
+	if (ch >= 0xC2 && ch <= 0xDF) {
+		m_nTrail = 1;
+	} else if (ch >= 0xE0 && ch <= 0xEF) {
+		m_nTrail = 2;
+		if (ch == 0xE0)
+			m_trailLow = 0xA0;
+		else if (ch == 0xED)
+			m_trailHigh = 0x9F;
+	} else if (ch >= 0xF0 && ch <= 0xF4) {
+		m_nTrail = 3;
+		if (ch == 0xF0)
+			m_trailLow = 0x90;
+		else if (ch == 0xF4)
+			m_trailHigh = 0x8F;
+	} else {
+		m_bInvalid = true;
+	}
+}
+
+void Utf8_16_Detect::finish() {
+	// Incomplete character at end
+	if (m_nTrail) {
+		m_bInvalid = true;
+		m_nTrail = 0;
+	}
+}
+
+Utf8_16::contentType Utf8_16_Detect::getContent() const {
+	if (m_bNul)
+		return cBinary;
+	if (m_bInvalid)
+		return c8Bit;
+	return m_bNonAscii ? cUtf8 : cAscii;
+}
+
 // ==================================================================
 
 Utf8_16_Read::Utf8_16_Read() {
@@ -36,8 +482,10 @@ Utf8_16_Read::Utf8_16_Read() {
 	m_pNewBuf = nullptr;
 	m_bFirstRead = true;
 	m_nLen = 0;
+	m_bLeadSurrogate = false;
 	m_leadSurrogate[0] = 0;
 	m_leadSurrogate[1] = 0;
+	m_bDetect = false;
 }
 
 Utf8_16_Read::~Utf8_16_Read() {
@@ -59,6 +507,12 @@ size_t Utf8_16_Read::convert(char* buf, size_t len) {
 
 	if (m_eEncoding == eUnknown) {
 		// Do nothing, pass through
+		if (m_bDetect) {
+			if (m_pBuf)
+				m_detect.examine(m_pBuf, len);
+			else
+				m_detect.finish();
+		}
 		m_nBufSize = 0;
 		m_pNewBuf = m_pBuf;
 		return len;
@@ -79,29 +533,52 @@ size_t Utf8_16_Read::convert(char* buf, size_t len) {
 		m_nBufSize = newSize;
 	}
 
+	if (!m_pBuf && !m_bLeadSurrogate)
+		return 0;
+
+	const bool bigEndian = m_eEncoding == eUtf16BigEndian;
+	const ubyte *pRead = m_pBuf ? m_pBuf + nSkip : nullptr;
+	size_t lenRead = m_pBuf ? len - nSkip : 0;
 	ubyte* pCur = m_pNewBuf;
 
+	// Buffer ends with lead surrogate so cut off buffer and store
+	bool endsWithLead = false;
 	ubyte endSurrogate[2] = { 0, 0 };
-	ubyte *pbufPrependSurrogate = nullptr;
-	if (m_leadSurrogate[0]) {
-		pbufPrependSurrogate = new ubyte[len - nSkip + 2];
-		memcpy(pbufPrependSurrogate, m_leadSurrogate, 2);
-		if (m_pBuf)
-			memcpy(pbufPrependSurrogate + 2, m_pBuf + nSkip, len - nSkip);
-		m_Iter16.set(pbufPrependSurrogate, len - nSkip + 2, m_eEncoding, endSurrogate);
-	}
-	else {
-		if (!m_pBuf)
-			return 0;
-		m_Iter16.set(m_pBuf + nSkip, len - nSkip, m_eEncoding, endSurrogate);
+	if ((lenRead >= 2) && (lenRead % 2 == 0) && (m_bLeadSurrogate || (lenRead > 2))) {
+		const unsigned int lastElement = bigEndian ?
+			ReadUnit<true>(pRead + lenRead - 2) : ReadUnit<false>(pRead + lenRead - 2);
+		if (IsLeadSurrogate(lastElement)) {
+			endSurrogate[0] = pRead[lenRead - 2];
+			endSurrogate[1] = pRead[lenRead - 1];
+			endsWithLead = true;
+			lenRead -= 2;
+		}
 	}
 
-	for (; m_Iter16; ++m_Iter16) {
-		*pCur++ = m_Iter16.get();
+	if (m_bLeadSurrogate) {
+		// Complete the character started at the end of the previous block
+		ubyte pair[4] = { m_leadSurrogate[0], m_leadSurrogate[1], 0, 0 };
+		size_t lenPair = 2;
+		if (lenRead >= 2) {
+			pair[2] = pRead[0];
+			pair[3] = pRead[1];
+			lenPair = 4;
+			pRead += 2;
+			lenRead -= 2;
+		}
+		pCur = UTF8FromUTF16(pair, pair + lenPair, pCur, bigEndian);
 	}
 
-	delete []pbufPrependSurrogate;
+	if (lenRead) {
+		pCur = UTF8FromUTF16(pRead, pRead + lenRead - lenRead % 2, pCur, bigEndian);
+		if (lenRead % 2) {
+			// Odd length so file is truncated: treat final byte as a unit with its other byte 0
+			const ubyte lastByte[2] = { pRead[lenRead - 1], 0 };
+			pCur = UTF8FromUTF16(lastByte, lastByte + 2, pCur, bigEndian);
+		}
+	}
 
+	m_bLeadSurrogate = endsWithLead;
 	memcpy(m_leadSurrogate, endSurrogate, 2);
 
 	// Return number of bytes written out
@@ -126,6 +603,10 @@ int Utf8_16_Read::determineEncoding() {
 		}
 	}
 
+	if ((m_eEncoding == eUnknown) && m_bDetect) {
+		m_eEncoding = Utf8_16_Detect::detectUtf16(m_pBuf, m_nLen);
+	}
+
 	return nRet;
 }
 
@@ -151,11 +632,6 @@ void Utf8_16_Write::setfile(FILE *pFile) {
 	m_bFirstWrite = true;
 }
 
-// Swap the two low order bytes of an integer value
-static int swapped(int v) {
-	return ((v & 0xFF) << 8) + (v >> 8);
-}
-
 size_t Utf8_16_Write::fwrite(const void* p, size_t _size) {
 	if (!m_pFile) {
 		return 0; // fail
@@ -188,32 +664,11 @@ size_t Utf8_16_Write::fwrite(const void* p, size_t _size) {
 		m_bFirstWrite = false;
 	}
 
-	Utf8_Iter iter8;
-	iter8.set(static_cast<const ubyte*>(p), _size, m_eEncoding);
-
-	utf16* pCur = m_pBuf;
-
-	for (; iter8; ++iter8) {
-		if (iter8.canGet()) {
-			int codePoint = iter8.get();
-			if (codePoint >= SURROGATE_FIRST_VALUE) {
-				codePoint -= SURROGATE_FIRST_VALUE;
-				const int lead = (codePoint >> 10) + SURROGATE_LEAD_FIRST;
-				*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
-					swapped(lead) : lead);
-				const int trail = (codePoint & 0x3ff) + SURROGATE_TRAIL_FIRST;
-				*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
-					swapped(trail) : trail);
-			} else {
-				*pCur++ = static_cast<utf16>((m_eEncoding == eUtf16BigEndian) ?
-					swapped(codePoint) : codePoint);
-			}
-		}
-	}
+	const ubyte *pRead = static_cast<const ubyte*>(p);
+	ubyte *pStart = reinterpret_cast<ubyte*>(m_pBuf);
+	const ubyte *pCur = UTF16FromUTF8(pRead, pRead + _size, pStart, m_eEncoding == eUtf16BigEndian);
 
-	const size_t ret = ::fwrite(m_pBuf,
-		reinterpret_cast<const char*>(pCur) - reinterpret_cast<const char*>(m_pBuf),
-		1, m_pFile);
+	const size_t ret = ::fwrite(m_pBuf, pCur - pStart, 1, m_pFile);
 
 	return ret;
 }
@@ -232,172 +687,3 @@ void Utf8_16_Write::setEncoding(Utf8_16::encodingType eType) {
 	m_eEncoding = eType;
 }
 
-//=================================================================
-Utf8_Iter::Utf8_Iter() {
-	reset();
-}
-
-void Utf8_Iter::reset() {
-	m_pBuf = nullptr;
-	m_pRead = nullptr;
-	m_pEnd = nullptr;
-	m_eState = eStart;
-	m_nCur = 0;
-	m_eEncoding = eUnknown;
-}
-
-void Utf8_Iter::set
-	(const ubyte* pBuf, size_t nLen, encodingType eEncoding) {
-	m_pBuf = pBuf;
-	m_pRead = pBuf;
-	m_pEnd = pBuf + nLen;
-	m_eEncoding = eEncoding;
-	operator++();
-	// Note: m_eState, m_nCur not reset
-}
-// Go to the next byte.
-void Utf8_Iter::operator++() {
-	switch (m_eState) {
-	case eStart:
-		if ((0xF0 & *m_pRead) == 0xF0) {
-			m_nCur = (0x7 & *m_pRead) << 18;
-			m_eState = eSecondOf4Bytes;
-		} else if ((0xE0 & *m_pRead) == 0xE0) {
-			m_nCur = (~0xE0 & *m_pRead) << 12;
-			m_eState = ePenultimate;
-		} else if ((0xC0 & *m_pRead) == 0xC0) {
-			m_nCur = (~0xC0 & *m_pRead) << 6;
-			m_eState = eFinal;
-		} else {
-			m_nCur = *m_pRead;
-			toStart();
-		}
-		break;
-	case eSecondOf4Bytes:
-		m_nCur |= (0x3F & *m_pRead) << 12;
-		m_eState = ePenultimate;
-		break;
-	case ePenultimate:
-		m_nCur |= (0x3F & *m_pRead) << 6;
-		m_eState = eFinal;
-		break;
-	case eFinal:
-		m_nCur |= static_cast<utf8>(0x3F & *m_pRead);
-		toStart();
-		break;
-	}
-	++m_pRead;
-}
-
-void Utf8_Iter::toStart() {
-	m_eState = eStart;
-}
-
-//==================================================
-Utf16_Iter::Utf16_Iter() {
-	reset();
-}
-
-void Utf16_Iter::reset() {
-	m_pBuf = nullptr;
-	m_pRead = nullptr;
-	m_pEnd = nullptr;
-	m_eState = eStart;
-	m_nCur = 0;
-	m_nCur16 = 0;
-	m_eEncoding = eUnknown;
-}
-
-void Utf16_Iter::set
-	(const ubyte* pBuf, size_t nLen, encodingType eEncoding, ubyte *endSurrogate) {
-	m_pBuf = pBuf;
-	m_pRead = pBuf;
-	m_pEnd = pBuf + nLen;
-	m_eEncoding = eEncoding;
-	if (nLen > 2) {
-		const utf16 lastElement = read(m_pEnd-2);
-		if (lastElement >= SURROGATE_LEAD_FIRST && lastElement <= SURROGATE_LEAD_LAST) {
-			// Buffer ends with lead surrogate so cut off buffer and store
-			endSurrogate[0] = m_pEnd[-2];
-			endSurrogate[1] = m_pEnd[-1];
-			m_pEnd -= 2;
-		}
-	}
-	operator++();
-	// Note: m_eState, m_nCur, m_nCur16 not reinitialized.
-}
-
-// Goes to the next byte.
-// Not the next symbol which you might expect.
-// This way we can continue from a partial buffer that doesn't align
-void Utf16_Iter::operator++() {
-	switch (m_eState) {
-	case eStart:
-		if (m_pRead >= m_pEnd) {
-			++m_pRead;
-			break;
-		}
-		if (m_eEncoding == eUtf16LittleEndian) {
-			m_nCur16 = *m_pRead++;
-			m_nCur16 |= static_cast<utf16>(*m_pRead << 8);
-		} else {
-			m_nCur16 = static_cast<utf16>(*m_pRead++ << 8);
-			m_nCur16 |= *m_pRead;
-		}
-		if (m_nCur16 >= SURROGATE_LEAD_FIRST && m_nCur16 <= SURROGATE_LEAD_LAST) {
-			++m_pRead;
-			if (m_pRead >= m_pEnd) {
-				// Have a lead surrogate at end of document with no access to trail surrogate.
-				// May be end of document.
-				--m_pRead;	// With next increment, leave pointer just past buffer
-			} else {
-				int trail;
-				if (m_eEncoding == eUtf16LittleEndian) {
-					trail = *m_pRead++;
-					trail |= static_cast<utf16>(*m_pRead << 8);
-				}
-				else {
-					trail = static_cast<utf16>(*m_pRead++ << 8);
-					trail |= *m_pRead;
-				}
-				m_nCur16 = (((m_nCur16 & 0x3ff) << 10) | (trail & 0x3ff)) + SURROGATE_FIRST_VALUE;
-			}
-		}
-		++m_pRead;
-
-		if (m_nCur16 < 0x80) {
-			m_nCur = static_cast<ubyte>(m_nCur16 & 0xFF);
-			m_eState = eStart;
-		} else if (m_nCur16 < 0x800) {
-			m_nCur = static_cast<ubyte>(0xC0 | m_nCur16 >> 6);
-			m_eState = eFinal;
-		} else if (m_nCur16 < SURROGATE_FIRST_VALUE) {
-			m_nCur = static_cast<ubyte>(0xE0 | m_nCur16 >> 12);
-			m_eState = ePenultimate;
-		} else {
-			m_nCur = static_cast<ubyte>(0xF0 | m_nCur16 >> 18);
-			m_eState = eSecondOf4Bytes;
-		}
-		break;
-	case eSecondOf4Bytes:
-		m_nCur = static_cast<ubyte>(0x80 | ((m_nCur16 >> 12) & 0x3F));
-		m_eState = ePenultimate;
-		break;
-	case ePenultimate:
-		m_nCur = static_cast<ubyte>(0x80 | ((m_nCur16 >> 6) & 0x3F));
-		m_eState = eFinal;
-		break;
-	case eFinal:
-		m_nCur = static_cast<ubyte>(0x80 | (m_nCur16 & 0x3F));
-		m_eState = eStart;
-		break;
-	}
-}
-
-Utf8_16::utf16 Utf16_Iter::read(const ubyte* pRead) const {
-	if (m_eEncoding == eUtf16LittleEndian) {
-		return pRead[0] | static_cast<utf16>(pRead[1] << 8);
-	} else {
-		return pRead[1] | static_cast<utf16>(pRead[0] << 8);
-	}
-}
@@ -12,8 +12,6 @@
 //   http://www.cl.cam.ac.uk/~mgk25/unicode.html
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <cassert>
-
 class Utf8_16 {
 public:
 	typedef unsigned short utf16; // 16 bits
@@ -26,70 +24,35 @@ public:
 	    eUtf8,
 	    eLast
 	};
+	enum contentType {
+	    cAscii,
+	    cUtf8,
+	    c8Bit,	// Not valid UTF-8 so in some other encoding
+	    cBinary	// Contains NUL bytes
+	};
 	static const utf8 k_Boms[eLast][3];
 };
 
-// Reads UTF-16 and outputs UTF-8
-class Utf16_Iter : public Utf8_16 {
+// Examines text without a BOM as it is read to find what it contains
+class Utf8_16_Detect : public Utf8_16 {
 public:
-	Utf16_Iter();
-	void reset();
-	void set(const ubyte* pBuf, size_t nLen, encodingType eEncoding, ubyte *endSurrogate);
-	utf8 get() const {
-		return m_nCur;
-	}
-	void operator++();
-	operator bool() const { return m_pRead <= m_pEnd; }
-	utf16 read(const ubyte* pRead) const;
+	Utf8_16_Detect();
 
-protected:
-	enum eState {
-	    eStart,
-	    eSecondOf4Bytes,
-	    ePenultimate,
-	    eFinal
-	};
-protected:
-	encodingType m_eEncoding;
-	eState m_eState;
-	utf8 m_nCur;
-	int m_nCur16;
-	const ubyte* m_pBuf;
-	const ubyte* m_pRead;
-	const ubyte* m_pEnd;
-};
+	// Recognise UTF-16 without a BOM by the positions of NUL bytes
+	static encodingType detectUtf16(const ubyte* pBuf, size_t nLen);
 
-// Reads UTF-8 and outputs UTF-16
-class Utf8_Iter : public Utf8_16 {
-public:
-	Utf8_Iter();
-	void reset();
-	void set(const ubyte* pBuf, size_t nLen, encodingType eEncoding);
-	int get() const {
-#ifdef _DEBUG
-		assert(m_eState == eStart);
-#endif
-		return m_nCur;
-	}
-	bool canGet() const { return m_eState == eStart; }
-	void operator++();
-	operator bool() const { return m_pRead <= m_pEnd; }
+	void examine(const ubyte* pBuf, size_t nLen);
+	void finish();
+	contentType getContent() const;
+private:
+	void examineByte(ubyte ch);
 
-protected:
-	void toStart(); // Put to start state
-	enum eState {
-	    eStart,
-	    eSecondOf4Bytes,
-	    ePenultimate,
-	    eFinal
-	};
-protected:
-	encodingType m_eEncoding;
-	eState m_eState;
-	int m_nCur;
-	const ubyte* m_pBuf;
-	const ubyte* m_pRead;
-	const ubyte* m_pEnd;
+	bool m_bNonAscii;
+	bool m_bInvalid;
+	bool m_bNul;
+	int m_nTrail;	// Trail bytes still expected
+	ubyte m_trailLow;	// Range allowed for next trail byte
+	ubyte m_trailHigh;
 };
 
 // Reads UTF16 and outputs UTF8
@@ -102,6 +65,10 @@ public:
 	char* getNewBuf() { return reinterpret_cast<char*>(m_pNewBuf); }
 
 	encodingType getEncoding() const { return m_eEncoding; }
+
+	// Also recognise UTF-16 without a BOM and examine 8 bit text
+	void setDetect(bool bDetect) { m_bDetect = bDetect; }
+	contentType getContent() const { return m_detect.getContent(); }
 protected:
 	int determineEncoding();
 private:
@@ -110,9 +77,11 @@ private:
 	ubyte* m_pNewBuf;
 	size_t m_nBufSize;
 	bool m_bFirstRead;
+	bool m_bLeadSurrogate;	// A lead surrogate ended the previous block
 	ubyte m_leadSurrogate[2];
 	size_t m_nLen;
-	Utf16_Iter m_Iter16;
+	bool m_bDetect;
+	Utf8_16_Detect m_detect;
 };
 
 // Read in a UTF-8 buffer and write out to UTF-16 or UTF-8
@@ -224,6 +224,10 @@ bool DirectorExtension::NeedsOnClose() {
 	return HasConnection();
 }
 
+const char *DirectorExtension::Name() const {
+	return "Director";
+}
+
 bool DirectorExtension::OnChar(char) {
 	return false;
 }
@@ -38,6 +38,7 @@ public:
 	bool SendProperty(const char *prop) override;
 	bool OnClose(const char *path) override;
 	bool NeedsOnClose() override;
+	const char *Name() const override;
 
 	// Allow messages through to extension
 	void HandleStringMessage(const char *message);
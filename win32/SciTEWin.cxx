@@ -818,10 +818,10 @@ DWORD SciTEWin::ExecuteOne(const Job &jobToRun) {
 			const char *findText = findFiles + strlen(findFiles) + 1;
 			if (cmdWorker.outputScroll == 1)
 				gf = static_cast<GrepFlags>(gf | grepScroll);
-			sptr_t positionEnd = wOutput.Send(SCI_GETCURRENTPOS);
+			sptr_t positionEnd = OutputOffsetFromPosition(wOutput.Send(SCI_GETCURRENTPOS));
 			InternalGrep(gf, jobToRun.directory.AsInternal(), GUI::StringFromUTF8(findFiles).c_str(), findText, positionEnd);
 			if ((gf & grepScroll) && returnOutputToCommand)
-				wOutput.Send(SCI_GOTOPOS, positionEnd, 0);
+				wOutput.Send(SCI_GOTOPOS, OutputPositionFromOffset(positionEnd), 0);
 		}
 		return exitcode;
 	}
@@ -1119,7 +1119,7 @@ void SciTEWin::ProcessExecute() {
 	// scroll and return only if output.scroll equals
 	// one in the properties file
 	if ((cmdWorker.outputScroll == 1) && returnOutputToCommand)
-		wOutput.Send(SCI_GOTOPOS, cmdWorker.originalEnd, 0);
+		wOutput.Send(SCI_GOTOPOS, OutputPositionFromOffset(cmdWorker.originalEnd), 0);
 	returnOutputToCommand = true;
 	PostOnMainThread(WORK_EXECUTE, &cmdWorker);
 }
@@ -1218,7 +1218,8 @@ void SciTEWin::Execute() {
 
 	cmdWorker.Initialise(false);
 	cmdWorker.outputScroll = props.GetInt("output.scroll", 1);
-	cmdWorker.originalEnd = wOutput.Call(SCI_GETTEXTLENGTH);
+	OutputFlush();
+	cmdWorker.originalEnd = OutputOffsetFromPosition(wOutput.Call(SCI_GETTEXTLENGTH));
 	cmdWorker.commandTime.Duration(true);
 	cmdWorker.flags = jobQueue.jobQueue[cmdWorker.icmd].flags;
 	if (scrollOutput)
@@ -123,7 +123,7 @@ class CommandWorker : public Worker {
 public:
 	SciTEWin *pSciTE;
 	int icmd;
-	int originalEnd;
+	sptr_t originalEnd;	///< Output offset at start of command
 	int exitStatus;
 	GUI::ElapsedTime commandTime;
 	std::string output;
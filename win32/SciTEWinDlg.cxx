@@ -388,8 +388,8 @@ void SciTEWin::LoadSessionDialog() {
 	ofn.lpstrTitle = translatedTitle.c_str();
 	ofn.Flags = OFN_HIDEREADONLY | OFN_NOCHANGEDIR;
 	if (::GetOpenFileNameW(&ofn)) {
-		LoadSessionFile(openName);
-		RestoreSession();
+		if (LoadSessionFile(openName))
+			RestoreSession();
 	} else {
 		CheckCommonDialogError();
 	}
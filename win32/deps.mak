@@ -344,6 +344,18 @@ FilePath.o: \
 	../src/GUI.h \
 	../src/ScintillaWindow.h \
 	../src/FilePath.h
+FileWatcher.o: \
+	../src/FileWatcher.cxx \
+	../../scintilla/include/ILoader.h \
+	../../scintilla/include/Sci_Position.h \
+	../../scintilla/include/Scintilla.h \
+	../src/GUI.h \
+	../src/FilePath.h \
+	../src/Mutex.h \
+	../src/Cookie.h \
+	../src/Worker.h \
+	../src/FileWorker.h \
+	../src/FileWatcher.h
 FileWorker.o: \
 	../src/FileWorker.cxx \
 	../../scintilla/include/ILoader.h \
@@ -373,14 +385,19 @@ JobQueue.o: \
 	../src/JobQueue.h
 LuaExtension.o: \
 	../src/LuaExtension.cxx \
-	../../scintilla/include/Scintilla.h \
+	../../scintilla/include/ILoader.h \
 	../../scintilla/include/Sci_Position.h \
+	../../scintilla/include/Scintilla.h \
 	../src/GUI.h \
 	../src/ScintillaWindow.h \
 	../src/StringHelpers.h \
 	../src/FilePath.h \
 	../src/StyleWriter.h \
 	../src/Extender.h \
+	../src/Mutex.h \
+	../src/Cookie.h \
+	../src/Worker.h \
+	../src/FileWorker.h \
 	../src/IFaceTable.h \
 	../src/SciTEKeys.h \
 	../src/LuaExtension.h \
@@ -401,6 +418,8 @@ MultiplexExtension.o: \
 	../../scintilla/include/Scintilla.h \
 	../../scintilla/include/Sci_Position.h \
 	../src/GUI.h \
+	../src/StringHelpers.h \
+	../src/FilePath.h \
 	../src/MultiplexExtension.h \
 	../src/Extender.h
 PropSetFile.o: \
@@ -438,6 +457,7 @@ SciTEBase.o: \
 	../src/Cookie.h \
 	../src/Worker.h \
 	../src/FileWorker.h \
+	../src/FileWatcher.h \
 	../src/MatchMarker.h \
 	../src/EditorConfig.h \
 	../src/SciTEBase.h
@@ -484,7 +504,9 @@ SciTEIO.o: \
 	../src/Cookie.h \
 	../src/Worker.h \
 	../src/FileWorker.h \
+	../src/FileWatcher.h \
 	../src/MatchMarker.h \
+	../src/EditorConfig.h \
 	../src/SciTEBase.h \
 	../src/Utf8_16.h
 SciTEProps.o: \
@@ -68,6 +68,7 @@ SHAREDOBJS=\
 	ExportTEX.obj \
 	ExportXML.obj \
 	FilePath.obj \
+	FileWatcher.obj \
 	FileWorker.obj \
 	GUIWin.obj \
 	IFaceTable.obj \